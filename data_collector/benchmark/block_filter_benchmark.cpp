@@ -0,0 +1,297 @@
+/* Host benchmark of the push_samples() block kernels against push_sample() per sample
+    Each filter runs the same accelerometer like input one sample at a time and in blocks of
+    SEISMOMETER_SAMPLE_HANDLER_BATCH_SIZE, as src/sample_handler.cpp does.  The outputs are checked for equality first.
+    The FIR filters use the 100Hz acceleration coefficients with the DC blocker of SEISMOMETER_FILTER_DC_BLOCKER_SHIFT,
+    the banks filter four channels as for acceleration X/Y/Z/M and two as for the pendulum 10x/100x.  The resampler is the 500Hz to 100Hz pendulum
+    decimator, the biquad the 100Hz Butterworth low pass and the median the despike window.
+
+    Build and run from data_collector:
+      g++ -O2 -std=gnu++17 -Iinc -o block_filter_benchmark benchmark/block_filter_benchmark.cpp src/fir_polyphase.cpp src/biquad_filter.cpp src/median_filter.cpp && ./block_filter_benchmark
+
+    Host cycle counts only show the relative cost, on the RP2040 the per call overhead and the state reloaded from
+    memory on every sample weigh more. */
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCHMARK_CYCLES() __rdtsc()
+#else
+#define BENCHMARK_CYCLES() ((uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count())
+#endif
+
+#include "biquad_filter.hpp"
+#include "filter_coefficients.hpp"
+#include "fir_filter_bank.hpp"
+#include "fir_filter_static.hpp"
+#include "fir_polyphase.hpp"
+#include "median_filter.hpp"
+
+#define BENCHMARK_SAMPLES           1000000
+#define BENCHMARK_REPEATS           5
+#define BENCHMARK_BLOCK             32 /* SEISMOMETER_SAMPLE_HANDLER_BATCH_SIZE */
+#define BENCHMARK_CHANNELS          4
+#define BENCHMARK_PENDULUM_CHANNELS 2
+#define BENCHMARK_DC_BLOCKER        8  /* SEISMOMETER_FILTER_DC_BLOCKER_SHIFT */
+#define BENCHMARK_MEDIAN_WINDOW     5  /* SEISMOMETER_FILTER_MEDIAN_WINDOW */
+
+typedef fir_filter_static_c<FIR_HAMMING_LPF_100HZ_FS_10HZ_CUTOFF_ORDER, fir_hamming_lpf_100hz_fs_10hz_cutoff,
+                            FIR_HAMMING_LPF_100HZ_FS_10HZ_CUTOFF_GAIN_NUM, FIR_HAMMING_LPF_100HZ_FS_10HZ_CUTOFF_GAIN_DEN,
+                            0, BENCHMARK_DC_BLOCKER> static_filter_c;
+typedef fir_filter_bank_c<BENCHMARK_CHANNELS, FIR_HAMMING_LPF_100HZ_FS_10HZ_CUTOFF_ORDER, fir_hamming_lpf_100hz_fs_10hz_cutoff,
+                          FIR_HAMMING_LPF_100HZ_FS_10HZ_CUTOFF_GAIN_NUM, FIR_HAMMING_LPF_100HZ_FS_10HZ_CUTOFF_GAIN_DEN,
+                          0, BENCHMARK_DC_BLOCKER> bank_filter_c;
+typedef fir_filter_bank_c<BENCHMARK_PENDULUM_CHANNELS, FIR_HAMMING_LPF_100HZ_FS_10HZ_CUTOFF_ORDER, fir_hamming_lpf_100hz_fs_10hz_cutoff,
+                          FIR_HAMMING_LPF_100HZ_FS_10HZ_CUTOFF_GAIN_NUM, FIR_HAMMING_LPF_100HZ_FS_10HZ_CUTOFF_GAIN_DEN,
+                          0, BENCHMARK_DC_BLOCKER> pendulum_bank_filter_c;
+
+static const fir_filter_config_s biquad_filter_config
+{
+  .moving_average_order = 0,
+  .dc_blocker_shift     = BENCHMARK_DC_BLOCKER,
+  .gain_numerator   = 1,
+  .gain_denominator = 1,
+};
+
+static filter_sample_t samples[4096];
+
+/* Accelerometer like input, 1g offset with noise in mm/s^2 and a spike every 100 samples, each channel offset into
+   the same noise */
+static filter_sample_t sample_at(uint32_t i, uint32_t channel)
+{
+  return samples[(i + (channel*1024)) & 4095];
+}
+
+/* One instance of every filter, run either per sample or in blocks */
+typedef struct
+{
+  static_filter_c         static_filter;
+  bank_filter_c           bank;
+  pendulum_bank_filter_c  pendulum_bank;
+  fir_polyphase_c        *polyphase;
+  biquad_filter_c        *biquad;
+  median_filter_c        *median;
+} filters_s;
+
+static void filters_init(filters_s *filters)
+{
+  filters->polyphase = new fir_polyphase_c(FIR_HAMMING_LPF_DECIMATE_5_ORDER, fir_hamming_lpf_decimate_5, 1, 5,
+                                           FIR_HAMMING_LPF_DECIMATE_5_GAIN_NUM, FIR_HAMMING_LPF_DECIMATE_5_GAIN_DEN);
+  filters->biquad    = new biquad_filter_c(BIQUAD_BUTTERWORTH_LPF_100HZ_FS_10HZ_CUTOFF_SECTIONS, biquad_butterworth_lpf_100hz_fs_10hz_cutoff,
+                                           &biquad_filter_config);
+  filters->median    = new median_filter_c(BENCHMARK_MEDIAN_WINDOW);
+}
+
+typedef enum
+{
+  BENCHMARK_FILTER_STATIC,
+  BENCHMARK_FILTER_BANK,
+  BENCHMARK_FILTER_PENDULUM_BANK,
+  BENCHMARK_FILTER_POLYPHASE,
+  BENCHMARK_FILTER_BIQUAD,
+  BENCHMARK_FILTER_MEDIAN,
+  BENCHMARK_FILTER_MAX,
+} benchmark_filter_e;
+static const char *benchmark_filter_name[BENCHMARK_FILTER_MAX] = {"static", "bank", "bank 2ch", "polyphase", "biquad", "median"};
+
+/* Filters BENCHMARK_BLOCK samples from 'start' one sample at a time, writing the outputs of channel 0 to 'output' and
+   returning how many were written */
+static size_t push_per_sample(filters_s *filters, benchmark_filter_e filter, uint32_t start, filter_sample_t *output)
+{
+  size_t output_count = 0;
+  for(uint32_t i = start; i < (start+BENCHMARK_BLOCK); i++)
+  {
+    switch(filter)
+    {
+      case BENCHMARK_FILTER_STATIC:
+      {
+        filters->static_filter.push_sample(sample_at(i, 0));
+        output[output_count++] = filters->static_filter.get_filtered_sample_dc_offset_removed();
+        break;
+      }
+      case BENCHMARK_FILTER_BANK:
+      {
+        filter_sample_t sample[BENCHMARK_CHANNELS];
+        for(uint32_t channel = 0; channel < BENCHMARK_CHANNELS; channel++)
+        {
+          sample[channel] = sample_at(i, channel);
+        }
+        filters->bank.push_sample(sample);
+        output[output_count++] = filters->bank.get_filtered_sample_dc_offset_removed(0);
+        break;
+      }
+      case BENCHMARK_FILTER_PENDULUM_BANK:
+      {
+        filter_sample_t sample[BENCHMARK_PENDULUM_CHANNELS];
+        for(uint32_t channel = 0; channel < BENCHMARK_PENDULUM_CHANNELS; channel++)
+        {
+          sample[channel] = sample_at(i, channel);
+        }
+        filters->pendulum_bank.push_sample(sample);
+        output[output_count++] = filters->pendulum_bank.get_filtered_sample_dc_offset_removed(0);
+        break;
+      }
+      case BENCHMARK_FILTER_POLYPHASE:
+      {
+        output_count += filters->polyphase->push_sample(sample_at(i, 0), &output[output_count]);
+        break;
+      }
+      case BENCHMARK_FILTER_BIQUAD:
+      {
+        filters->biquad->push_sample(sample_at(i, 0));
+        output[output_count++] = filters->biquad->get_filtered_sample_dc_offset_removed();
+        break;
+      }
+      case BENCHMARK_FILTER_MEDIAN:
+      {
+        filters->median->push_sample(sample_at(i, 0));
+        output[output_count++] = filters->median->get_median();
+        break;
+      }
+      default:
+      {
+        break;
+      }
+    }
+  }
+  return output_count;
+}
+
+/* As push_per_sample() with one push_samples() call */
+static size_t push_block(filters_s *filters, benchmark_filter_e filter, uint32_t start, filter_sample_t *output)
+{
+  filter_sample_t sample[BENCHMARK_BLOCK][BENCHMARK_CHANNELS];
+  filter_sample_t pendulum_sample[BENCHMARK_BLOCK][BENCHMARK_PENDULUM_CHANNELS];
+  filter_sample_t channel_sample[BENCHMARK_BLOCK];
+  for(uint32_t i = 0; i < BENCHMARK_BLOCK; i++)
+  {
+    for(uint32_t channel = 0; channel < BENCHMARK_CHANNELS; channel++)
+    {
+      sample[i][channel] = sample_at(start+i, channel);
+    }
+    for(uint32_t channel = 0; channel < BENCHMARK_PENDULUM_CHANNELS; channel++)
+    {
+      pendulum_sample[i][channel] = sample_at(start+i, channel);
+    }
+    channel_sample[i] = sample[i][0];
+  }
+
+  size_t output_count = BENCHMARK_BLOCK;
+  switch(filter)
+  {
+    case BENCHMARK_FILTER_STATIC:
+    {
+      filters->static_filter.push_samples(channel_sample, BENCHMARK_BLOCK, output);
+      break;
+    }
+    case BENCHMARK_FILTER_BANK:
+    {
+      filters->bank.push_samples(sample, BENCHMARK_BLOCK, sample);
+      for(uint32_t i = 0; i < BENCHMARK_BLOCK; i++)
+      {
+        output[i] = sample[i][0];
+      }
+      break;
+    }
+    case BENCHMARK_FILTER_PENDULUM_BANK:
+    {
+      filters->pendulum_bank.push_samples(pendulum_sample, BENCHMARK_BLOCK, pendulum_sample);
+      for(uint32_t i = 0; i < BENCHMARK_BLOCK; i++)
+      {
+        output[i] = pendulum_sample[i][0];
+      }
+      break;
+    }
+    case BENCHMARK_FILTER_POLYPHASE:
+    {
+      output_count = filters->polyphase->push_samples(channel_sample, BENCHMARK_BLOCK, output);
+      break;
+    }
+    case BENCHMARK_FILTER_BIQUAD:
+    {
+      filters->biquad->push_samples(channel_sample, BENCHMARK_BLOCK, output);
+      break;
+    }
+    case BENCHMARK_FILTER_MEDIAN:
+    {
+      filters->median->push_samples(channel_sample, BENCHMARK_BLOCK, output);
+      break;
+    }
+    default:
+    {
+      break;
+    }
+  }
+  return output_count;
+}
+
+typedef size_t (*push_f)(filters_s *filters, benchmark_filter_e filter, uint32_t start, filter_sample_t *output);
+/* Returns the cycles per sample of one run */
+static double benchmark(filters_s *filters, benchmark_filter_e filter, push_f push)
+{
+  filter_sample_t output[BENCHMARK_BLOCK];
+  uint64_t start = BENCHMARK_CYCLES();
+  for(uint32_t i = 0; i < BENCHMARK_SAMPLES; i += BENCHMARK_BLOCK)
+  {
+    push(filters, filter, i, output);
+  }
+  uint64_t end = BENCHMARK_CYCLES();
+  return ((double)(end-start))/BENCHMARK_SAMPLES;
+}
+
+int main()
+{
+  srand(1);
+  for(uint32_t i = 0; i < 4096; i++)
+  {
+    samples[i] = 9807 + (rand() % 2001) - 1000 + (((i % 100) == 0) ? 20000 : 0);
+  }
+
+  static filters_s per_sample_filters;
+  static filters_s block_filters;
+  filters_init(&per_sample_filters);
+  filters_init(&block_filters);
+
+  /* Block and per sample outputs must agree, across several history wraps */
+  for(uint32_t filter = 0; filter < BENCHMARK_FILTER_MAX; filter++)
+  {
+    for(uint32_t i = 0; i < 20000; i += BENCHMARK_BLOCK)
+    {
+      filter_sample_t per_sample_output[BENCHMARK_BLOCK];
+      filter_sample_t block_output[BENCHMARK_BLOCK];
+      size_t per_sample_count = push_per_sample(&per_sample_filters, (benchmark_filter_e)filter, i, per_sample_output);
+      size_t block_count      = push_block     (&block_filters,      (benchmark_filter_e)filter, i, block_output);
+      if(per_sample_count != block_count)
+      {
+        printf("%s output count mismatch at sample %u: %zu %zu\n", benchmark_filter_name[filter], i, per_sample_count, block_count);
+        return 1;
+      }
+      for(size_t j = 0; j < block_count; j++)
+      {
+        if(per_sample_output[j] != block_output[j])
+        {
+          printf("%s mismatch at sample %u output %zu: %d %d\n", benchmark_filter_name[filter], i, j, per_sample_output[j], block_output[j]);
+          return 1;
+        }
+      }
+    }
+  }
+
+  for(uint32_t filter = 0; filter < BENCHMARK_FILTER_MAX; filter++)
+  {
+    /* Runs alternate and the fewest cycles are kept, the host is shared so the minimum is the most stable */
+    double per_sample_cycles = 0;
+    double block_cycles      = 0;
+    for(uint32_t repeat = 0; repeat < BENCHMARK_REPEATS; repeat++)
+    {
+      double cycles = benchmark(&per_sample_filters, (benchmark_filter_e)filter, push_per_sample);
+      per_sample_cycles = (((0 == repeat) || (cycles < per_sample_cycles)) ? cycles : per_sample_cycles);
+      cycles = benchmark(&block_filters, (benchmark_filter_e)filter, push_block);
+      block_cycles      = (((0 == repeat) || (cycles < block_cycles)) ? cycles : block_cycles);
+    }
+    printf("%-10s %8.1f cycles per sample, %8.1f per block sample, %.2fx\n", benchmark_filter_name[filter],
+           per_sample_cycles, block_cycles, per_sample_cycles/block_cycles);
+  }
+  return 0;
+}
\ No newline at end of file
@@ -0,0 +1,230 @@
+/* Host benchmark of fir_filter_c, fir_filter_static_c and fir_filter_bank_c
+    All filters use fir_hamming_lpf_100hz_fs_10hz_cutoff with the gain and 512 sample moving average of the
+    acceleration and pendulum filters in src/sample_handler.cpp.  Four channels are filtered, as for acceleration
+    X/Y/Z/M, with one filter per channel or one bank for all four.  The outputs are checked for equality first.
+    fir_filter_c::push_sample() mirrors src/fir_filter.cpp, which needs the Pico SDK for its debug and util headers.
+
+    Build and run from data_collector:
+      g++ -O2 -std=gnu++17 -Iinc -o fir_filter_benchmark benchmark/fir_filter_benchmark.cpp && ./fir_filter_benchmark
+
+    Host cycle counts only show the relative cost, the RP2040 has no multiply-accumulate instruction and a slower
+    memory system. */
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCHMARK_CYCLES() __rdtsc()
+#else
+#define BENCHMARK_CYCLES() ((uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count())
+#endif
+
+#include "filter_coefficients.hpp"
+#include "fir_filter.hpp"
+#include "fir_filter_bank.hpp"
+#include "fir_filter_static.hpp"
+
+#define BENCHMARK_SAMPLES        1000000
+#define BENCHMARK_MOVING_AVERAGE 512
+#define BENCHMARK_CHANNELS       4
+
+/* Runtime filter, src/fir_filter.cpp */
+fir_filter_c::fir_filter_c( filter_order_t order_init, const filter_coefficient_t *coefficient_init, const fir_filter_config_s *config_init)
+  : config(*config_init), order(order_init), coefficient(coefficient_init),
+    history_length((order_init > config_init->moving_average_order) ? order_init : config_init->moving_average_order)
+{
+  history    = (filter_sample_t*) calloc(sizeof(filter_sample_t), (2*history_length));
+  next_write = history_length;
+}
+fir_filter_c::~fir_filter_c()
+{
+  free(history);
+}
+
+/* Returns the filtered sample of 'window', oldest to newest sample */
+filter_sample_t fir_filter_c::filter(const filter_sample_t *window) const
+{
+  filter_sample_t sum = 0;
+  for(filter_order_t i = 0; i < order; i++)
+  {
+    sum += coefficient[i]*window[i];
+  }
+  sum *= config.gain_numerator;
+  sum /= config.gain_denominator;
+  return sum;
+}
+
+/* Updates the moving average (or DC blocker) with 'count' raw samples from the history, subtracting each estimate
+   from 'output'.  The state is held in locals over the block and written back once */
+void fir_filter_c::remove_dc_offset(const filter_sample_t *sample, size_t count, filter_sample_t *output)
+{
+  if(config.moving_average_order > 0)
+  {
+    /* The sample leaving the moving average is still in the history */
+    const filter_sample_t *leaving = (sample - config.moving_average_order);
+    filter_order_t  history_local  = moving_average_history;
+    filter_sample_t sum            = moving_average_sum;
+    filter_sample_t average        = moving_average;
+    for(size_t i = 0; i < count; i++)
+    {
+      sum -= leaving[i];
+      sum += sample[i];
+      if(history_local < config.moving_average_order)
+      {
+        history_local++;
+      }
+      average    = (sum/((filter_sample_t)history_local));
+      output[i] -= average;
+    }
+    moving_average_history = history_local;
+    moving_average_sum     = sum;
+    moving_average         = average;
+  }
+  else if(config.dc_blocker_shift > 0)
+  {
+    /* Start from the first sample instead of settling up from 0 */
+    if(!dc_blocker_seeded && (count > 0))
+    {
+      dc_blocker_state  = (sample[0] * (1 << config.dc_blocker_shift));
+      dc_blocker_seeded = true;
+    }
+    filter_sample_t state   = dc_blocker_state;
+    filter_sample_t average = moving_average;
+    for(size_t i = 0; i < count; i++)
+    {
+      state     += (sample[i] - (state >> config.dc_blocker_shift));
+      average    = (state >> config.dc_blocker_shift);
+      output[i] -= average;
+    }
+    dc_blocker_state = state;
+    moving_average   = average;
+  }
+}
+
+/* Moves the last history_length samples to the front once the history is full */
+void fir_filter_c::history_wrap()
+{
+  if((2*history_length) == next_write)
+  {
+    memcpy(&history[0], &history[history_length], (history_length*sizeof(filter_sample_t)));
+    next_write = history_length;
+  }
+}
+
+void fir_filter_c::push_sample(filter_sample_t sample)
+{
+  history[next_write++] = sample;
+  filtered_sample = filter(&history[next_write-order]);
+  filter_sample_t output = filtered_sample;
+  remove_dc_offset(&history[next_write-1], 1, &output);
+  history_wrap();
+}
+
+static const fir_filter_config_s runtime_filter_config
+{
+  .moving_average_order = BENCHMARK_MOVING_AVERAGE,
+  .dc_blocker_shift     = 0,
+  .gain_numerator   = FIR_HAMMING_LPF_100HZ_FS_10HZ_CUTOFF_GAIN_NUM,
+  .gain_denominator = FIR_HAMMING_LPF_100HZ_FS_10HZ_CUTOFF_GAIN_DEN,
+};
+typedef fir_filter_static_c<FIR_HAMMING_LPF_100HZ_FS_10HZ_CUTOFF_ORDER, fir_hamming_lpf_100hz_fs_10hz_cutoff,
+                            FIR_HAMMING_LPF_100HZ_FS_10HZ_CUTOFF_GAIN_NUM, FIR_HAMMING_LPF_100HZ_FS_10HZ_CUTOFF_GAIN_DEN,
+                            BENCHMARK_MOVING_AVERAGE> static_filter_c;
+typedef fir_filter_bank_c<BENCHMARK_CHANNELS, FIR_HAMMING_LPF_100HZ_FS_10HZ_CUTOFF_ORDER, fir_hamming_lpf_100hz_fs_10hz_cutoff,
+                          FIR_HAMMING_LPF_100HZ_FS_10HZ_CUTOFF_GAIN_NUM, FIR_HAMMING_LPF_100HZ_FS_10HZ_CUTOFF_GAIN_DEN,
+                          BENCHMARK_MOVING_AVERAGE> bank_filter_c;
+
+static filter_sample_t samples[4096];
+
+/* Accelerometer like input, 1g offset with noise in mm/s^2, each channel offset into the same noise */
+static filter_sample_t sample_at(uint32_t i, uint32_t channel)
+{
+  return samples[(i + (channel*1024)) & 4095];
+}
+
+typedef struct
+{
+  fir_filter_c *runtime[BENCHMARK_CHANNELS];
+  static_filter_c static_filter[BENCHMARK_CHANNELS];
+  bank_filter_c   bank;
+} filters_s;
+
+static void push_runtime(filters_s *filters, uint32_t i)
+{
+  for(uint32_t channel = 0; channel < BENCHMARK_CHANNELS; channel++)
+  {
+    filters->runtime[channel]->push_sample(sample_at(i, channel));
+  }
+}
+static void push_static(filters_s *filters, uint32_t i)
+{
+  for(uint32_t channel = 0; channel < BENCHMARK_CHANNELS; channel++)
+  {
+    filters->static_filter[channel].push_sample(sample_at(i, channel));
+  }
+}
+static void push_bank(filters_s *filters, uint32_t i)
+{
+  filter_sample_t sample[BENCHMARK_CHANNELS];
+  for(uint32_t channel = 0; channel < BENCHMARK_CHANNELS; channel++)
+  {
+    sample[channel] = sample_at(i, channel);
+  }
+  filters->bank.push_sample(sample);
+}
+
+typedef void (*push_f)(filters_s *filters, uint32_t i);
+static double benchmark(const char *name, filters_s *filters, push_f push)
+{
+  uint64_t start = BENCHMARK_CYCLES();
+  for(uint32_t i = 0; i < BENCHMARK_SAMPLES; i++)
+  {
+    push(filters, i);
+  }
+  uint64_t end = BENCHMARK_CYCLES();
+  double cycles = ((double)(end-start))/BENCHMARK_SAMPLES;
+  printf("%-8s %8.1f cycles per %u channel sample\n", name, cycles, BENCHMARK_CHANNELS);
+  return cycles;
+}
+
+int main()
+{
+  srand(1);
+  for(uint32_t i = 0; i < 4096; i++)
+  {
+    samples[i] = 9807 + (rand() % 2001) - 1000;
+  }
+
+  static filters_s filters;
+  for(uint32_t channel = 0; channel < BENCHMARK_CHANNELS; channel++)
+  {
+    filters.runtime[channel] = new fir_filter_c(FIR_HAMMING_LPF_100HZ_FS_10HZ_CUTOFF_ORDER, fir_hamming_lpf_100hz_fs_10hz_cutoff, &runtime_filter_config);
+  }
+
+  /* All filters must agree */
+  for(uint32_t i = 0; i < 20000; i++)
+  {
+    push_runtime(&filters, i);
+    push_static(&filters, i);
+    push_bank(&filters, i);
+    for(uint32_t channel = 0; channel < BENCHMARK_CHANNELS; channel++)
+    {
+      filter_sample_t runtime_sample = filters.runtime[channel]->get_filtered_sample_dc_offset_removed();
+      filter_sample_t static_sample  = filters.static_filter[channel].get_filtered_sample_dc_offset_removed();
+      filter_sample_t bank_sample    = filters.bank.get_filtered_sample_dc_offset_removed(channel);
+      if((runtime_sample != static_sample) || (runtime_sample != bank_sample))
+      {
+        printf("Mismatch at sample %u channel %u: %d %d %d\n", i, channel, runtime_sample, static_sample, bank_sample);
+        return 1;
+      }
+    }
+  }
+
+  double runtime_cycles = benchmark("runtime", &filters, push_runtime);
+  double static_cycles  = benchmark("static",  &filters, push_static);
+  double bank_cycles    = benchmark("bank",    &filters, push_bank);
+  printf("static %.1fx, bank %.1fx faster than runtime\n", runtime_cycles/static_cycles, runtime_cycles/bank_cycles);
+  return 0;
+}
\ No newline at end of file
@@ -0,0 +1,114 @@
+/* Host benchmark of median_filter_c against a sort of the window per sample
+    Both filters run over accelerometer like input with single sample spikes for a range of window lengths.  The
+    outputs are checked for equality first.  The naive filter copies the window and partially sorts it with
+    std::nth_element, the cheapest per sample sort.
+
+    Build and run from data_collector:
+      g++ -O2 -std=gnu++17 -Iinc -o median_filter_benchmark benchmark/median_filter_benchmark.cpp src/median_filter.cpp && ./median_filter_benchmark
+
+    Host cycle counts only show the relative cost, the RP2040 has no cache and no branch prediction so the gap at
+    larger windows is wider. */
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCHMARK_CYCLES() __rdtsc()
+#else
+#define BENCHMARK_CYCLES() ((uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count())
+#endif
+
+#include "median_filter.hpp"
+
+#define BENCHMARK_SAMPLES 200000
+#define BENCHMARK_WINDOW_MAX 255
+
+/* Median of the last 'window_length' samples by partial sort of a copy of the window */
+class naive_median_filter_c
+{
+  private:
+    const size_t    window_length;
+    filter_sample_t window[BENCHMARK_WINDOW_MAX];
+    filter_sample_t sorted[BENCHMARK_WINDOW_MAX];
+    size_t          next_write  = 0;
+    size_t          window_fill = 0;
+    filter_sample_t median      = 0;
+
+  public:
+    naive_median_filter_c(size_t window_length_init) : window_length(window_length_init) {};
+    void push_sample(filter_sample_t sample)
+    {
+      window[next_write] = sample;
+      next_write = ((next_write+1) < window_length) ? (next_write+1) : 0;
+      if(window_fill < window_length)
+      {
+        window_fill++;
+      }
+      std::copy(window, &window[window_fill], sorted);
+      std::nth_element(sorted, &sorted[window_fill/2], &sorted[window_fill]);
+      median = sorted[window_fill/2];
+    }
+    inline filter_sample_t get_median() const {return median;};
+};
+
+static filter_sample_t samples[4096];
+
+template <class FILTER>
+static double benchmark(FILTER *filter)
+{
+  filter_sample_t checksum = 0;
+  uint64_t start = BENCHMARK_CYCLES();
+  for(uint32_t i = 0; i < BENCHMARK_SAMPLES; i++)
+  {
+    filter->push_sample(samples[i & 4095]);
+    checksum += filter->get_median();
+  }
+  uint64_t end = BENCHMARK_CYCLES();
+  /* Keep the medians live */
+  if(0 == checksum)
+  {
+    printf(" ");
+  }
+  return ((double)(end-start))/BENCHMARK_SAMPLES;
+}
+
+int main()
+{
+  /* 1g offset with noise in mm/s^2 and a spike every ~100 samples */
+  srand(1);
+  for(uint32_t i = 0; i < 4096; i++)
+  {
+    samples[i] = 9807 + (rand() % 2001) - 1000;
+    if(0 == (rand() % 100))
+    {
+      samples[i] += ((rand() & 1) ? 50000 : -50000);
+    }
+  }
+
+  static const size_t window_lengths[] = {3, 5, 7, 9, 15, 31, 63, 127, 255};
+  printf("window   heap cycles  sort cycles  speedup\n");
+  for(size_t window_length : window_lengths)
+  {
+    median_filter_c       heap_filter(window_length);
+    naive_median_filter_c naive_filter(window_length);
+
+    /* Both filters must agree */
+    for(uint32_t i = 0; i < 20000; i++)
+    {
+      heap_filter.push_sample(samples[i & 4095]);
+      naive_filter.push_sample(samples[i & 4095]);
+      if(heap_filter.get_median() != naive_filter.get_median())
+      {
+        printf("Mismatch at window %zu sample %u: %d %d\n", window_length, i, heap_filter.get_median(), naive_filter.get_median());
+        return 1;
+      }
+    }
+
+    double heap_cycles  = benchmark(&heap_filter);
+    double naive_cycles = benchmark(&naive_filter);
+    printf("%6zu %12.1f %12.1f %7.1fx\n", window_length, heap_cycles, naive_cycles, naive_cycles/heap_cycles);
+  }
+  return 0;
+}
\ No newline at end of file
@@ -0,0 +1,139 @@
+/* Host benchmark of rtc_ds3231_absolute_time_to_epoch_ms()
+    Compares the previous conversion (critical section, struct tm rebuild and mktime per sample) against the epoch
+    reference cached at each RTC tick (seqlock read and a 32 bit divide).  Both mirror src/rtc_ds3231.cpp with the
+    Pico SDK calls replaced by host equivalents.
+
+    Build and run from data_collector:
+      g++ -O2 -std=gnu++17 -o rtc_epoch_benchmark benchmark/rtc_epoch_benchmark.cpp && ./rtc_epoch_benchmark
+
+    Host cycle counts only show the relative cost, newlib mktime and 64 bit division are much slower on the RP2040. */
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <mutex>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCHMARK_CYCLES() __rdtsc()
+#else
+#define BENCHMARK_CYCLES() ((uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count())
+#endif
+
+#define BENCHMARK_ITERATIONS 1000000
+#define TIME_US_TO_MS(time_us) (time_us/1000)
+
+typedef struct
+{
+  uint8_t seconds;
+  uint8_t minutes;
+  uint8_t hours;
+  uint8_t day;
+  uint8_t date;
+  uint8_t month;
+  uint8_t year;
+  bool    century;
+} rtc_ds3231_data_s;
+
+static std::mutex        critical_section; /* Stands in for critical_section_t */
+static rtc_ds3231_data_s data           = {.seconds=15, .minutes=20, .hours=12, .day=3, .date=6, .month=3, .year=23, .century=true};
+static uint64_t          reference_time = 5000000;
+
+/* Previous implementation */
+static uint64_t epoch_ms_mktime(uint64_t t)
+{
+  critical_section.lock();
+  rtc_ds3231_data_s data_copy = data;
+  uint64_t          reference = reference_time;
+  critical_section.unlock();
+
+  struct tm time = {}; /* Value initialized, struct tm has platform specific fields */
+  time.tm_sec   = (data_copy.seconds  % 60);
+  time.tm_min   = (data_copy.minutes  % 60);
+  time.tm_hour  = (data_copy.hours    % 24);
+  time.tm_mday  = (data_copy.date     % 32);
+  time.tm_mon   = ((data_copy.month-1)% 12);
+  time.tm_year  = (data_copy.year     % 100);
+  if(data_copy.century==true) { time.tm_year += 100; }
+  time.tm_wday  = ((data_copy.day-1)  % 7);
+  time.tm_isdst = false;
+  time_t epoch = mktime(&time);
+
+  return ((epoch*1000) + TIME_US_TO_MS((int64_t)(t-reference)));
+}
+
+/* Cached epoch reference */
+static struct
+{
+  std::atomic<uint32_t> sequence;
+  uint64_t              epoch_ms;
+  uint64_t              reference_us;
+} epoch_reference;
+
+static uint64_t epoch_ms_cached(uint64_t t)
+{
+  uint32_t sequence;
+  uint64_t epoch_ms;
+  uint64_t reference_us;
+  do
+  {
+    sequence     = epoch_reference.sequence.load(std::memory_order_acquire);
+    epoch_ms     = epoch_reference.epoch_ms;
+    reference_us = epoch_reference.reference_us;
+    std::atomic_thread_fence(std::memory_order_acquire);
+  } while((0 != (sequence & 1)) || (sequence != epoch_reference.sequence.load(std::memory_order_relaxed)));
+
+  uint64_t ret_val;
+  int64_t  delta_us = (int64_t)(t - reference_us);
+  if((delta_us >= INT32_MIN) && (delta_us <= INT32_MAX))
+  {
+    ret_val = (epoch_ms + (int32_t)TIME_US_TO_MS((int32_t)delta_us));
+  }
+  else
+  {
+    ret_val = (epoch_ms + TIME_US_TO_MS(delta_us));
+  }
+  return ret_val;
+}
+
+typedef uint64_t (*conversion_f)(uint64_t t);
+static double benchmark(const char *name, conversion_f conversion)
+{
+  volatile uint64_t sink = 0;
+  uint64_t start = BENCHMARK_CYCLES();
+  for(uint64_t i = 0; i < BENCHMARK_ITERATIONS; i++)
+  {
+    /* 100Hz samples up to one second after the tick */
+    sink = sink + conversion(reference_time + ((i % 100)*10000));
+  }
+  uint64_t end = BENCHMARK_CYCLES();
+  double cycles = ((double)(end-start))/BENCHMARK_ITERATIONS;
+  printf("%-8s %8.1f cycles per conversion\n", name, cycles);
+  return cycles;
+}
+
+int main()
+{
+  setenv("TZ", "UTC", 1);
+  tzset();
+
+  epoch_reference.epoch_ms     = epoch_ms_mktime(reference_time);
+  epoch_reference.reference_us = reference_time;
+  epoch_reference.sequence     = 2;
+
+  /* Both conversions must agree */
+  for(uint64_t t = 0; t < 10000000; t += 999)
+  {
+    if(epoch_ms_mktime(t) != epoch_ms_cached(t))
+    {
+      printf("Mismatch at %llu us: %llu != %llu\n", (unsigned long long)t, (unsigned long long)epoch_ms_mktime(t), (unsigned long long)epoch_ms_cached(t));
+      return 1;
+    }
+  }
+
+  double before = benchmark("mktime", epoch_ms_mktime);
+  double after  = benchmark("cached", epoch_ms_cached);
+  printf("%.1fx faster\n", before/after);
+  return 0;
+}
\ No newline at end of file
@@ -0,0 +1,52 @@
+clear;
+clc;
+close all;
+pkg load signal;
+
+# Butterworth second order sections by bilinear transform with prewarping, Q for each conjugate pole pair of the
+# order N prototype.  Sections are ordered by increasing Q, so the resonant section is last and the sections before
+# it have already attenuated its input, and each has unity pass band gain.  Q falls as k rises so k counts down.
+function [sections, Q] = butterworth_sections(N, cutoff_f, Fs, hpf=0)
+  K=tan(pi*cutoff_f/Fs);
+  sections=[];
+  Q=[];
+  for k = N/2:-1:1
+    Q_k=1/(2*sin(pi*(2*k-1)/(2*N)));
+    Q=[Q; Q_k];
+    norm=1+K/Q_k+K^2;
+    a_1=2*(K^2-1)/norm;
+    a_2=(1-K/Q_k+K^2)/norm;
+    if(hpf > 0)
+      b_0=1/norm;
+      b=[b_0, -2*b_0, b_0];
+    else
+      b_0=K^2/norm;
+      b=[b_0, 2*b_0, b_0];
+    end
+    sections=[sections; b, a_1, a_2];
+  end
+end
+
+Fs=100;
+fraction_bits=30;
+
+# 4th order low pass
+[sections, Q]=butterworth_sections(4, 10, Fs);
+# Band pass, 2nd order high pass then 2nd order low pass
+#[hpf_sections, hpf_Q]=butterworth_sections(2, 0.05, Fs, 1);
+#[lpf_sections, lpf_Q]=butterworth_sections(2, 1, Fs);
+#sections=[hpf_sections; lpf_sections];
+#Q=[hpf_Q; lpf_Q];
+
+sections_int=round(sections*2^fraction_bits);
+sos=[sections_int(:,1:3), 2^fraction_bits*ones(rows(sections_int),1), sections_int(:,4:5)]/2^fraction_bits;
+[b,a]=sos2tf(sos);
+freqz(b, a, 4096, Fs);
+# Table rows for filter_coefficients.hpp
+for i = 1:rows(sections_int)
+  separator=",";
+  if(i == rows(sections_int))
+    separator=" ";
+  end
+  printf("  {%11d, %11d, %11d, %11d, %11d}%s /* Q %.3f */\n", sections_int(i,:), separator, Q(i));
+end
\ No newline at end of file
@@ -1,6 +1,8 @@
 #ifndef __ADC_MANAGER_HPP__
 #define __ADC_MANAGER_HPP__
 
+#include <pico/time.h>
+
 #include "seismometer_types.hpp"
 
 #define ADC_CH_TO_PIN(channel)  (26+channel)
@@ -29,10 +31,22 @@ typedef unsigned int adc_channel_mask_t;
 #define ADC_MANAGER_SAMPLE_MAX_VALUE ((1<<12)-1) /* RP2040 ADC has 12 bit resolution */
 typedef uint16_t adc_sample_t;
 
+typedef struct
+{
+  uint32_t window_count;   /* Oversampled windows decimated */
+  uint32_t hold_count;     /* Reads with no new window, previous samples held */
+  uint32_t catch_up_count; /* Reads which decimated more than one window, once at start while the CIC filter fills */
+} adc_manager_stats_s;
+
 /* Initializes the ADC manager and ADC*/
 void adc_manager_init(adc_channel_mask_t enabled_channels);
-/* Read fresh data from ADC */
-void adc_manager_read();
+/* With SEISMOMETER_ADC_DMA, starts the free running round robin conversions into the DMA ring.  The first window
+   completes one sample period later */
+void adc_manager_start();
+/* Read fresh data from ADC and return the time it was sampled.  With SEISMOMETER_ADC_DMA this decimates the
+   conversions completed since the last read, timestamped at the centre of the CIC filter */
+absolute_time_t adc_manager_read();
+void adc_manager_get_stats(adc_manager_stats_s *stats);
 /* Returns current sample for given ADC channel.  Returns ADC_MANAGER_SAMPLE_INVALID if error */
 adc_sample_t adc_manager_get_sample(adc_channel_t channel);
 /* Returns current sample in millivolts for given ADC channel.  Returns 0 if error */
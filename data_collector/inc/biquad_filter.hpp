@@ -0,0 +1,80 @@
+#ifndef __BIQUAD_FILTER_HPP__
+#define __BIQUAD_FILTER_HPP__
+
+#include <cstddef>
+#include <cstdint>
+
+#include "fir_filter.hpp"
+
+/* Biquad coefficients are signed Q2.30, covering the -2 < a1 < 2 range of stable second order sections */
+typedef int32_t biquad_coefficient_t;
+#define BIQUAD_COEFFICIENT_FRACTION_BITS 30
+/* Samples per block of push_samples(), longer blocks are split */
+#define BIQUAD_FILTER_BLOCK_SIZE 32
+
+/* One second order section, H(z) = (b0 + b1*z^-1 + b2*z^-2)/(1 + a1*z^-1 + a2*z^-2), generated by filter/biquad.m */
+typedef struct
+{
+  biquad_coefficient_t b0;
+  biquad_coefficient_t b1;
+  biquad_coefficient_t b2;
+  biquad_coefficient_t a1;
+  biquad_coefficient_t a2;
+} biquad_section_s;
+
+/* IIR filter as a cascade of fixed-point direct form I biquads
+    Each section accumulates five Q2.30 products in 64 bits and rounds back to a sample, so there is no intermediate
+    overflow for any sample in range.  The state is the integer inputs and outputs of each section plus the rounding
+    error of the outputs, fed back so the rounding does not stick low corner sections at an offset.  A 4th order
+    low pass costs 10 multiplies per sample against 64 for the FIR low pass, at the cost of non-linear phase.  Gain
+    and the DC blocker of fir_filter_config_s apply as for fir_filter_c, the moving average is not supported as there
+    is no sample history to share.  push_samples() runs a block through one section at a time with the section
+    state held in locals. */
+class biquad_filter_c
+{
+  private:
+    typedef struct
+    {
+      filter_sample_t x1;
+      filter_sample_t x2;
+      filter_sample_t y1;
+      filter_sample_t y2;
+      int32_t         e1; /* Q2.30 rounding error of the last two outputs */
+      int32_t         e2;
+    } biquad_state_s;
+
+    /* Filter Configuration */
+    const fir_filter_config_s     config;
+    const size_t                  section_count;
+    const biquad_section_s *const section;
+
+    /* Per section inputs, outputs and output rounding errors of the last two samples */
+    biquad_state_s               *state = nullptr;
+
+    /* Sampling data */
+    filter_sample_t               moving_average    = 0;
+    filter_sample_t               dc_blocker_state  = 0;
+    bool                          dc_blocker_seeded = false;
+    filter_sample_t               filtered_sample   = 0;
+
+    void                   filter_block(filter_sample_t *sample, size_t count);
+    void                   remove_dc_offset(const filter_sample_t *sample, size_t count, filter_sample_t *output);
+
+  public:
+    biquad_filter_c( size_t section_count, const biquad_section_s *section, const fir_filter_config_s *config = &default_fir_filter_config);
+    ~biquad_filter_c();
+
+    /* Push incoming raw sample and compute new filtered sample */
+    void                   push_sample(filter_sample_t sample);
+    /* Push 'count' raw samples, writing each filtered sample with DC offset removed (if enabled) to 'output', which
+       may be 'sample' */
+    void                   push_samples(const filter_sample_t *sample, size_t count, filter_sample_t *output);
+    /* Returns current filtered sample */
+    inline filter_sample_t get_filtered_sample()                   const {return filtered_sample;};
+    /* Returns current filtered sample with DC offset removed via DC blocker */
+    inline filter_sample_t get_filtered_sample_dc_offset_removed() const {return (filtered_sample-moving_average);};
+    /* Returns current DC blocker estimate or 0 if DC offset removal is not enabled */
+    inline filter_sample_t get_moving_average()                    const {return moving_average;};
+};
+
+#endif /*__BIQUAD_FILTER_HPP__*/
\ No newline at end of file
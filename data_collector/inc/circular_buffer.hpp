@@ -0,0 +1,12 @@
+#ifndef __CIRCULAR_BUFFER_HPP__
+#define __CIRCULAR_BUFFER_HPP__
+
+/* Index arithmetic for circular buffers of buffer_size entries, free of Pico SDK headers so host benchmarks can use it */
+#define INCREMENT_CIRCULAR_BUFFER_ITERATOR(iterator, buffer_size) \
+  ((((iterator)+1) < (buffer_size))?((iterator)+1):(0)) /* If iterator exceeds buffer size, reset to 0 */
+#define CIRCULAR_BUFFER_OFFSET_NEG(index, buffer_size, offset) \
+  (((offset) <= (index))?((index)-(offset)):((index)+(buffer_size)-(offset)))
+#define CIRCULAR_BUFFER_OFFSET_POS(index, buffer_size, offset) \
+  ((((index)+(offset)) < (buffer_size))?((index)+(offset)):((index)+(offset)-(buffer_size)))
+
+#endif /*__CIRCULAR_BUFFER_HPP__*/
\ No newline at end of file
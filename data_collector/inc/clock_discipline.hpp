@@ -0,0 +1,28 @@
+#ifndef __CLOCK_DISCIPLINE_HPP__
+#define __CLOCK_DISCIPLINE_HPP__
+
+#include <cstdint>
+
+/* Disciplines the RP2040 timer (us since boot) to the DS3231 RTC
+    Each RTC tick gives the epoch time of a timer timestamp.  The frequency offset of the timer is estimated from the
+    tick intervals and phase error at each tick is slewed out over SEISMOMETER_CLOCK_DISCIPLINE_SLEW_S seconds, so epoch
+    time is continuous and monotonic instead of jumping at every tick.  Phase errors beyond
+    SEISMOMETER_CLOCK_DISCIPLINE_STEP_US (first tick, RTC set) step the time. */
+
+typedef struct
+{
+  int32_t  frequency_offset_ppb;        /* Estimated timer frequency error, positive when the timer is slow */
+  int32_t  phase_error_us;              /* Epoch time error at the last tick before correction */
+  uint32_t step_count;                  /* Number of ticks which stepped the time */
+} clock_discipline_stats_s;
+
+/* Updates the discipline with the epoch time (ms since unix epoch) of an RTC tick at 'local_us' (us since boot).
+   Must only be called from one context */
+void     clock_discipline_tick(uint64_t local_us, uint64_t epoch_ms);
+/* Returns disciplined ms since unix epoch of 'local_us', lock-free and safe from either core */
+uint64_t clock_discipline_epoch_ms(uint64_t local_us);
+/* Returns disciplined us since unix epoch of 'local_us', lock-free and safe from either core */
+uint64_t clock_discipline_epoch_us(uint64_t local_us);
+void     clock_discipline_get_stats(clock_discipline_stats_s *stats);
+
+#endif /*__CLOCK_DISCIPLINE_HPP__*/
\ No newline at end of file
@@ -0,0 +1,27 @@
+#ifndef __EVENT_CAPTURE_HPP__
+#define __EVENT_CAPTURE_HPP__
+
+#include <cstdint>
+
+#include "fir_filter.hpp"
+#include "seismometer_types.hpp"
+
+/* Triggered event capture
+    STA/LTA detectors (see sta_lta.hpp) run on the filtered acceleration magnitude and pendulum channels and the raw
+    acceleration X/Y/Z and pendulum 10x/100x samples of the last SEISMOMETER_EVENT_PRE_TRIGGER_S (fewer above the
+    default sample rate) are kept in a RAM ring.  When either detector triggers a binary event file is opened (see sample_file_event_open()) and the ring is
+    written to it as SAMPLE_RECORD_TYPE_FRAME records, followed by every new sample until
+    SEISMOMETER_EVENT_POST_TRIGGER_S after both detectors detrigger.  The acceleration sample of an index must be
+    pushed before its pendulum sample, the pendulum sample completes the index. */
+
+/* Creates the detectors for the sample rate, call after sample_rate_init() */
+void event_capture_init();
+/* Push the raw acceleration sample and filtered magnitude of 'index' */
+void event_capture_acceleration(sample_index_t index, uint64_t timestamp, const acceleration_sample_s *acceleration, filter_sample_t magnitude_filtered);
+/* Push the raw pendulum sample and filtered pendulum channel of 'index', then update the event state */
+void event_capture_pendulum(sample_index_t index, uint64_t timestamp, const pendulum_sample_s *pendulum, filter_sample_t pendulum_filtered);
+/* Enable or disable event capture, disabling ends the current event */
+void event_capture_set_enabled(bool enabled);
+bool event_capture_get_enabled();
+
+#endif /*__EVENT_CAPTURE_HPP__*/
\ No newline at end of file
@@ -0,0 +1,37 @@
+#ifndef __FFT_Q15_HPP__
+#define __FFT_Q15_HPP__
+
+#include <cstddef>
+#include <cstdint>
+
+/* Signed fixed-point with 15 fraction bits, -1 <= x < 1 */
+typedef int16_t q15_t;
+#define Q15_ONE 32768
+
+/* Fixed-point real FFT
+    The 'length' real samples are transformed as length/2 complex samples by an in place radix-2 decimation in time
+    FFT, then split into the length/2+1 bins of the real input.  Block floating point keeps the Q15 data below 2^13
+    ahead of each stage so no butterfly can overflow, shifting right only when needed, and the shifts are returned
+    as an exponent.  Twiddles are a Q15 table of length/2 entries, also used for the Hann window. */
+class fft_q15_c
+{
+  private:
+    const size_t length;
+    /* cos and sin of 2*pi*k/length for k < length/2, interleaved */
+    q15_t       *twiddle = nullptr;
+
+  public:
+    /* 'length' must be a power of 2, at least 4 */
+    fft_q15_c(size_t length);
+    ~fft_q15_c();
+
+    /* In place forward FFT of 'length' real samples in 'data'.  The output bins X[0..length/2] are packed into the
+       same 'length' values, data[0] is X[0], data[1] is X[length/2] (both real) and data[2k], data[2k+1] are the
+       real and imaginary parts of X[k] for 0 < k < length/2.  Returns the block exponent, X = output*2^exponent */
+    int            forward_real(q15_t *data) const;
+    /* Q15 periodic Hann window coefficient of sample 'n' < length */
+    q15_t          window_hann(size_t n)     const;
+    inline size_t  get_length()              const {return length;};
+};
+
+#endif /*__FFT_Q15_HPP__*/
\ No newline at end of file
@@ -1,11 +1,169 @@
 #ifndef __FILTER_COEFFICIENTS_HPP__
 #define __FILTER_COEFFICIENTS_HPP__
 
+#include "biquad_filter.hpp"
 #include "fir_filter.hpp"
 
+/* 10Hz low pass of the filtered channels at each supported sample rate (see sample_rate.hpp), the order scales
+   with the rate so the transition band stays 5-7Hz wide.  constexpr so fir_filter_static_c and fir_filter_bank_c can
+   expand the taps at compile time */
+#define FIR_HAMMING_LPF_50HZ_FS_10HZ_CUTOFF_ORDER 32
+#define FIR_HAMMING_LPF_50HZ_FS_10HZ_CUTOFF_GAIN_NUM 1
+#define FIR_HAMMING_LPF_50HZ_FS_10HZ_CUTOFF_GAIN_DEN 99852
+inline constexpr filter_coefficient_t fir_hamming_lpf_50hz_fs_10hz_cutoff[FIR_HAMMING_LPF_50HZ_FS_10HZ_CUTOFF_ORDER] =
+{
+      151,        0,     -248,     -227,      335,      782,        0,    -1513,
+    -1262,     1682,     3610,        0,    -6543,    -5748,     9020,    29980,
+    39965,    29980,     9020,    -5748,    -6543,        0,     3610,     1682,
+    -1262,    -1513,        0,      782,      335,     -227,     -248,        0
+};
+
 #define FIR_HAMMING_LPF_100HZ_FS_10HZ_CUTOFF_ORDER 64
 #define FIR_HAMMING_LPF_100HZ_FS_10HZ_CUTOFF_GAIN_NUM 1
 #define FIR_HAMMING_LPF_100HZ_FS_10HZ_CUTOFF_GAIN_DEN 99882
-extern const filter_coefficient_t fir_hamming_lpf_100hz_fs_10hz_cutoff[FIR_HAMMING_LPF_100HZ_FS_10HZ_CUTOFF_ORDER];
+inline constexpr filter_coefficient_t fir_hamming_lpf_100hz_fs_10hz_cutoff[FIR_HAMMING_LPF_100HZ_FS_10HZ_CUTOFF_ORDER] =
+{
+      76,       50,        0,      -65,     -126,     -153,     -115,        0,
+     171,      333,      400,      294,        0,     -409,     -774,     -900,
+    -645,        0,      858,     1599,     1840,     1310,        0,    -1755,
+   -3319,    -3921,    -2908,        0,     4548,     9947,    15059,    18699,
+   19989,    18614,    14921,     9811,     4464,        0,    -2827,    -3794,
+   -3195,    -1681,        0,     1240,     1732,     1496,      798,        0,
+    -591,     -819,     -699,     -366,        0,      259,      348,      288,
+     146,        0,      -98,     -130,     -109,      -57,        0,       48
+};
+
+#define FIR_HAMMING_LPF_200HZ_FS_10HZ_CUTOFF_ORDER 128
+#define FIR_HAMMING_LPF_200HZ_FS_10HZ_CUTOFF_GAIN_NUM 1
+#define FIR_HAMMING_LPF_200HZ_FS_10HZ_CUTOFF_GAIN_DEN 99962
+inline constexpr filter_coefficient_t fir_hamming_lpf_200hz_fs_10hz_cutoff[FIR_HAMMING_LPF_200HZ_FS_10HZ_CUTOFF_ORDER] =
+{
+       38,       33,       25,       14,        0,      -16,      -32,      -48,
+      -62,      -72,      -75,      -71,      -57,      -33,        0,       40,
+       84,      127,      163,      188,      196,      182,      144,       82,
+        0,      -97,     -200,     -298,     -379,     -430,     -441,     -404,
+     -316,     -179,        0,      206,      421,      622,      785,      885,
+      904,      825,      644,      364,        0,     -422,     -865,    -1286,
+    -1638,    -1870,    -1937,    -1802,    -1439,     -836,        0,     1045,
+     2258,     3581,     4947,     6281,     7504,     8544,     9337,     9834,
+    10004,     9834,     9337,     8544,     7504,     6281,     4947,     3581,
+     2258,     1045,        0,     -836,    -1439,    -1802,    -1937,    -1870,
+    -1638,    -1286,     -865,     -422,        0,      364,      644,      825,
+      904,      885,      785,      622,      421,      206,        0,     -179,
+     -316,     -404,     -441,     -430,     -379,     -298,     -200,      -97,
+        0,       82,      144,      182,      196,      188,      163,      127,
+       84,       40,        0,      -33,      -57,      -71,      -75,      -72,
+      -62,      -48,      -32,      -16,        0,       14,       25,       33
+};
+
+#define FIR_HAMMING_LPF_500HZ_FS_10HZ_CUTOFF_ORDER 256
+#define FIR_HAMMING_LPF_500HZ_FS_10HZ_CUTOFF_GAIN_NUM 1
+#define FIR_HAMMING_LPF_500HZ_FS_10HZ_CUTOFF_GAIN_DEN 100002
+inline constexpr filter_coefficient_t fir_hamming_lpf_500hz_fs_10hz_cutoff[FIR_HAMMING_LPF_500HZ_FS_10HZ_CUTOFF_ORDER] =
+{
+       -7,       -5,       -3,        0,        3,        5,        8,       11,
+       14,       17,       19,       22,       25,       27,       29,       31,
+       33,       34,       34,       34,       33,       32,       30,       27,
+       23,       19,       13,        7,        0,       -8,      -16,      -25,
+      -34,      -44,      -53,      -63,      -72,      -81,      -89,      -96,
+     -102,     -107,     -110,     -111,     -111,     -108,     -102,      -95,
+      -85,      -73,      -58,      -41,      -21,        0,       23,       48,
+       73,       99,      126,      152,      178,      203,      225,      246,
+      263,      277,      288,      293,      295,      290,      281,      266,
+      244,      217,      185,      146,      102,       53,        0,      -57,
+     -118,     -181,     -245,     -310,     -374,     -436,     -496,     -551,
+     -601,     -644,     -679,     -705,     -721,     -725,     -718,     -697,
+     -662,     -612,     -548,     -469,     -374,     -264,     -139,        0,
+      153,      319,      497,      685,      883,     1088,     1299,     1515,
+     1733,     1952,     2168,     2382,     2589,     2789,     2979,     3157,
+     3322,     3472,     3606,     3721,     3817,     3892,     3947,     3980,
+     3991,     3980,     3947,     3892,     3817,     3721,     3606,     3472,
+     3322,     3157,     2979,     2789,     2589,     2382,     2168,     1952,
+     1733,     1515,     1299,     1088,      883,      685,      497,      319,
+      153,        0,     -139,     -264,     -374,     -469,     -548,     -612,
+     -662,     -697,     -718,     -725,     -721,     -705,     -679,     -644,
+     -601,     -551,     -496,     -436,     -374,     -310,     -245,     -181,
+     -118,      -57,        0,       53,      102,      146,      185,      217,
+      244,      266,      281,      290,      295,      293,      288,      277,
+      263,      246,      225,      203,      178,      152,      126,       99,
+       73,       48,       23,        0,      -21,      -41,      -58,      -73,
+      -85,      -95,     -102,     -108,     -111,     -111,     -110,     -107,
+     -102,      -96,      -89,      -81,      -72,      -63,      -53,      -44,
+      -34,      -25,      -16,       -8,        0,        7,       13,       19,
+       23,       27,       30,       32,       33,       34,       34,       34,
+       33,       31,       29,       27,       25,       22,       19,       17,
+       14,       11,        8,        5,        3,        0,       -3,       -5
+};
+
+/* Anti-alias low pass for decimation by 2, cutoff 0.2*fs (200Hz at 1kHz), -53dB from 0.28*fs */
+#define FIR_HAMMING_LPF_DECIMATE_2_ORDER 32
+#define FIR_HAMMING_LPF_DECIMATE_2_GAIN_NUM 1
+#define FIR_HAMMING_LPF_DECIMATE_2_GAIN_DEN 100004
+inline constexpr filter_coefficient_t fir_hamming_lpf_decimate_2[FIR_HAMMING_LPF_DECIMATE_2_ORDER] =
+{
+       97,     -115,     -263,        0,      588,      529,     -749,    -1676,
+        0,     3054,     2528,    -3418,    -7694,        0,    19768,    37353,
+    37353,    19768,        0,    -7694,    -3418,     2528,     3054,        0,
+    -1676,     -749,      529,      588,        0,     -263,     -115,       97
+};
+
+/* Anti-alias low pass for decimation by 5, cutoff 0.08*fs (8Hz at 100Hz), -60dB from 0.12*fs */
+#define FIR_HAMMING_LPF_DECIMATE_5_ORDER 64
+#define FIR_HAMMING_LPF_DECIMATE_5_GAIN_NUM 1
+#define FIR_HAMMING_LPF_DECIMATE_5_GAIN_DEN 100008
+inline constexpr filter_coefficient_t fir_hamming_lpf_decimate_5[FIR_HAMMING_LPF_DECIMATE_5_ORDER] =
+{
+     -10,       32,       74,      110,      128,      112,       50,      -60,
+    -202,     -340,     -421,     -394,     -223,       89,      491,      881,
+    1128,     1104,      728,        0,     -970,    -1966,    -2698,    -2855,
+   -2183,     -555,     1982,     5190,     8666,    11910,    14419,    15787,
+   15787,    14419,    11910,     8666,     5190,     1982,     -555,    -2183,
+   -2855,    -2698,    -1966,     -970,        0,      728,     1104,     1128,
+     881,      491,       89,     -223,     -394,     -421,     -340,     -202,
+     -60,       50,      112,      128,      110,       74,       32,      -10
+};
+
+/* Anti-alias low pass for decimation by 10, cutoff 0.035*fs (3.5Hz at 100Hz), -54dB from 0.05*fs */
+#define FIR_HAMMING_LPF_DECIMATE_10_ORDER 128
+#define FIR_HAMMING_LPF_DECIMATE_10_GAIN_NUM 1
+#define FIR_HAMMING_LPF_DECIMATE_10_GAIN_DEN 99994
+inline constexpr filter_coefficient_t fir_hamming_lpf_decimate_10[FIR_HAMMING_LPF_DECIMATE_10_ORDER] =
+{
+      40,       38,       35,       30,       24,       15,        4,       -9,
+     -23,      -40,      -58,      -76,      -93,     -108,     -119,     -125,
+    -124,     -115,      -96,      -68,      -30,       18,       74,      135,
+     200,      263,      322,      372,      408,      425,      420,      389,
+     331,      244,      129,      -11,     -172,     -348,     -531,     -711,
+    -879,    -1022,    -1130,    -1191,    -1193,    -1129,     -990,     -772,
+    -472,      -92,      365,      892,     1476,     2106,     2765,     3436,
+    4099,     4734,     5323,     5845,     6286,     6630,     6866,     6985,
+    6985,     6866,     6630,     6286,     5845,     5323,     4734,     4099,
+    3436,     2765,     2106,     1476,      892,      365,      -92,     -472,
+    -772,     -990,    -1129,    -1193,    -1191,    -1130,    -1022,     -879,
+    -711,     -531,     -348,     -172,      -11,      129,      244,      331,
+     389,      420,      425,      408,      372,      322,      263,      200,
+     135,       74,       18,      -30,      -68,      -96,     -115,     -124,
+    -125,     -119,     -108,      -93,      -76,      -58,      -40,      -23,
+      -9,        4,       15,       24,       30,       35,       38,       40
+};
+
+/* Biquad cascades from filter/biquad.m, {b0, b1, b2, a1, a2} per section in order of increasing Q, each section has
+   unity pass band gain */
+/* 4th order Butterworth low pass, 10Hz cutoff at 100Hz, the IIR alternative to fir_hamming_lpf_100hz_fs_10hz_cutoff */
+#define BIQUAD_BUTTERWORTH_LPF_100HZ_FS_10HZ_CUTOFF_SECTIONS 2
+inline constexpr biquad_section_s biquad_butterworth_lpf_100hz_fs_10hz_cutoff[BIQUAD_BUTTERWORTH_LPF_100HZ_FS_10HZ_CUTOFF_SECTIONS] =
+{
+  {   66448722,   132897445,    66448722, -1125925222,   317978288}, /* Q 0.541 */
+  {   83704983,   167409967,    83704983, -1418319997,   679398106}  /* Q 1.307 */
+};
+
+/* Teleseismic band pass at 100Hz, 2nd order Butterworth high pass at 0.05Hz (20s) then 2nd order Butterworth low
+   pass at 1Hz.  DC is removed by the high pass so no DC blocker is needed */
+#define BIQUAD_BUTTERWORTH_BPF_100HZ_FS_0_05HZ_1HZ_SECTIONS 2
+inline constexpr biquad_section_s biquad_butterworth_bpf_100hz_fs_0_05hz_1hz[BIQUAD_BUTTERWORTH_BPF_100HZ_FS_0_05HZ_1HZ_SECTIONS] =
+{
+  { 1071359217, -2142718434,  1071359217, -2142713147,  1068981897}, /* Q 0.707 */
+  {    1014355,     2028710,     1014355, -2052132225,   982447822}  /* Q 0.707 */
+};
 
 #endif /*__FILTER_COEFFICIENTS_HPP__*/
\ No newline at end of file
@@ -8,9 +8,17 @@ typedef int          filter_coefficient_t;
 typedef int          filter_sample_t;
 typedef size_t       filter_order_t;
 
+/* Single pole DC blocker, the DC estimate is y += (x-y)/2^shift giving a high pass corner near fs/(2*pi*2^shift) with
+   O(1) state.  The estimate is held with 'shift' fraction bits so samples must stay within +-2^(31-shift) */
+#define FIR_FILTER_DC_BLOCKER_SHIFT_MAX 15
+/* Outputs push_samples() of fir_filter_static_c and fir_filter_bank_c accumulates at once, each coefficient is
+   applied to adjacent windows so the samples loaded are shared between the outputs */
+#define FIR_FILTER_BLOCK_OUTPUTS 4
+
 typedef struct
 {
   filter_order_t  moving_average_order; /* Order to remove DC offset via moving average.  Order 0 disables this logic */
+  unsigned int    dc_blocker_shift;     /* Remove DC offset via single pole DC blocker instead.  Shift 0 disables this logic */
   filter_sample_t gain_numerator;       /* Constant gain to multiply filter output by */
   filter_sample_t gain_denominator;     /* Constant gain to divide filter output by */
 } fir_filter_config_s;
@@ -24,28 +32,38 @@ class fir_filter_c
     const filter_order_t              order;
     const filter_coefficient_t *const coefficient;
 
-    /* Circular Buffer Data */
-    const filter_order_t        circular_buffer_size;
-    filter_sample_t            *circular_buffer = nullptr;
-    unsigned int                next_write      = 0;
+    /* Linear history of 2*history_length samples, the last history_length samples end at next_write and are moved
+       to the front once the buffer is full, so every filter and moving average window is contiguous */
+    const filter_order_t        history_length;
+    filter_sample_t            *history    = nullptr;
+    filter_order_t              next_write = 0;
 
     /* Sampling data */
     filter_order_t              moving_average_history = 0;
     filter_sample_t             moving_average_sum     = 0;
     filter_sample_t             moving_average         = 0;
+    filter_sample_t             dc_blocker_state       = 0;
+    bool                        dc_blocker_seeded      = false;
     filter_sample_t             filtered_sample        = 0;
 
+    filter_sample_t        filter(const filter_sample_t *window) const;
+    void                   remove_dc_offset(const filter_sample_t *sample, size_t count, filter_sample_t *output);
+    void                   history_wrap();
+
   public:
     fir_filter_c( filter_order_t order, const filter_coefficient_t *coefficient, const fir_filter_config_s *config = &default_fir_filter_config);
     ~fir_filter_c();
 
     /* Push incoming raw sample and compute new filtered sample */
     void                   push_sample(filter_sample_t sample);
+    /* Push 'count' raw samples, writing each filtered sample with DC offset removed (if enabled) to 'output', which
+       may be 'sample' */
+    void                   push_samples(const filter_sample_t *sample, size_t count, filter_sample_t *output);
     /* Returns current filtered sample */
     inline filter_sample_t get_filtered_sample()                   const {return filtered_sample;};
     /* Returns current filtered sample with DC offset removed via moving average */
     inline filter_sample_t get_filtered_sample_dc_offset_removed() const {return (filtered_sample-moving_average);}; 
-    /* Returns current moving average or 0 if moving average is not enabled */
+    /* Returns current moving average (or DC blocker estimate) or 0 if DC offset removal is not enabled */
     inline filter_sample_t get_moving_average()                    const {return moving_average;}; 
 
 };
@@ -0,0 +1,197 @@
+#ifndef __FIR_FILTER_BANK_HPP__
+#define __FIR_FILTER_BANK_HPP__
+
+#include <cstddef>
+#include <cstring>
+#include <utility>
+
+#include "fir_filter.hpp"
+
+/* Bank of CHANNELS FIR filters sharing order, coefficients, gain and moving average, fixed at compile time
+    Each channel has the same output as a fir_filter_static_c with the same parameters.  Channel histories are
+    interleaved per sample ([sample][channel]) in the linear history of fir_filter_static_c, so every tap is one
+    coefficient applied to CHANNELS adjacent values and all channels are filtered in one pass over the taps.  Zero
+    coefficient taps compile out.  push_samples() filters a block straight from the history as for
+    fir_filter_static_c.  DC offset removal is the moving average or DC blocker of fir_filter_static_c. */
+template <size_t CHANNELS, filter_order_t ORDER, const filter_coefficient_t *COEFFICIENT,
+          filter_sample_t GAIN_NUMERATOR = 1, filter_sample_t GAIN_DENOMINATOR = 1, filter_order_t MOVING_AVERAGE_ORDER = 0,
+          unsigned int DC_BLOCKER_SHIFT = 0>
+class fir_filter_bank_c
+{
+  static_assert(CHANNELS > 0, "Filter bank must have at least one channel");
+  static_assert(ORDER > 0, "Filter order must be greater than 0");
+  static_assert(GAIN_DENOMINATOR != 0, "Gain denominator must not be 0");
+  static_assert(DC_BLOCKER_SHIFT <= FIR_FILTER_DC_BLOCKER_SHIFT_MAX, "DC blocker shift out of range");
+  static_assert((0 == MOVING_AVERAGE_ORDER) || (0 == DC_BLOCKER_SHIFT), "Only one DC offset removal may be enabled");
+
+  private:
+    /* Filter history, the window of the last samples is the ORDER sample sets before next_write */
+    filter_sample_t history[2*ORDER][CHANNELS]         = {{0}};
+    filter_order_t  next_write                         = ORDER;
+
+    /* Moving average data */
+    filter_sample_t moving_average_buffer[(MOVING_AVERAGE_ORDER > 0) ? MOVING_AVERAGE_ORDER : 1][CHANNELS] = {{0}};
+    filter_order_t  moving_average_next_write          = 0;
+    filter_order_t  moving_average_history             = 0;
+    filter_sample_t moving_average_sum[CHANNELS]       = {0};
+    filter_sample_t moving_average[CHANNELS]           = {0};
+    filter_sample_t dc_blocker_state[CHANNELS]         = {0};
+    bool            dc_blocker_seeded                  = false;
+
+    filter_sample_t filtered_sample[CHANNELS]          = {0};
+
+    /* Windows push_samples() filters at once, consecutive windows of all channels are adjacent values so OUTPUTS
+       windows are one pass over the taps applying each coefficient to OUTPUTS*CHANNELS values.  The accumulators
+       are capped at FIR_FILTER_BLOCK_OUTPUTS */
+    static constexpr size_t BLOCK_OUTPUTS = ((CHANNELS < FIR_FILTER_BLOCK_OUTPUTS) ? (FIR_FILTER_BLOCK_OUTPUTS/CHANNELS) : 1);
+
+    template <size_t WIDTH, size_t TAP>
+    __attribute__((always_inline)) static inline void multiply_accumulate_tap(filter_sample_t *sum, const filter_sample_t *window)
+    {
+      if constexpr(0 != COEFFICIENT[TAP])
+      {
+        for(size_t i = 0; i < WIDTH; i++)
+        {
+          sum[i] += COEFFICIENT[TAP]*window[(TAP*CHANNELS)+i];
+        }
+      }
+    }
+    template <size_t WIDTH, size_t... TAP>
+    __attribute__((always_inline)) static inline void multiply_accumulate(filter_sample_t *sum, const filter_sample_t *window, std::index_sequence<TAP...>)
+    {
+      (multiply_accumulate_tap<WIDTH, TAP>(sum, window), ...);
+    }
+    /* Writes the filtered samples of the OUTPUTS consecutive windows from 'window', oldest to newest sample set, to
+       'output' */
+    template <size_t OUTPUTS>
+    static inline void filter(const filter_sample_t (*window)[CHANNELS], filter_sample_t (*output)[CHANNELS])
+    {
+      filter_sample_t sum[OUTPUTS*CHANNELS] = {0};
+      multiply_accumulate<OUTPUTS*CHANNELS>(sum, window[0], std::make_index_sequence<ORDER>{});
+      for(size_t i = 0; i < OUTPUTS; i++)
+      {
+        for(size_t channel = 0; channel < CHANNELS; channel++)
+        {
+          output[i][channel] = ((sum[(i*CHANNELS)+channel]*GAIN_NUMERATOR)/GAIN_DENOMINATOR);
+        }
+      }
+    }
+    /* Updates the moving averages (or DC blockers) with 'count' sets of raw samples, subtracting each estimate from
+       'output'.  The state is held in locals over the block and written back once */
+    inline void remove_dc_offset(const filter_sample_t (*sample)[CHANNELS], size_t count, filter_sample_t (*output)[CHANNELS])
+    {
+      if constexpr(MOVING_AVERAGE_ORDER > 0)
+      {
+        filter_order_t  next_write_local = moving_average_next_write;
+        filter_order_t  history_local    = moving_average_history;
+        filter_sample_t sum[CHANNELS];
+        filter_sample_t average[CHANNELS];
+        memcpy(sum,     moving_average_sum, sizeof(sum));
+        memcpy(average, moving_average,     sizeof(average));
+        for(size_t i = 0; i < count; i++)
+        {
+          if(history_local < MOVING_AVERAGE_ORDER)
+          {
+            history_local++;
+          }
+          for(size_t channel = 0; channel < CHANNELS; channel++)
+          {
+            sum[channel] -= moving_average_buffer[next_write_local][channel];
+            sum[channel] += sample[i][channel];
+            moving_average_buffer[next_write_local][channel] = sample[i][channel];
+            average[channel]    = (sum[channel]/((filter_sample_t)history_local));
+            output[i][channel] -= average[channel];
+          }
+          next_write_local = (((next_write_local+1) < MOVING_AVERAGE_ORDER) ? (next_write_local+1) : 0);
+        }
+        moving_average_next_write = next_write_local;
+        moving_average_history    = history_local;
+        memcpy(moving_average_sum, sum,     sizeof(sum));
+        memcpy(moving_average,     average, sizeof(average));
+      }
+      else if constexpr(DC_BLOCKER_SHIFT > 0)
+      {
+        if(!dc_blocker_seeded && (count > 0))
+        {
+          for(size_t channel = 0; channel < CHANNELS; channel++)
+          {
+            dc_blocker_state[channel] = (sample[0][channel] * (1 << DC_BLOCKER_SHIFT));
+          }
+          dc_blocker_seeded = true;
+        }
+        filter_sample_t state[CHANNELS];
+        filter_sample_t average[CHANNELS];
+        memcpy(state,   dc_blocker_state, sizeof(state));
+        memcpy(average, moving_average,   sizeof(average));
+        for(size_t i = 0; i < count; i++)
+        {
+          for(size_t channel = 0; channel < CHANNELS; channel++)
+          {
+            state[channel]     += (sample[i][channel] - (state[channel] >> DC_BLOCKER_SHIFT));
+            average[channel]    = (state[channel] >> DC_BLOCKER_SHIFT);
+            output[i][channel] -= average[channel];
+          }
+        }
+        memcpy(dc_blocker_state, state,   sizeof(state));
+        memcpy(moving_average,   average, sizeof(average));
+      }
+    }
+    /* Moves the last ORDER sample sets to the front once the history is full */
+    inline void history_wrap()
+    {
+      if((2*ORDER) == next_write)
+      {
+        memcpy(&history[0], &history[ORDER], (ORDER*sizeof(history[0])));
+        next_write = ORDER;
+      }
+    }
+
+  public:
+    /* Push incoming raw samples, one per channel, and compute new filtered samples */
+    inline void push_sample(const filter_sample_t *sample)
+    {
+      memcpy(&history[next_write++], sample, sizeof(history[0]));
+      filter<1>(&history[next_write-ORDER], &filtered_sample);
+      filter_sample_t output[1][CHANNELS];
+      memcpy(output[0], filtered_sample, sizeof(output[0]));
+      remove_dc_offset(&history[next_write-1], 1, output);
+      history_wrap();
+    };
+    /* Push 'count' sets of raw samples, writing each set of filtered samples with DC offset removed (if enabled) to
+       'output', which may be 'sample' */
+    inline void push_samples(const filter_sample_t (*sample)[CHANNELS], size_t count, filter_sample_t (*output)[CHANNELS])
+    {
+      while(count > 0)
+      {
+        /* Copy as much of the block as fits behind the history, filter it from the buffer then remove the DC offset */
+        const size_t block = ((((2*ORDER)-next_write) < count) ? ((2*ORDER)-next_write) : count);
+        memcpy(&history[next_write], sample, (block*sizeof(history[0])));
+        const filter_sample_t (*window)[CHANNELS] = &history[next_write+1-ORDER];
+        size_t i = 0;
+        for(; (i+BLOCK_OUTPUTS) <= block; i += BLOCK_OUTPUTS)
+        {
+          filter<BLOCK_OUTPUTS>(&window[i], &output[i]);
+        }
+        for(; i < block; i++)
+        {
+          filter<1>(&window[i], &output[i]);
+        }
+        memcpy(filtered_sample, output[block-1], sizeof(filtered_sample));
+        remove_dc_offset(&history[next_write], block, output);
+        next_write += block;
+        history_wrap();
+
+        sample += block;
+        output += block;
+        count  -= block;
+      }
+    };
+    /* Returns current filtered sample of 'channel' */
+    inline filter_sample_t get_filtered_sample(size_t channel)                   const {return filtered_sample[channel];};
+    /* Returns current filtered sample of 'channel' with DC offset removed via moving average */
+    inline filter_sample_t get_filtered_sample_dc_offset_removed(size_t channel) const {return (filtered_sample[channel]-moving_average[channel]);};
+    /* Returns current moving average (or DC blocker estimate) of 'channel' or 0 if DC offset removal is not enabled */
+    inline filter_sample_t get_moving_average(size_t channel)                    const {return moving_average[channel];};
+};
+
+#endif /*__FIR_FILTER_BANK_HPP__*/
\ No newline at end of file
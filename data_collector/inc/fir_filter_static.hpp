@@ -0,0 +1,182 @@
+#ifndef __FIR_FILTER_STATIC_HPP__
+#define __FIR_FILTER_STATIC_HPP__
+
+#include <cstddef>
+#include <cstring>
+#include <utility>
+
+#include "fir_filter.hpp"
+
+/* FIR filter with order, coefficients, gain and moving average fixed at compile time
+    Same output as fir_filter_c with the matching fir_filter_config_s.  Samples are appended to a linear history of
+    2*ORDER and the last ORDER moved to the front once it fills, so the window of every sample is contiguous, the
+    multiply-accumulate is expanded per tap with the constexpr coefficients (zero taps compile out) and there is no
+    wrap check per tap.  push_samples() copies the block behind the history once and filters it straight from the
+    buffer.  The moving average history is kept separately so the filter buffer stays 2*ORDER, or DC_BLOCKER_SHIFT
+    selects the O(1) single pole DC blocker of fir_filter_config_s::dc_blocker_shift instead. */
+template <filter_order_t ORDER, const filter_coefficient_t *COEFFICIENT,
+          filter_sample_t GAIN_NUMERATOR = 1, filter_sample_t GAIN_DENOMINATOR = 1, filter_order_t MOVING_AVERAGE_ORDER = 0,
+          unsigned int DC_BLOCKER_SHIFT = 0>
+class fir_filter_static_c
+{
+  static_assert(ORDER > 0, "Filter order must be greater than 0");
+  static_assert(GAIN_DENOMINATOR != 0, "Gain denominator must not be 0");
+  static_assert(DC_BLOCKER_SHIFT <= FIR_FILTER_DC_BLOCKER_SHIFT_MAX, "DC blocker shift out of range");
+  static_assert((0 == MOVING_AVERAGE_ORDER) || (0 == DC_BLOCKER_SHIFT), "Only one DC offset removal may be enabled");
+
+  private:
+    /* Filter history, the window of the last sample is the ORDER samples before next_write */
+    filter_sample_t history[2*ORDER]          = {0};
+    filter_order_t  next_write                = ORDER;
+
+    /* Moving average data */
+    filter_sample_t moving_average_buffer[(MOVING_AVERAGE_ORDER > 0) ? MOVING_AVERAGE_ORDER : 1] = {0};
+    filter_order_t  moving_average_next_write = 0;
+    filter_order_t  moving_average_history    = 0;
+    filter_sample_t moving_average_sum        = 0;
+    filter_sample_t moving_average            = 0;
+    filter_sample_t dc_blocker_state          = 0;
+    bool            dc_blocker_seeded         = false;
+
+    filter_sample_t filtered_sample           = 0;
+
+    template <size_t... TAP>
+    __attribute__((always_inline)) static inline filter_sample_t multiply_accumulate(const filter_sample_t *window, std::index_sequence<TAP...>)
+    {
+      return (0 + ... + (COEFFICIENT[TAP]*window[TAP]));
+    }
+    template <size_t TAP>
+    __attribute__((always_inline)) static inline void multiply_accumulate_outputs_tap(filter_sample_t *sum, const filter_sample_t *window)
+    {
+      if constexpr(0 != COEFFICIENT[TAP])
+      {
+        for(size_t i = 0; i < FIR_FILTER_BLOCK_OUTPUTS; i++)
+        {
+          sum[i] += COEFFICIENT[TAP]*window[TAP+i];
+        }
+      }
+    }
+    template <size_t... TAP>
+    __attribute__((always_inline)) static inline void multiply_accumulate_outputs(filter_sample_t *sum, const filter_sample_t *window, std::index_sequence<TAP...>)
+    {
+      (multiply_accumulate_outputs_tap<TAP>(sum, window), ...);
+    }
+    /* Returns the filtered sample of 'window', oldest to newest sample */
+    static inline filter_sample_t filter(const filter_sample_t *window)
+    {
+      return ((multiply_accumulate(window, std::make_index_sequence<ORDER>{})*GAIN_NUMERATOR)/GAIN_DENOMINATOR);
+    }
+    /* Writes the filtered samples of the 'count' consecutive windows from 'window' to 'output' */
+    static inline void filter_block(const filter_sample_t *window, size_t count, filter_sample_t *output)
+    {
+      size_t i = 0;
+      for(; (i+FIR_FILTER_BLOCK_OUTPUTS) <= count; i += FIR_FILTER_BLOCK_OUTPUTS)
+      {
+        filter_sample_t sum[FIR_FILTER_BLOCK_OUTPUTS] = {0};
+        multiply_accumulate_outputs(sum, &window[i], std::make_index_sequence<ORDER>{});
+        for(size_t output_index = 0; output_index < FIR_FILTER_BLOCK_OUTPUTS; output_index++)
+        {
+          output[i+output_index] = ((sum[output_index]*GAIN_NUMERATOR)/GAIN_DENOMINATOR);
+        }
+      }
+      for(; i < count; i++)
+      {
+        output[i] = filter(&window[i]);
+      }
+    }
+    /* Updates the moving average (or DC blocker) with 'count' raw samples, subtracting each estimate from 'output'.
+       The state is held in locals over the block and written back once */
+    inline void remove_dc_offset(const filter_sample_t *sample, size_t count, filter_sample_t *output)
+    {
+      if constexpr(MOVING_AVERAGE_ORDER > 0)
+      {
+        filter_order_t  next_write_local = moving_average_next_write;
+        filter_order_t  history_local    = moving_average_history;
+        filter_sample_t sum              = moving_average_sum;
+        filter_sample_t average          = moving_average;
+        for(size_t i = 0; i < count; i++)
+        {
+          sum -= moving_average_buffer[next_write_local];
+          sum += sample[i];
+          moving_average_buffer[next_write_local] = sample[i];
+          next_write_local = (((next_write_local+1) < MOVING_AVERAGE_ORDER) ? (next_write_local+1) : 0);
+          if(history_local < MOVING_AVERAGE_ORDER)
+          {
+            history_local++;
+          }
+          average    = (sum/((filter_sample_t)history_local));
+          output[i] -= average;
+        }
+        moving_average_next_write = next_write_local;
+        moving_average_history    = history_local;
+        moving_average_sum        = sum;
+        moving_average            = average;
+      }
+      else if constexpr(DC_BLOCKER_SHIFT > 0)
+      {
+        if(!dc_blocker_seeded && (count > 0))
+        {
+          dc_blocker_state  = (sample[0] * (1 << DC_BLOCKER_SHIFT));
+          dc_blocker_seeded = true;
+        }
+        filter_sample_t state   = dc_blocker_state;
+        filter_sample_t average = moving_average;
+        for(size_t i = 0; i < count; i++)
+        {
+          state     += (sample[i] - (state >> DC_BLOCKER_SHIFT));
+          average    = (state >> DC_BLOCKER_SHIFT);
+          output[i] -= average;
+        }
+        dc_blocker_state = state;
+        moving_average   = average;
+      }
+    }
+    /* Moves the last ORDER samples to the front once the history is full */
+    inline void history_wrap()
+    {
+      if((2*ORDER) == next_write)
+      {
+        memcpy(&history[0], &history[ORDER], (ORDER*sizeof(filter_sample_t)));
+        next_write = ORDER;
+      }
+    }
+
+  public:
+    /* Push incoming raw sample and compute new filtered sample */
+    inline void push_sample(filter_sample_t sample)
+    {
+      history[next_write++] = sample;
+      filtered_sample = filter(&history[next_write-ORDER]);
+      filter_sample_t output = filtered_sample;
+      remove_dc_offset(&sample, 1, &output);
+      history_wrap();
+    };
+    /* Push 'count' raw samples, writing each filtered sample with DC offset removed (if enabled) to 'output', which
+       may be 'sample' */
+    inline void push_samples(const filter_sample_t *sample, size_t count, filter_sample_t *output)
+    {
+      while(count > 0)
+      {
+        /* Copy as much of the block as fits behind the history, filter it from the buffer then remove the DC offset */
+        const size_t block = ((((2*ORDER)-next_write) < count) ? ((2*ORDER)-next_write) : count);
+        memcpy(&history[next_write], sample, (block*sizeof(filter_sample_t)));
+        filter_block(&history[next_write+1-ORDER], block, output);
+        filtered_sample = output[block-1];
+        remove_dc_offset(&history[next_write], block, output);
+        next_write += block;
+        history_wrap();
+
+        sample += block;
+        output += block;
+        count  -= block;
+      }
+    };
+    /* Returns current filtered sample */
+    inline filter_sample_t get_filtered_sample()                   const {return filtered_sample;};
+    /* Returns current filtered sample with DC offset removed via moving average */
+    inline filter_sample_t get_filtered_sample_dc_offset_removed() const {return (filtered_sample-moving_average);};
+    /* Returns current moving average (or DC blocker estimate) or 0 if DC offset removal is not enabled */
+    inline filter_sample_t get_moving_average()                    const {return moving_average;};
+};
+
+#endif /*__FIR_FILTER_STATIC_HPP__*/
\ No newline at end of file
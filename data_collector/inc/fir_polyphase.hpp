@@ -0,0 +1,55 @@
+#ifndef __FIR_POLYPHASE_HPP__
+#define __FIR_POLYPHASE_HPP__
+
+#include <cassert>
+#include <cstddef>
+
+#include "fir_filter.hpp"
+
+/* Polyphase FIR resampler, interpolates by 'interpolation' and decimates by 'decimation'
+    The coefficients are designed at the interpolated rate (input rate * interpolation) and split into
+    'interpolation' phases of ceil(order/interpolation) taps.  Each output only runs the taps of its phase on the
+    real input samples, so zero stuffed samples and outputs discarded by the decimation are never computed.  With
+    interpolation 1 this is a decimating filter computing every 'decimation'th output of the full rate filter.
+    Input samples are appended to a linear history of 2*phase_order with the last phase_order moved to the front once
+    it fills, so push_samples() copies a block behind the history once and runs every output straight from the
+    buffer.  Accumulates in 64 bits, the decimation filters have a large coefficient sum. */
+class fir_polyphase_c
+{
+  private:
+    /* Filter Configuration */
+    const filter_order_t  interpolation;
+    const filter_order_t  decimation;
+    const filter_order_t  phase_order;
+    const filter_sample_t gain_numerator;
+    const filter_sample_t gain_denominator;
+    filter_coefficient_t *phase_coefficient = nullptr; /* [phase][tap], oldest to newest sample */
+
+    /* Input history, the window of the last sample is the phase_order samples before next_write */
+    filter_sample_t      *history           = nullptr;
+    filter_order_t        next_write        = 0;
+    filter_order_t        next_phase        = 0;
+
+    filter_sample_t       filtered_sample   = 0;
+
+    size_t                filter_block(const filter_sample_t *window, size_t count, filter_sample_t *output);
+    void                  history_wrap();
+
+  public:
+    fir_polyphase_c(filter_order_t order, const filter_coefficient_t *coefficient, filter_order_t interpolation, filter_order_t decimation,
+                    filter_sample_t gain_numerator = 1, filter_sample_t gain_denominator = 1);
+    ~fir_polyphase_c();
+
+    /* Push incoming raw sample, writes the new filtered samples to 'output' and returns how many were written
+       (0 to get_max_output_count()) */
+    size_t                 push_sample(filter_sample_t sample, filter_sample_t *output);
+    /* Push 'count' raw samples, writes the new filtered samples to 'output' (up to count*get_max_output_count()) and
+       returns how many were written.  'output' may be 'sample' when get_max_output_count() is 1 */
+    size_t                 push_samples(const filter_sample_t *sample, size_t count, filter_sample_t *output);
+    /* Returns the most outputs a single push_sample() call can produce */
+    inline size_t          get_max_output_count() const {return ((interpolation + decimation - 1)/decimation);};
+    /* Returns last filtered sample */
+    inline filter_sample_t get_filtered_sample()  const {return filtered_sample;};
+};
+
+#endif /*__FIR_POLYPHASE_HPP__*/
\ No newline at end of file
@@ -0,0 +1,48 @@
+#ifndef __GOERTZEL_BANK_HPP__
+#define __GOERTZEL_BANK_HPP__
+
+#include <cstddef>
+#include <cstdint>
+
+#include "fir_filter.hpp"
+
+/* Goertzel coefficients 2*cos(w) are signed Q7.24 */
+typedef int32_t goertzel_coefficient_t;
+#define GOERTZEL_COEFFICIENT_FRACTION_BITS 24
+
+/* Energy of 'channel_count' channels at 'bin_count' frequencies over blocks of 'block_length' samples
+    Each channel and frequency is a Goertzel resonator s[n] = x[n] + 2*cos(w)*s[n-1] - s[n-2], one multiply per
+    sample per bin.  The resonator state is 64 bits so a full scale tone at a low frequency over a long block cannot
+    overflow.  At the end of each block the power |X(w)|^2 = s[n-1]^2 + s[n-2]^2 - 2*cos(w)*s[n-1]*s[n-2] is
+    converted to the mean square amplitude of the frequency component and the resonators restart.  Input should have
+    its DC offset removed, the bins are 1/block_length of the sample rate wide. */
+class goertzel_bank_c
+{
+  private:
+    /* Configuration */
+    const size_t            channel_count;
+    const size_t            bin_count;
+    const size_t            block_length;
+    goertzel_coefficient_t *coefficient = nullptr;
+
+    /* Resonator state s[n-1], s[n-2] per channel and bin */
+    int64_t                *state       = nullptr;
+    size_t                  block_fill  = 0;
+
+    /* Mean square amplitude per channel and bin of the last block */
+    float                  *power       = nullptr;
+
+  public:
+    /* 'frequency' holds 'bin_count' frequencies in Hz below sample_rate/2 */
+    goertzel_bank_c(size_t channel_count, size_t bin_count, const float *frequency, unsigned int sample_rate, size_t block_length);
+    ~goertzel_bank_c();
+
+    /* Push incoming samples, one per channel.  Returns true when a block completes and the powers are updated */
+    bool                  push_sample(const filter_sample_t *sample);
+    /* Returns the mean square amplitude of 'bin' of 'channel' over the last block, in (sample units)^2 */
+    inline float          get_power(size_t channel, size_t bin) const {return power[(channel*bin_count)+bin];};
+    inline size_t         get_bin_count()                       const {return bin_count;};
+    inline size_t         get_block_length()                    const {return block_length;};
+};
+
+#endif /*__GOERTZEL_BANK_HPP__*/
\ No newline at end of file
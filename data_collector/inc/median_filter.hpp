@@ -0,0 +1,58 @@
+#ifndef __MEDIAN_FILTER_HPP__
+#define __MEDIAN_FILTER_HPP__
+
+#include <cstddef>
+
+#include "fir_filter.hpp"
+
+/* Longest window push_samples() filters by sorted insertion, longer windows push each sample through the heap */
+#define MEDIAN_FILTER_BLOCK_WINDOW_MAX 15
+
+/* Running median over the last 'window_length' samples (odd) for removing single sample spikes
+    The window is a circular buffer of samples partitioned by a double heap over one array of window positions.
+    Position 0 is the median, negative positions are a max heap of the samples below it and positive positions a min
+    heap of the samples above it, heap children of position i are 2i and 2i+1 (or 2i and 2i-1 when negative).  Each
+    window slot records its heap position, so the sample leaving the window is replaced in place by the new sample and
+    sifted up or down, O(log n) per sample with no allocation after construction.  Until the window fills the median
+    is of the samples pushed so far.  The output is delayed by (window_length-1)/2 samples.  push_samples() filters
+    windows up to MEDIAN_FILTER_BLOCK_WINDOW_MAX by insertion into a sorted list of the window slots, sorted once per
+    block, which is cheaper than the heap for short windows, then rebuilds the heaps from the list once. */
+class median_filter_c
+{
+  private:
+    /* Configuration */
+    const size_t     window_length;
+
+    /* Window samples in arrival order, circular */
+    filter_sample_t *window       = nullptr;
+    size_t           next_write   = 0;
+    size_t           window_fill  = 0;
+    /* Heap position of each window slot, and window slot of each heap position.  'heap' points to the middle of
+       'heap_storage' so it is indexed by heap position */
+    int             *position     = nullptr;
+    int             *heap_storage = nullptr;
+    int             *heap         = nullptr;
+
+    inline bool     less(int i, int j)         const {return (window[heap[i]] < window[heap[j]]);};
+    inline int      max_heap_count()           const {return (int)(window_fill/2);};
+    inline int      min_heap_count()           const {return (int)((window_fill-1)/2);};
+    void            exchange(int i, int j);
+    void            min_heap_sift_down(int child);
+    void            max_heap_sift_down(int child);
+    bool            min_heap_sift_up(int i);
+    bool            max_heap_sift_up(int i);
+
+  public:
+    median_filter_c(size_t window_length);
+    ~median_filter_c();
+
+    /* Push incoming raw sample and update the median */
+    void                   push_sample(filter_sample_t sample);
+    /* Push 'count' raw samples, writing the median after each to 'output', which may be 'sample' */
+    void                   push_samples(const filter_sample_t *sample, size_t count, filter_sample_t *output);
+    /* Returns the median of the window */
+    inline filter_sample_t get_median()        const {return window[heap[0]];};
+    inline size_t          get_window_length() const {return window_length;};
+};
+
+#endif /*__MEDIAN_FILTER_HPP__*/
\ No newline at end of file
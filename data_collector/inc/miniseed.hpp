@@ -0,0 +1,74 @@
+#ifndef __MINISEED_HPP__
+#define __MINISEED_HPP__
+
+#include <cstddef>
+#include <cstdint>
+
+#include "steim1_encoder.hpp"
+
+/* miniSEED (SEED 2.4) data records
+    Fixed 512 byte records of a 48 byte fixed section data header, a blockette 1000 and seven Steim1 frames starting
+    at byte 64.  All header fields are big-endian. */
+
+#define MINISEED_RECORD_SIZE         512
+#define MINISEED_RECORD_LENGTH_EXP   9   /* log2(MINISEED_RECORD_SIZE) */
+#define MINISEED_DATA_OFFSET         64
+#define MINISEED_RECORD_FRAMES       ((MINISEED_RECORD_SIZE-MINISEED_DATA_OFFSET)/STEIM1_FRAME_SIZE)
+#define MINISEED_SEQUENCE_NUMBER_MAX 999999
+
+/* Network, station, location and channel codes of a data record, without padding or terminators */
+typedef struct
+{
+  const char *network;                  /* Up to 2 characters */
+  const char *station;                  /* Up to 5 characters */
+  const char *location;                 /* Up to 2 characters */
+  const char *channel;                  /* Up to 3 characters */
+} miniseed_nslc_s;
+
+typedef struct __attribute__((packed))
+{
+  char     sequence_number[6];          /* ASCII decimal, zero padded */
+  char     data_quality;                /* 'D' */
+  char     reserved;                    /* ' ' */
+  char     station[5];                  /* Space padded */
+  char     location[2];
+  char     channel[3];
+  char     network[2];
+  uint16_t start_year;                  /* BTIME */
+  uint16_t start_day_of_year;           /* 1-366 */
+  uint8_t  start_hour;
+  uint8_t  start_minute;
+  uint8_t  start_second;
+  uint8_t  start_unused;
+  uint16_t start_fraction;              /* 0.0001 seconds */
+  uint16_t sample_count;
+  int16_t  sample_rate_factor;
+  int16_t  sample_rate_multiplier;
+  uint8_t  activity_flags;
+  uint8_t  io_flags;
+  uint8_t  data_quality_flags;
+  uint8_t  blockette_count;
+  int32_t  time_correction;             /* 0.0001 seconds */
+  uint16_t data_offset;
+  uint16_t first_blockette_offset;
+} miniseed_fixed_header_s;
+
+typedef struct __attribute__((packed))
+{
+  uint16_t type;                        /* 1000 */
+  uint16_t next_blockette_offset;       /* 0 for the last blockette */
+  uint8_t  encoding;                    /* 10 for Steim1 */
+  uint8_t  word_order;                  /* 1 for big-endian */
+  uint8_t  record_length;               /* log2 of record length */
+  uint8_t  reserved;
+} miniseed_blockette_1000_s;
+
+static_assert(sizeof(miniseed_fixed_header_s)   == 48, "miniSEED fixed section data header must be 48 bytes");
+static_assert(sizeof(miniseed_blockette_1000_s) ==  8, "miniSEED blockette 1000 must be 8 bytes");
+
+/* Builds a MINISEED_RECORD_SIZE byte data record in 'record' from the completed block of 'encoder', which must be
+   MINISEED_RECORD_FRAMES frames.  'start_time_ms' is the time of the first sample in ms since unix epoch */
+void miniseed_build_record(uint8_t *record, const miniseed_nslc_s *nslc, uint32_t sequence_number,
+                           uint64_t start_time_ms, uint16_t sample_rate, const steim1_encoder_c *encoder);
+
+#endif /*__MINISEED_HPP__*/
\ No newline at end of file
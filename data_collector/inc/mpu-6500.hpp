@@ -1,6 +1,8 @@
 #ifndef __MPU_6500_HPP__
 #define __MPU_6500_HPP__
 
+#include <pico/time.h>
+
 #include "seismometer_i2c.hpp"
 #include "seismometer_types.hpp"
 
@@ -14,9 +16,27 @@ typedef struct
 
 typedef uint16_t mpu_6500_temperature_t;
 
+typedef struct
+{
+  uint32_t burst_count;    /* FIFO burst reads */
+  uint32_t frame_count;    /* FIFO frames read */
+  uint32_t overflow_count; /* FIFO resets after an overflow */
+} mpu_6500_fifo_stats_s;
+
 void mpu_6500_init(seismometer_i2c_handle_s *i2c);
 void mpu_6500_calibrate();
-void mpu_6500_read();
+/* Returns the time the latest accelerometer and temperature data was sampled, without waiting on the I2C bus.  With
+   SEISMOMETER_MPU_6500_FIFO this is the latest sample decimated by mpu_6500_fifo_interrupt(), otherwise this queues a
+   register read for the next call.  Must share a core and interrupt priority with the I2C engine interrupt */
+absolute_time_t mpu_6500_read();
+/* With SEISMOMETER_MPU_6500_FIFO, resets and enables the FIFO once mpu_6500_fifo_interrupt() is serviced */
+void mpu_6500_fifo_start();
+/* With SEISMOMETER_MPU_6500_FIFO, call from the INT pin rising edge interrupt (one per FIFO sample) at 'time'.  Every
+   SEISMOMETER_MPU_6500_FIFO_BURST_FRAMES interrupts (or every decimated sample if sooner) a FIFO burst read is queued on
+   the I2C engine and decimated as it completes.  Must share a core and interrupt priority with mpu_6500_read() and the
+   I2C engine interrupt */
+void mpu_6500_fifo_interrupt(absolute_time_t time);
+void mpu_6500_get_fifo_stats(mpu_6500_fifo_stats_s *stats);
 void mpu_6500_accelerometer_data_raw(mpu_6500_accelerometer_data_s *accelerometer_data);
 void mpu_6500_accelerometer_data    (mpu_6500_accelerometer_data_s *accelerometer_data);
 mpu_6500_temperature_t mpu_6500_temperature();
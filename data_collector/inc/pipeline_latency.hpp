@@ -0,0 +1,54 @@
+#ifndef __PIPELINE_LATENCY_HPP__
+#define __PIPELINE_LATENCY_HPP__
+
+#include <cstdint>
+
+#include <pico/time.h>
+
+#include "seismometer_types.hpp"
+
+/* Sample pipeline latency instrumentation
+    Each stage of a sample tick, from the sample timer firing to its data being written to the SD card, is recorded
+    into a fixed bin histogram (SEISMOMETER_PIPELINE_LATENCY_BINS bins of a per stage width plus an overflow bin) with
+    exact min/max.  Pipeline stages are measured from the time the sample timer fired for the tick, which is kept per
+    sample index so core 0 can look it up when it handles the tick.  Every stage has a single writer so recording is
+    lock-free, a reset is requested by the reader and applied by the writer at its next record. */
+
+typedef enum
+{
+  PIPELINE_LATENCY_TIMER,     /* Sample timer callback entry after its scheduled time (jitter) */
+  PIPELINE_LATENCY_ADC_READ,  /* adc_manager_read() duration */
+  PIPELINE_LATENCY_MPU_READ,  /* mpu_6500_read() duration */
+  PIPELINE_LATENCY_ENQUEUE,   /* Timer fire to samples committed to the sample ring */
+  PIPELINE_LATENCY_DEQUEUE,   /* Timer fire to core 0 taking the samples from the ring */
+  PIPELINE_LATENCY_HANDLED,   /* Timer fire to core 0 finishing filtering and logging the samples */
+  PIPELINE_LATENCY_SD_COMMIT, /* First byte staged in a sample file staging buffer to the buffer written to FatFs */
+  PIPELINE_LATENCY_STAGE_MAX,
+} pipeline_latency_stage_e;
+
+typedef struct
+{
+  uint32_t count;
+  uint32_t overflow_count; /* Latencies beyond the last bin */
+  uint32_t min_us;
+  uint32_t max_us;
+  uint32_t p50_us;         /* Percentiles are the upper edge of the bin they fall in, at most max_us */
+  uint32_t p90_us;
+  uint32_t p99_us;
+} pipeline_latency_summary_s;
+
+/* Sets the scheduled time of the sample timer's fire for 'index', later fires are 'period_us' apart */
+void     pipeline_latency_timer_start(absolute_time_t fire_time, sample_index_t index, uint32_t period_us);
+/* Called on entry to the sample timer callback for 'index', records the timer jitter and returns the fire time
+   (time_us_32()) the other stages of the tick are measured from */
+uint32_t pipeline_latency_timer_fire(sample_index_t index);
+/* Returns the fire time of the sample timer tick for 'index', valid while the tick's samples are in the sample ring */
+uint32_t pipeline_latency_fire_us(sample_index_t index);
+/* Records 'latency_us' for 'stage', must only be called from the stage's single context */
+void     pipeline_latency_record(pipeline_latency_stage_e stage, uint32_t latency_us);
+/* Summarizes the histogram of 'stage', and requests it is reset if 'reset' */
+void     pipeline_latency_get_summary(pipeline_latency_stage_e stage, pipeline_latency_summary_s *summary, bool reset);
+/* Logs a summary line per stage, and the non-empty bins if 'bins'.  Histograms are reset if 'reset' */
+void     pipeline_latency_log(bool bins, bool reset);
+
+#endif /*__PIPELINE_LATENCY_HPP__*/
\ No newline at end of file
@@ -8,10 +8,14 @@
 #include "seismometer_types.hpp"
 
 typedef void (*rtc_ds3231_alarm_cb)(void* user_data_ptr);
+typedef void (*rtc_ds3231_tick_cb)(absolute_time_t reference, void* user_data_ptr);
 
 void            rtc_ds3231_init(seismometer_i2c_handle_s *i2c);
-/* Reads from the RTC with given reference time */
+/* Queues a read of the RTC with given reference time on the I2C engine.  Once complete (in the I2C engine interrupt)
+   the built in RTC and clock discipline are updated and the alarm and tick callbacks are called */
 void            rtc_ds3231_read(absolute_time_t reference);
+/* Reads from the RTC with given reference time and waits for the read to complete, for init and thread code */
+void            rtc_ds3231_read_blocking(absolute_time_t reference);
 /* Sets the RTC with given time (ms since unix epoch) */
 void            rtc_ds3231_set(seismometer_time_t time);
 /* Returns system reference time for current time from RTC filled in *time */
@@ -19,7 +23,10 @@ absolute_time_t rtc_ds3231_get_time(seismometer_time_s *time);
 /* Configure alarm callbacks */
 void            rtc_ds3231_set_alarm1_cb(rtc_ds3231_alarm_cb, void* user_data_ptr);
 void            rtc_ds3231_set_alarm2_cb(rtc_ds3231_alarm_cb, void* user_data_ptr);
+/* Configure the callback at the end of every RTC read */
+void            rtc_ds3231_set_tick_cb(rtc_ds3231_tick_cb, void* user_data_ptr);
 
+/* Returns ms since unix epoch for system time t, disciplined to the RTC ticks (see clock_discipline.hpp), lock-free and safe from either core */
 uint64_t        rtc_ds3231_absolute_time_to_epoch_ms(absolute_time_t t);
 
 #endif //__RTC_DS3231_HPP__
\ No newline at end of file
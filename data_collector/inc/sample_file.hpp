@@ -0,0 +1,62 @@
+#ifndef __SAMPLE_FILE_HPP__
+#define __SAMPLE_FILE_HPP__
+
+#include <cstddef>
+#include <cstdint>
+
+#include "seismometer_types.hpp"
+
+typedef enum
+{
+  SAMPLE_FILE_FORMAT_ASCII,  /* One 'S|<key>|<index>|<timestamp>|<data>' line per sample */
+  SAMPLE_FILE_FORMAT_BINARY, /* Packed binary records as defined in sample_record.hpp */
+  SAMPLE_FILE_FORMAT_STEIM1, /* Packed binary records with samples as Steim1 compressed blocks per key */
+  SAMPLE_FILE_FORMAT_MINISEED, /* 512 byte miniSEED records, Steim1 compressed, one channel per key */
+  SAMPLE_FILE_FORMAT_MAX,
+} sample_file_format_e;
+
+/* Behaviour of the staging buffer at each RTC tick */
+#define SAMPLE_FILE_TICK_FLUSH_NONE    0 /* Only write when the staging buffer is full or the file is closed */
+#define SAMPLE_FILE_TICK_FLUSH_SECTORS 1 /* Write all complete sectors and sync, keeping writes sector aligned */
+#define SAMPLE_FILE_TICK_FLUSH_ALL     2 /* Write all staged data and sync */
+
+typedef struct
+{
+  uint32_t bytes_pending;     /* Bytes staged or queued but not yet written to the SD card */
+  uint32_t bytes_pending_max; /* Highest bytes_pending seen by the writer */
+  uint32_t bytes_dropped;     /* Bytes dropped because every staging buffer was waiting on the SD card */
+  uint32_t requests_dropped;  /* Tick/close/rollover requests dropped because the request queue was full */
+  uint32_t stall_us_last;     /* Duration of the last f_write/f_sync */
+  uint32_t stall_us_max;      /* Longest f_write/f_sync */
+  uint32_t stall_count;       /* Number of f_write/f_sync calls taking SEISMOMETER_SAMPLE_FILE_STALL_THRESHOLD_US or longer */
+} sample_file_stats_s;
+
+/* Sample data file writes are split between two cores.  The sample handler (core 0) stages data in RAM buffers
+   and hands them to the sample file writer (core 1) which owns FatFs, so SD card stalls never block the sample queue */
+
+/* Initializes the staging buffers and request queue, must be called before either core uses the sample file */
+void                 sample_file_init();
+/* Sample file writer main loop, never returns */
+void                 sample_file_writer_main();
+
+/* Stages 'length' bytes for the sample data file.  Whole records are dropped if all staging buffers are waiting on the SD card */
+void                 sample_file_write(const void *data, size_t length);
+/* Periodic (RTC tick) hand-off of staged data per SEISMOMETER_SAMPLE_FILE_TICK_FLUSH, the writer mounts, opens and syncs as needed */
+void                 sample_file_tick();
+/* Closes the current sample data file, compressing it if enabled, and opens a new date-stamped file */
+void                 sample_file_rollover();
+/* Returns the current sample data file format */
+sample_file_format_e sample_file_get_format();
+/* Sets the sample data file format.  The current file is closed if the format changes and reopened at the next RTC tick */
+void                 sample_file_set_format(sample_file_format_e format);
+/* Opens a new time-stamped binary event file, closing any open event file.  The event file shares the staging buffers
+   but leaves SEISMOMETER_SAMPLE_FILE_EVENT_BUFFER_RESERVE of them to the sample data file */
+void                 sample_file_event_open();
+/* Stages 'length' bytes of binary records for the event file.  Whole records are dropped if no staging buffer is free */
+void                 sample_file_event_write(const void *data, size_t length);
+/* Hands off the staged event data and closes the event file */
+void                 sample_file_event_close();
+/* Returns sample data file writer statistics */
+void                 sample_file_get_stats(sample_file_stats_s *stats);
+
+#endif /*__SAMPLE_FILE_HPP__*/
\ No newline at end of file
@@ -1,11 +1,16 @@
 #ifndef __SAMPLE_HANDLER_HPP__
 #define __SAMPLE_HANDLER_HPP__
 
+#include <cstddef>
+
 #include "seismometer_types.hpp"
 
-void sample_file_open();
-void sample_file_close();
+/* Sets up the filters, spectra and decimators for the sample rate, must follow sample_rate_init() */
+void sample_handler_init     ();
 void set_sample_handler_epoch(absolute_time_t time);
 void sample_handler          (const seismometer_sample_s *sample);
+/* Handles 'count' consecutive samples, acceleration and pendulum samples between ticks and events are filtered in
+   blocks of up to SEISMOMETER_SAMPLE_HANDLER_BATCH_SIZE */
+void sample_handler_batch    (const seismometer_sample_s *samples, size_t count);
 
 #endif /*__SAMPLE_HANDLER_HPP__*/
\ No newline at end of file
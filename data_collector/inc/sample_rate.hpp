@@ -0,0 +1,30 @@
+#ifndef __SAMPLE_RATE_HPP__
+#define __SAMPLE_RATE_HPP__
+
+#include <cstdint>
+
+/* Primary sample rate, selected at boot from the EEPROM sampler config
+    The sample timer, the ADC and MPU-6500 acquisition and every filter, detector and spectrum running at the primary
+    rate are set up for the selected rate as they initialize, each picking the coefficient set designed for it.  The
+    decimated pendulum channels keep their 20Hz, 10Hz and 1Hz rates.  A new rate is stored in the EEPROM and applied by
+    rebooting, so no stage ever runs with the state of another rate. */
+typedef enum
+{
+  SAMPLE_RATE_50HZ,
+  SAMPLE_RATE_100HZ,
+  SAMPLE_RATE_200HZ,
+  SAMPLE_RATE_500HZ,
+  SAMPLE_RATE_MAX,
+} sample_rate_e;
+
+/* Selects the rate stored in the EEPROM, or SEISMOMETER_SAMPLE_RATE_DEFAULT if it is not supported.  Must follow
+   eeprom_init() and precede every other module init */
+void          sample_rate_init();
+/* Stores 'hz' in the EEPROM and reboots to apply it.  Returns false if 'hz' is not a supported rate or the write
+   failed, true without rebooting if it is the current rate */
+bool          sample_rate_set(uint32_t hz);
+sample_rate_e sample_rate_get();
+uint32_t      sample_rate_hz();
+uint32_t      sample_rate_period_us();
+
+#endif /*__SAMPLE_RATE_HPP__*/
\ No newline at end of file
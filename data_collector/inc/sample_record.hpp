@@ -0,0 +1,126 @@
+#ifndef __SAMPLE_RECORD_HPP__
+#define __SAMPLE_RECORD_HPP__
+
+#include <cstdint>
+
+#include "seismometer_types.hpp"
+
+/* Binary sample file format
+    A binary sample file is a stream of packed little-endian records.  Every record starts with a one byte
+    record type (sample_record_type_e).  A file header record is written each time the sample file is opened,
+    so a file appended to after a reboot contains several headers. */
+
+#define SAMPLE_RECORD_MAGIC        "SLSR"
+#define SAMPLE_RECORD_MAGIC_LENGTH 4
+
+enum
+{
+  SAMPLE_RECORD_VERSION_INVALID,
+  SAMPLE_RECORD_VERSION_1,
+  SAMPLE_RECORD_VERSION_2,              /* Steim1 blocks carry their sample rate */
+  SAMPLE_RECORD_VERSION_MAX,
+
+  SAMPLE_RECORD_VERSION_CURRENT = (SAMPLE_RECORD_VERSION_MAX-1),
+};
+
+typedef enum
+{
+  SAMPLE_RECORD_TYPE_INVALID     = 0,
+  SAMPLE_RECORD_TYPE_FILE_HEADER = 1,
+  SAMPLE_RECORD_TYPE_SAMPLE      = 2,
+  SAMPLE_RECORD_TYPE_STEIM1_BLOCK = 3,
+  SAMPLE_RECORD_TYPE_FRAME       = 4,
+  SAMPLE_RECORD_TYPE_SPECTRUM    = 5,
+  SAMPLE_RECORD_TYPE_GOERTZEL    = 6,
+  SAMPLE_RECORD_TYPE_MAX,
+} sample_record_type_e;
+
+typedef struct __attribute__((packed))
+{
+  uint8_t  type;                        /* SAMPLE_RECORD_TYPE_FILE_HEADER */
+  uint8_t  magic[SAMPLE_RECORD_MAGIC_LENGTH];
+  uint8_t  version;
+  uint8_t  header_size;                 /* Size of this header in bytes */
+  uint8_t  sample_record_size;          /* Size of each sample record (or Steim1 block header) in bytes */
+  uint16_t sample_rate;                 /* Primary sample rate in Hz */
+  uint64_t open_time;                   /* ms since unix epoch when the file was opened */
+} sample_record_file_header_s;
+
+typedef struct __attribute__((packed))
+{
+  uint8_t  type;                        /* SAMPLE_RECORD_TYPE_SAMPLE */
+  uint8_t  key;                         /* sample_log_key_e */
+  uint32_t index;
+  uint64_t timestamp;                   /* ms since unix epoch */
+  int32_t  data;
+} sample_record_sample_s;
+
+/* Block of consecutive samples of one key, followed by 'frame_count' big-endian Steim1 frames (see steim1_encoder.hpp).
+   Sample i has index 'index'+i and was taken at 'timestamp'+(i*1000/sample_rate), the rate of the key rather than the
+   primary rate of the file header as decimated keys are slower */
+typedef struct __attribute__((packed))
+{
+  uint8_t  type;                        /* SAMPLE_RECORD_TYPE_STEIM1_BLOCK */
+  uint8_t  key;                         /* sample_log_key_e */
+  uint8_t  frame_count;                 /* Number of 64 byte Steim1 frames following this header */
+  uint16_t sample_rate;                 /* Sample rate of the key in Hz */
+  uint16_t sample_count;
+  uint32_t index;                       /* Index of the first sample */
+  uint64_t timestamp;                   /* ms since unix epoch of the first sample */
+} sample_record_steim1_block_s;
+
+/* Samples of every key taken at one index and time, followed by an int32_t per key set in 'key_mask' in key order */
+typedef struct __attribute__((packed))
+{
+  uint8_t  type;                        /* SAMPLE_RECORD_TYPE_FRAME */
+  uint16_t key_mask;                    /* Bit per sample_log_key_e */
+  uint32_t index;
+  uint64_t timestamp;                   /* ms since unix epoch */
+} sample_record_frame_s;
+
+/* Welch averaged power spectral density of one key, followed by 'band_count' sample_record_spectrum_band_s.  Band i
+   covers FFT bins first_bin[i] to first_bin[i+1]-1, the last band ends at bin fft_length/2.  Bin k is at
+   k*sample_rate/fft_length Hz */
+typedef struct __attribute__((packed))
+{
+  uint8_t  type;                        /* SAMPLE_RECORD_TYPE_SPECTRUM */
+  uint8_t  key;                         /* sample_log_key_e */
+  uint16_t band_count;
+  uint16_t segment_count;               /* Number of segments averaged */
+  uint16_t fft_length;
+  uint64_t timestamp;                   /* ms since unix epoch of the last sample */
+} sample_record_spectrum_s;
+
+typedef struct __attribute__((packed))
+{
+  uint16_t first_bin;
+  int16_t  psd_cdb;                     /* Mean PSD of the band in centi-dB relative to 1 (sample unit)^2/Hz */
+} sample_record_spectrum_band_s;
+
+/* Goertzel energy of one key over 'block_length' samples, followed by 'bin_count' sample_record_goertzel_bin_s */
+typedef struct __attribute__((packed))
+{
+  uint8_t  type;                        /* SAMPLE_RECORD_TYPE_GOERTZEL */
+  uint8_t  key;                         /* sample_log_key_e */
+  uint8_t  bin_count;
+  uint16_t block_length;                /* Number of samples, the bins are sample_rate/block_length wide */
+  uint64_t timestamp;                   /* ms since unix epoch of the last sample */
+} sample_record_goertzel_s;
+
+typedef struct __attribute__((packed))
+{
+  uint32_t frequency_mhz;
+  int16_t  power_cdb;                   /* Mean square amplitude in centi-dB relative to 1 (sample unit)^2 */
+} sample_record_goertzel_bin_s;
+
+static_assert(sizeof(sample_record_file_header_s) == 18, "Binary sample file header size changed, update SAMPLE_RECORD_VERSION");
+static_assert(sizeof(sample_record_sample_s)      == 18, "Binary sample record size changed, update SAMPLE_RECORD_VERSION");
+static_assert(sizeof(sample_record_steim1_block_s) == 19, "Binary Steim1 block record size changed, update SAMPLE_RECORD_VERSION");
+static_assert(sizeof(sample_record_frame_s)       == 15, "Binary frame record size changed, update SAMPLE_RECORD_VERSION");
+static_assert(sizeof(sample_record_spectrum_s)    == 16, "Binary spectrum record size changed, update SAMPLE_RECORD_VERSION");
+static_assert(sizeof(sample_record_spectrum_band_s) == 4, "Binary spectrum band size changed, update SAMPLE_RECORD_VERSION");
+static_assert(sizeof(sample_record_goertzel_s)    == 13, "Binary Goertzel record size changed, update SAMPLE_RECORD_VERSION");
+static_assert(sizeof(sample_record_goertzel_bin_s) == 6, "Binary Goertzel bin size changed, update SAMPLE_RECORD_VERSION");
+static_assert(SAMPLE_LOG_MAX_KEY <= 16, "Binary frame record key mask is 16 bits");
+
+#endif /*__SAMPLE_RECORD_HPP__*/
\ No newline at end of file
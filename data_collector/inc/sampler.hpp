@@ -5,14 +5,27 @@
 #include <pico/util/queue.h>
 
 #include "seismometer_config.hpp"
+#include "seismometer_types.hpp"
+#include "spsc_ring.hpp"
+
+/* Samples and RTC ticks from the core 1 sampling interrupts */
+typedef spsc_ring_c<seismometer_sample_s, SEISMOMETER_SAMPLE_QUEUE_SIZE> sample_ring_c;
 
 typedef struct
 {
-  semaphore_t *boot_semaphore;
-  queue_t     *sample_queue;
+  semaphore_t   *boot_semaphore;
+  sample_ring_c *sample_ring;
+  queue_t       *event_queue; /* RTC alarms */
 } sample_thread_args_s;
 
+typedef struct
+{
+  uint32_t sample_drop_count; /* Sample ticks dropped as the sample ring was full */
+  uint32_t tick_drop_count;   /* RTC ticks dropped as the sample ring was full */
+} sampler_stats_s;
+
 void sampler_thread_pass_args(sample_thread_args_s *args);
 void sampler_thread_main();
+void sampler_get_stats(sampler_stats_s *stats);
 
 #endif /*__SAMPLER_HPP__*/
\ No newline at end of file
@@ -8,6 +8,13 @@ const char *sd_card_spi_mount (const unsigned int sd_index);
 bool        sd_card_spi_unmount(const unsigned int sd_index);
 
 #ifdef ENABLE_ZLIB_DATA_FILE_COMPRESSION
+#define COMPRESSED_FILE_FILENAME_EXTENSION_LENGTH 3 /* includes '.' seperator */
+#define COMPRESSED_FILE_FILENAME_FORMAT           "%s.gz"
+/* deflate parameters shared by file compression and the streaming sample file compression */
+#define SEISMOMETER_ZLIB_COMPRESSION_LEVEL        2
+#define SEISMOMETER_ZLIB_DEFLATE_WINDOW_BITS      9
+#define SEISMOMETER_ZLIB_DEFLATE_MEM_LEVEL        2
+
 bool        sd_card_spi_compress_file(const char* filename);
 #endif
 
@@ -1,13 +1,111 @@
 #ifndef __SEISMOMETER_CONFIG_HPP__
 #define __SEISMOMETER_CONFIG_HPP__
 
-/* Primary data sample rate in Hz */
-#define SEISMOMETER_SAMPLE_RATE        100
-#define SEISMOMETER_SAMPLE_PERIOD_US   ((1000*1000)/SEISMOMETER_SAMPLE_RATE)
+/* Primary data sample rate in Hz until one is stored in the EEPROM, 50, 100, 200 or 500 (see sample_rate.hpp and
+   SAMPLERATE command).  RAM buffers sized in seconds of samples (event pre-trigger, sample file staging) are sized for
+   this rate and hold proportionally less time at higher rates */
+#define SEISMOMETER_SAMPLE_RATE_DEFAULT 100
+/* Hardware alarm for the core 1 sample timer pool, the default alarm pool (core 0) uses alarm 3 */
+#define SEISMOMETER_SAMPLE_ALARM_NUM   2
 #define SEISMOMETER_WATCHDOG_PERIOD_MS 1000
 //#define SEISMOMETER_WATCHDOG_PERIOD_MS 8000
 
-#define SEISMOMETER_SAMPLE_QUEUE_SIZE 1024
+/* MPU-6500 acquisition, 1 samples the accelerometer at 1kHz (500Hz at a 50Hz sample rate) into its FIFO and decimates
+   it to the sample rate with an anti-alias filter, the FIFO is burst read every BURST_FRAMES data ready interrupts (INT
+   on GPIO 21), or every decimated sample if sooner.  0 reads the data registers once per sample instead, aliasing
+   anything above the Nyquist frequency */
+#define SEISMOMETER_MPU_6500_FIFO              1
+#define SEISMOMETER_MPU_6500_FIFO_BURST_FRAMES 10
+
+/* Pendulum ADC acquisition, 1 free runs the RP2040 ADC round robin over the pendulum channels into a DMA ring at
+   2^OVERSAMPLE_SHIFT conversions per channel per sample and decimates them to the sample rate with an order
+   CIC_ORDER CIC filter (1 is a plain average), the round robin skew between channels is interpolated out.  Holds the
+   SMPS in PWM mode.  0 reads each channel once per sample tick with blocking conversions instead */
+#define SEISMOMETER_ADC_DMA              1
+#define SEISMOMETER_ADC_OVERSAMPLE_SHIFT 7
+#define SEISMOMETER_ADC_CIC_ORDER        2
+
+/* Sampler to core 0 ring size (power of 2), and queue size for the stdio and RTC alarm events */
+#define SEISMOMETER_SAMPLE_QUEUE_SIZE       1024
+#define SEISMOMETER_EVENT_QUEUE_SIZE        16
+/* Most acceleration or pendulum samples filtered as one block when core 0 drains a sample ring backlog */
+#define SEISMOMETER_SAMPLE_HANDLER_BATCH_SIZE 32
+/* Sample pipeline latency histograms (see pipeline_latency.hpp and LATENCY command), fixed width bins per stage plus
+   an overflow bin.  Summaries are logged and the histograms restarted every minute */
+#define SEISMOMETER_PIPELINE_LATENCY_BINS     64
+
+/* DC offset removal of the filtered acceleration and pendulum channels, single pole DC blocker with a corner near
+   fs/(2*pi*2^SHIFT) (0.06Hz at 100Hz).  0 selects a 512 sample moving average instead, 512 samples of history per channel */
+#define SEISMOMETER_FILTER_DC_BLOCKER_SHIFT 8
+/* Running median (odd window length) ahead of the acceleration and pendulum FIR filters, removes single sample spikes
+   from I2C glitches and ADC noise before they smear through the filters.  Delays the filtered channels by
+   (WINDOW-1)/2 samples, 1 disables it.  Raw channels are not affected */
+#define SEISMOMETER_FILTER_MEDIAN_WINDOW 5
+/* Filtered channels (bits of sample_log_key_e, e.g. (1<<SAMPLE_LOG_PENDULUM_FILTERED)) low passed by the 4th order
+   Butterworth biquad cascade instead of the FIR filter, 10 multiplies per sample instead of 64 at the cost of
+   non-linear phase.  The biquads are designed at 100Hz so other sample rates keep the FIR, and they remove the DC
+   offset with the DC blocker only */
+#define SEISMOMETER_FILTER_IIR_KEY_MASK 0
+
+/* Welch PSD spectrum records of the raw acceleration X/Y/Z and 100x pendulum channels, see SPECTRUM commands.  Segments
+   of FFT_LENGTH samples (power of 2) overlap by half and SEGMENTS segments are averaged per record, 256 and 47 give
+   0.39Hz bins about once a minute at 100Hz.  BANDS_DEFAULT logs the mean PSD of octave bands at boot instead of every bin */
+#define SEISMOMETER_SPECTRUM_FFT_LENGTH    256
+#define SEISMOMETER_SPECTRUM_SEGMENTS      47
+#define SEISMOMETER_SPECTRUM_BANDS_DEFAULT true
+
+/* Goertzel band energy records of the filtered acceleration and pendulum channels, see GOERTZEL commands.  The energy
+   at each frequency (Hz, below the Nyquist frequency) is logged once per second, so each bin is 1Hz wide */
+#define SEISMOMETER_GOERTZEL_FREQUENCIES_HZ {1.0f, 2.0f, 3.0f, 4.0f, 5.0f}
+
+/* STA/LTA event trigger on the filtered acceleration magnitude and pendulum channels, see EVENTCAPTURE command.  An
+   event starts when either channel's STA/LTA ratio (in tenths) reaches TRIGGER_RATIO_X10 and ends when both are below
+   DETRIGGER_RATIO_X10 */
+#define SEISMOMETER_STA_LTA_STA_S               1
+#define SEISMOMETER_STA_LTA_LTA_S               30
+#define SEISMOMETER_STA_LTA_TRIGGER_RATIO_X10   40
+#define SEISMOMETER_STA_LTA_DETRIGGER_RATIO_X10 15
+/* Raw samples from PRE_TRIGGER_S before the trigger to POST_TRIGGER_S after the detrigger are written to a binary
+   event file, the pre-trigger samples are held in RAM at 32 bytes per sample.  CAPTURE_DEFAULT enables it at boot */
+#define SEISMOMETER_EVENT_PRE_TRIGGER_S   10
+#define SEISMOMETER_EVENT_POST_TRIGGER_S  30
+#define SEISMOMETER_EVENT_CAPTURE_DEFAULT true
+
+/* Group samples taken at the same index and time into one frame line/record at boot, see SAMPLEFRAMES command */
+#define SEISMOMETER_SAMPLE_FRAMES_DEFAULT true
+
+/* Format of the SD card sample data file at boot, see sample_file_format_e */
+#define SEISMOMETER_SAMPLE_FILE_FORMAT_DEFAULT SAMPLE_FILE_FORMAT_ASCII
+/* Size of the RAM staging buffer in front of the sample data file in bytes, must be a multiple of the 512 byte sector size */
+#define SEISMOMETER_SAMPLE_FILE_BUFFER_SIZE    (8*512)
+/* Worst case SD card write stall to ride out without dropping data (card internal garbage collection) */
+#define SEISMOMETER_SAMPLE_FILE_MAX_STALL_MS   500
+/* Worst case sample data file rate in bytes per second, every key logged as ASCII */
+#define SEISMOMETER_SAMPLE_FILE_MAX_DATA_RATE  (SEISMOMETER_SAMPLE_RATE_DEFAULT*SAMPLE_LOG_MAX_KEY*49)
+/* Number of staging buffers, enough to hold the data produced during the worst case stall plus the buffers being filled, written and carried over */
+#define SEISMOMETER_SAMPLE_FILE_BUFFER_COUNT   (((SEISMOMETER_SAMPLE_FILE_MAX_DATA_RATE*SEISMOMETER_SAMPLE_FILE_MAX_STALL_MS)/(1000*SEISMOMETER_SAMPLE_FILE_BUFFER_SIZE))+3)
+/* Staging buffers the event file always leaves free for the sample data file */
+#define SEISMOMETER_SAMPLE_FILE_EVENT_BUFFER_RESERVE 3
+/* f_write/f_sync calls taking this long or longer are counted as stalls */
+#define SEISMOMETER_SAMPLE_FILE_STALL_THRESHOLD_US (100*1000)
+/* Staging buffer flush behaviour at each RTC tick, see SAMPLE_FILE_TICK_FLUSH_* */
+#define SEISMOMETER_SAMPLE_FILE_TICK_FLUSH     SAMPLE_FILE_TICK_FLUSH_SECTORS
+
+/* Sample timestamp discipline to the RTC tick, see clock_discipline.hpp.  Phase errors are slewed out over SLEW_S
+   seconds with the timer rate held within +-MAX_PPM, errors of STEP_US or more step the time.  The timer frequency
+   estimate averages tick intervals over 2^FREQUENCY_SHIFT ticks */
+#define SEISMOMETER_CLOCK_DISCIPLINE_SLEW_S          8
+#define SEISMOMETER_CLOCK_DISCIPLINE_STEP_US         (100*1000)
+#define SEISMOMETER_CLOCK_DISCIPLINE_MAX_PPM         500
+#define SEISMOMETER_CLOCK_DISCIPLINE_FREQUENCY_SHIFT 4
+
+/* SEED network and station codes of SAMPLE_FILE_FORMAT_MINISEED records, 'XX' is the unregistered network code */
+#define SEISMOMETER_MINISEED_NETWORK "XX"
+#define SEISMOMETER_MINISEED_STATION "SLAB"
+
+/* With ENABLE_ZLIB_DATA_FILE_COMPRESSION, size of the deflate output buffer and RTC ticks between deflate flush points */
+#define SEISMOMETER_SAMPLE_FILE_DEFLATE_BUFFER_SIZE  (2*512)
+#define SEISMOMETER_SAMPLE_FILE_DEFLATE_FLUSH_TICKS  10
 
 //#define SEISMOMETER_SAMPLE_DEBUG_PRINT
 
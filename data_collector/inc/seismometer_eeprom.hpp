@@ -10,10 +10,16 @@ typedef struct  __attribute__((packed))
   sample_log_key_mask_t key_mask_sd;
 } seismometer_eeprom_sample_log_config_s;
 
+typedef struct  __attribute__((packed))
+{
+  uint16_t sample_rate_hz; /* Primary sample rate, see sample_rate.hpp */
+} seismometer_eeprom_sampler_config_s;
+
 enum
 {
   SEISMOMETER_EEPROM_VERSION_INVALID,
   SEISMOMETER_EEPROM_VERSION_1,
+  SEISMOMETER_EEPROM_VERSION_2, /* Adds the sampler config, version 1 EEPROMs are upgraded with the default */
   SEISMOMETER_EEPROM_VERSION_MAX,
 };
 
@@ -31,11 +37,15 @@ typedef struct __attribute__((packed))
 {
   seismometer_eeprom_header_s            header;
   seismometer_eeprom_sample_log_config_s sample_log_config;
+  seismometer_eeprom_sampler_config_s    sampler_config;
 } seismometer_eeprom_data_s;
 
 void eeprom_init(seismometer_i2c_handle_s *i2c_handle);
 bool eeprom_request_reset();
 
 const seismometer_eeprom_sample_log_config_s *eeprom_get_sample_log_config();
+const seismometer_eeprom_sampler_config_s    *eeprom_get_sampler_config();
+/* Writes 'config' to the EEPROM, returns false if the write failed */
+bool eeprom_set_sampler_config(const seismometer_eeprom_sampler_config_s *config);
 
 #endif /* __SEISMOMETER_EEPROM_HPP__ */
\ No newline at end of file
@@ -1,15 +1,106 @@
 #ifndef __SEISMOMETER_I2C_HPP__
 #define __SEISMOMETER_I2C_HPP__
 
+#include <cstddef>
+#include <cstdint>
+
 #include <hardware/i2c.h>
-#include <pico/mutex.h>
+#include <pico/critical_section.h>
+
+/* Asynchronous I2C transaction engine
+    Drivers queue transactions (a write and/or a read after a repeated start) on a shared bus handle and are called back
+    on completion.  Transactions run one at a time in priority order, so a sensor read waits for at most the
+    transaction already on the bus rather than a whole housekeeping sequence.  The engine is driven by the I2C
+    interrupt once seismometer_i2c_enable_irq() has been called on a core, completion callbacks run in that interrupt.
+    Before that (boot) the blocking wrapper polls the engine itself.  Transactions are owned by the caller and must stay
+    valid until complete, the engine does not allocate. */
+
+/* Highest priority first */
+typedef enum
+{
+  SEISMOMETER_I2C_PRIORITY_SENSOR,       /* Sample data, MPU-6500 FIFO bursts */
+  SEISMOMETER_I2C_PRIORITY_TIMING,       /* RTC tick reads */
+  SEISMOMETER_I2C_PRIORITY_HOUSEKEEPING, /* Configuration, EEPROM, blocking transfers */
+  SEISMOMETER_I2C_PRIORITY_MAX,
+} seismometer_i2c_priority_e;
+
+typedef enum
+{
+  SEISMOMETER_I2C_STATUS_IDLE,
+  SEISMOMETER_I2C_STATUS_QUEUED,
+  SEISMOMETER_I2C_STATUS_ACTIVE,
+  SEISMOMETER_I2C_STATUS_DONE,
+  SEISMOMETER_I2C_STATUS_ERROR, /* A byte was not acknowledged */
+} seismometer_i2c_status_e;
+
+typedef struct seismometer_i2c_transaction_s seismometer_i2c_transaction_s;
+typedef void (*seismometer_i2c_callback_t)(seismometer_i2c_transaction_s *transaction);
+struct seismometer_i2c_transaction_s
+{
+  /* Filled in by the caller */
+  uint8_t                              address;
+  const uint8_t                       *write_buffer;
+  size_t                               write_length;
+  uint8_t                             *read_buffer;
+  size_t                               read_length;
+  seismometer_i2c_priority_e           priority;
+  seismometer_i2c_callback_t           callback;  /* Called once complete, may be nullptr */
+  void                                *user_data;
+  bool                                 nack_expected; /* Address NACKs are expected (acknowledge polling) and not
+                                                         counted as errors, the status is still ERROR */
+
+  /* Engine state */
+  volatile seismometer_i2c_status_e    status;
+  uint32_t                             submit_us;
+  seismometer_i2c_transaction_s       *next;
+};
+
+typedef struct
+{
+  uint32_t transaction_count;
+  uint32_t error_count;                               /* Excludes expected address NACKs, see nack_expected */
+  uint32_t max_wait_us[SEISMOMETER_I2C_PRIORITY_MAX]; /* Longest time queued before starting, since the last read */
+} seismometer_i2c_stats_s;
 
-typedef struct 
+typedef struct
 {
-  mutex_t mutex;
-  i2c_inst_t *i2c_inst;
+  i2c_inst_t                    *i2c_inst;
+  critical_section_t             critical_section;
+  seismometer_i2c_transaction_s *queue_head[SEISMOMETER_I2C_PRIORITY_MAX];
+  seismometer_i2c_transaction_s *queue_tail[SEISMOMETER_I2C_PRIORITY_MAX];
+
+  /* Transaction on the bus */
+  seismometer_i2c_transaction_s *active;
+  size_t                         write_index;        /* Write bytes issued */
+  size_t                         read_command_index; /* Read commands issued */
+  size_t                         read_index;         /* Read bytes received */
+  bool                           abort;
+  bool                           address_nack;       /* The abort was the address not being acknowledged */
+
+  volatile bool                  irq_enabled;
+  seismometer_i2c_stats_s        stats;
 } seismometer_i2c_handle_s;
 
-bool seismometer_i2c_lock  (seismometer_i2c_handle_s* i2c_handle);
-bool seismometer_i2c_unlock(seismometer_i2c_handle_s* i2c_handle);
+/* Bus on the default I2C pins shared by the MPU-6500, DS3231 RTC and EEPROM, defined in seismometer.cpp */
+extern seismometer_i2c_handle_s i2c0_handle;
+
+/* Initializes the engine on an I2C instance already set up with i2c_init() */
+void seismometer_i2c_init(seismometer_i2c_handle_s *i2c_handle, i2c_inst_t *i2c_inst);
+/* Runs the engine from the I2C interrupt on the calling core, at the default priority shared with the sample timer and
+   GPIO interrupts so callbacks never preempt them */
+void seismometer_i2c_enable_irq(seismometer_i2c_handle_s *i2c_handle);
+/* Queues 'transaction', safe from either core and from interrupts */
+void seismometer_i2c_submit(seismometer_i2c_handle_s *i2c_handle, seismometer_i2c_transaction_s *transaction);
+/* Waits for a submitted 'transaction' to complete, returns true if every byte was acknowledged.  Must not be called
+   from an interrupt on the engine's core.  Waiting from the other core may return before the callback has finished */
+bool seismometer_i2c_wait(seismometer_i2c_handle_s *i2c_handle, seismometer_i2c_transaction_s *transaction);
+/* Synchronous wrapper for init and thread code, writes 'write_length' bytes then reads 'read_length' bytes after a
+   repeated start at housekeeping priority.  Returns true if every byte was acknowledged */
+bool seismometer_i2c_transfer_blocking(seismometer_i2c_handle_s *i2c_handle, uint8_t address,
+                                       const uint8_t *write_buffer, size_t write_length, uint8_t *read_buffer, size_t read_length);
+/* Addresses 'address' with 'write_length' bytes as seismometer_i2c_transfer_blocking(), for polling a device which does
+   not acknowledge while busy.  Returns true once acknowledged, a NACK is not counted as a bus error */
+bool seismometer_i2c_poll_blocking(seismometer_i2c_handle_s *i2c_handle, uint8_t address, const uint8_t *write_buffer, size_t write_length);
+/* Copies the statistics and restarts the maximum wait times */
+void seismometer_i2c_get_stats(seismometer_i2c_handle_s *i2c_handle, seismometer_i2c_stats_s *stats);
 #endif /* __SEISMOMETER_I2C_HPP__ */
\ No newline at end of file
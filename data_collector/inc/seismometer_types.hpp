@@ -93,6 +93,9 @@ typedef enum
   SAMPLE_LOG_PENDULUM_10X      = 10,
   SAMPLE_LOG_PENDULUM_100X     = 11,
   SAMPLE_LOG_PENDULUM_FILTERED = 12,
+  SAMPLE_LOG_PENDULUM_20HZ     = 13,
+  SAMPLE_LOG_PENDULUM_10HZ     = 14,
+  SAMPLE_LOG_PENDULUM_1HZ      = 15,
   SAMPLE_LOG_MAX_KEY,
 } sample_log_key_e;
 typedef uint32_t sample_log_key_mask_t;
@@ -19,6 +19,7 @@
 typedef enum
 {
   SMPS_CONTROL_CLIENT_SAMPLER,
+  SMPS_CONTROL_CLIENT_ADC,
   SMPS_CONTROL_CLIENT_MAX,
 } smps_control_client_e;
 
@@ -0,0 +1,55 @@
+#ifndef __SPECTRUM_HPP__
+#define __SPECTRUM_HPP__
+
+#include <cstddef>
+#include <cstdint>
+
+#include "fft_q15.hpp"
+
+/* Welch averaged power spectral density of one channel
+    Samples are collected into segments of the FFT length with 50% overlap.  Each segment has its mean removed, is
+    scaled into Q15 (block floating point, the shift is carried as an exponent), Hann windowed and transformed by the
+    shared fft_q15_c.  The one-sided PSD of 'segments' segments is averaged into one spectrum in (sample units)^2/Hz.
+    A completed segment is transformed by process(), or by push_sample() if it is still pending when the next
+    segment completes, so the FFT can run outside the sample path. */
+class spectrum_c
+{
+  private:
+    /* Configuration */
+    const fft_q15_c *const fft;
+    const size_t           length;
+    const unsigned int     segments;
+    /* PSD of a bin is |X|^2*psd_scale, doubled for the bins with negative frequency images */
+    float                  psd_scale = 0;
+
+    /* Segment data, the second half is kept as the first half of the next segment */
+    int32_t               *segment       = nullptr;
+    q15_t                 *fft_buffer    = nullptr;
+    size_t                 segment_fill  = 0;
+
+    /* Welch average */
+    float                 *psd_sum       = nullptr;
+    unsigned int           segment_count = 0;
+    float                 *psd           = nullptr;
+    bool                   psd_ready     = false;
+
+    void process_segment();
+
+  public:
+    /* 'segments' segments of fft->get_length() samples at 'sample_rate' Hz per averaged spectrum */
+    spectrum_c(const fft_q15_c *fft, unsigned int segments, unsigned int sample_rate);
+    ~spectrum_c();
+
+    /* Push incoming raw sample */
+    void                push_sample(int32_t sample);
+    /* Transform the completed segment, if any.  Returns true once per new averaged spectrum */
+    bool                process();
+    /* Returns the averaged PSD of 'bin' (0 to get_bin_count()-1) of the last completed spectrum */
+    inline float        get_psd(size_t bin) const {return psd[bin];};
+    /* Returns the mean averaged PSD of bins 'first_bin' to 'end_bin'-1 of the last completed spectrum */
+    float               get_band_psd(size_t first_bin, size_t end_bin) const;
+    inline size_t       get_bin_count()     const {return ((length/2)+1);};
+    inline unsigned int get_segments()      const {return segments;};
+};
+
+#endif /*__SPECTRUM_HPP__*/
\ No newline at end of file
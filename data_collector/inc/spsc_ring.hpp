@@ -0,0 +1,63 @@
+#ifndef __SPSC_RING_HPP__
+#define __SPSC_RING_HPP__
+
+#include <cstdint>
+
+#include <pico/sync.h>
+
+/* Lock-free single producer, single consumer ring buffer for passing items between the cores
+    Unlike queue_t there is no spin lock and no copy through the queue, the producer builds items in place with
+    reserve()/get_reserved()/commit() and the consumer handles them in place with peek()/release().  Head and tail
+    are free running counters, only written by the producer and consumer respectively.  The producer must be a single
+    context (e.g. interrupts of one priority on one core), as must the consumer.  Commit signals an event so a
+    consumer waiting in __wfe() wakes up. */
+template <typename T, uint32_t SIZE>
+class spsc_ring_c
+{
+  static_assert((SIZE > 0) && (0 == (SIZE & (SIZE-1))), "Ring size must be a power of 2");
+
+  private:
+    T                 items[SIZE];
+    volatile uint32_t head = 0; /* Next item to commit, written by the producer */
+    volatile uint32_t tail = 0; /* Next item to release, written by the consumer */
+
+  public:
+    /* Producer: returns true if 'count' items are free to fill via get_reserved() */
+    inline bool reserve(uint32_t count)                  const {return ((SIZE - (head - tail)) >= count);};
+    /* Producer: returns the 'offset'th reserved item */
+    inline T   *get_reserved(uint32_t offset)                  {return &items[(head + offset) & (SIZE-1)];};
+    /* Producer: publishes the first 'count' reserved items to the consumer */
+    inline void commit(uint32_t count)
+    {
+      __dmb();
+      head = (head + count);
+      __sev();
+    };
+    /* Producer: returns the free running count of committed items, used to order other events against the ring */
+    inline uint32_t get_committed() const {return head;};
+
+    /* Consumer: returns the number of committed items contiguous from '*item', which may be less than get_level()
+       where the ring wraps */
+    inline uint32_t peek(const T **item)
+    {
+      uint32_t index = tail;
+      uint32_t count = (head - index);
+      __dmb();
+      index &= (SIZE-1);
+      *item = &items[index];
+      return ((count < (SIZE - index)) ? count : (SIZE - index));
+    };
+    /* Consumer: returns 'count' peeked items to the producer */
+    inline void release(uint32_t count)
+    {
+      __dmb();
+      tail = (tail + count);
+    };
+    /* Consumer: returns the free running count of released items */
+    inline uint32_t get_released() const {return tail;};
+
+    /* Returns number of committed items not yet released */
+    inline uint32_t get_level() const {return (head - tail);};
+};
+
+#endif /*__SPSC_RING_HPP__*/
\ No newline at end of file
@@ -0,0 +1,44 @@
+#ifndef __STA_LTA_HPP__
+#define __STA_LTA_HPP__
+
+#include <cstddef>
+#include <cstdint>
+
+#include "fir_filter.hpp"
+
+/* Short-term/long-term average ratio event detector
+    The characteristic function is |x| saturated to 16 bits, kept in a history of the last 'lta_length' values.  The
+    STA and LTA are sliding sums over the newest 'sta_length' and all 'lta_length' values, each updated in O(1) by
+    adding the newest value and subtracting the value leaving the window.  The detector triggers when
+    STA/LTA >= trigger_ratio and detriggers when STA/LTA < detrigger_ratio, ratios are in tenths and compared without
+    division.  It can not trigger until the LTA window has filled.  Input should have its DC offset removed. */
+class sta_lta_c
+{
+  private:
+    /* Configuration */
+    const size_t   sta_length;
+    const size_t   lta_length;
+    const uint32_t trigger_ratio_x10;
+    const uint32_t detrigger_ratio_x10;
+
+    /* Characteristic function history */
+    uint16_t      *history      = nullptr;
+    size_t         next_write   = 0;
+    size_t         history_fill = 0;
+    uint32_t       sta_sum      = 0;
+    uint32_t       lta_sum      = 0;
+
+    bool           triggered    = false;
+
+  public:
+    sta_lta_c(size_t sta_length, size_t lta_length, uint32_t trigger_ratio_x10, uint32_t detrigger_ratio_x10);
+    ~sta_lta_c();
+
+    /* Push incoming sample, returns true if triggered */
+    bool           push_sample(filter_sample_t sample);
+    inline bool    is_triggered() const {return triggered;};
+    /* Returns STA/LTA in tenths, 0 until the LTA window has filled */
+    uint32_t       get_ratio_x10() const;
+};
+
+#endif /*__STA_LTA_HPP__*/
\ No newline at end of file
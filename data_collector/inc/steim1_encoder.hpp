@@ -0,0 +1,83 @@
+#ifndef __STEIM1_ENCODER_HPP__
+#define __STEIM1_ENCODER_HPP__
+
+#include <cstddef>
+#include <cstdint>
+
+/* Steim1 difference compression as used by SEED/miniSEED
+    Samples are stored as first differences packed into 64 byte frames of sixteen big-endian 32 bit words.  Word 0
+    of each frame holds sixteen 2 bit codes describing each word of the frame:
+      00 - no data (word 0 itself)
+      01 - four 8 bit differences
+      10 - two 16 bit differences
+      11 - one 32 bit difference
+    In the first frame of a block word 1 holds the first sample (X0) and word 2 the last sample (Xn) so each block
+    can be decoded without any previous block. */
+
+#define STEIM1_FRAME_WORDS          16
+#define STEIM1_FRAME_SIZE           (STEIM1_FRAME_WORDS*sizeof(uint32_t))
+/* Seven frames fill a 512 byte miniSEED record after a 64 byte header */
+#define STEIM1_BLOCK_FRAMES_DEFAULT 7
+
+typedef uint64_t steim1_time_t;
+
+class steim1_encoder_c
+{
+  private:
+    typedef struct
+    {
+      int32_t       sample;
+      int32_t       difference;
+      steim1_time_t time;
+    } pending_sample_s;
+
+    /* Block Configuration */
+    const size_t     frame_count;
+    uint32_t        *block = nullptr;
+
+    /* Block Data */
+    size_t           next_word          = 0;
+    size_t           block_frame_count  = 0;
+    uint16_t         block_sample_count = 0;
+    int32_t          block_first_sample = 0;
+    int32_t          block_last_sample  = 0;
+    steim1_time_t    block_time         = 0;
+    bool             block_complete     = false;
+
+    /* Differences not yet packed into a word */
+    pending_sample_s pending[4];
+    size_t           pending_count      = 0;
+    int32_t          last_sample        = 0;
+    bool             history_valid      = false;
+
+    void start_block();
+    void finish_block();
+    bool pack_word(size_t count, uint32_t code);
+    bool pack_pending(bool final);
+
+  public:
+    steim1_encoder_c(size_t frame_count = STEIM1_BLOCK_FRAMES_DEFAULT);
+    ~steim1_encoder_c();
+
+    /* Push a sample and the caller defined time of the sample.  Returns true when a block is complete, the block is
+       valid until the next call to push_sample() or flush() */
+    bool                   push_sample(int32_t sample, steim1_time_t time);
+    /* Completes the current block with pushed samples.  Returns true if there was data for a block, call until false
+       to complete every pushed sample */
+    bool                   flush();
+    /* Discards pushed samples and history, the next sample is the first difference of 0 */
+    void                   reset();
+
+    /* Returns the big-endian Steim1 frames of the completed block */
+    inline const uint8_t  *get_block()              const {return (const uint8_t*)block;};
+    /* Returns the number of frames containing data in the completed block */
+    inline size_t          get_block_frame_count()  const {return block_frame_count;};
+    /* Returns the number of samples in the completed block */
+    inline uint16_t        get_block_sample_count() const {return block_sample_count;};
+    /* Returns the time of the first sample in the completed block */
+    inline steim1_time_t   get_block_time()         const {return block_time;};
+    /* Returns the maximum number of frames per block */
+    inline size_t          get_frame_count()        const {return frame_count;};
+};
+
+#endif /*__STEIM1_ENCODER_HPP__*/
\ No newline at end of file
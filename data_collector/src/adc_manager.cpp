@@ -2,14 +2,105 @@
 #include <cstdio>
 
 #include <hardware/adc.h>
+#include <hardware/dma.h>
 #include <pico/binary_info.h>
 
 #include "adc_manager.hpp"
+#include "sample_rate.hpp"
+#include "seismometer_config.hpp"
 #include "seismometer_debug.hpp"
 #include "seismometer_utils.hpp"
 
+/* Decimated samples keep FRACTION_BITS below the 12 bit ADC LSB */
+#define ADC_MANAGER_FRACTION_BITS 4
+#define ADC_MANAGER_SAMPLE_Q_MAX  (ADC_MANAGER_SAMPLE_MAX_VALUE << ADC_MANAGER_FRACTION_BITS)
+
 static adc_channel_mask_t enabled_channels = 0;
-static adc_sample_t current_sample[ADC_CH_MAX] = {0};
+static uint32_t current_sample[ADC_CH_MAX] = {0}; /* Fixed point, ADC_MANAGER_FRACTION_BITS fraction bits */
+static adc_manager_stats_s adc_manager_stats = {0};
+
+#if SEISMOMETER_ADC_DMA
+#define ADC_MANAGER_CLOCK_HZ          48000000 /* clk_adc, the 48MHz USB PLL */
+#define ADC_MANAGER_CONVERSION_CYCLES 96       /* Fastest conversion, 500ksps */
+#define ADC_MANAGER_OVERSAMPLE        (1 << SEISMOMETER_ADC_OVERSAMPLE_SHIFT)
+/* CIC gain is OVERSAMPLE^CIC_ORDER */
+#define ADC_MANAGER_CIC_SHIFT         (SEISMOMETER_ADC_CIC_ORDER*SEISMOMETER_ADC_OVERSAMPLE_SHIFT)
+/* Centre of the CIC impulse response of a window relative to its first conversion */
+#define ADC_MANAGER_CIC_CENTRE_US(period_us) ((((int64_t)(2-SEISMOMETER_ADC_CIC_ORDER))*(ADC_MANAGER_OVERSAMPLE-1)*((int64_t)(period_us)))/(2*ADC_MANAGER_OVERSAMPLE))
+/* The DMA write address wraps on a 2^RING_BITS byte boundary */
+#define ADC_MANAGER_DMA_RING_BITS     12
+#define ADC_MANAGER_DMA_RING_LENGTH   ((1 << ADC_MANAGER_DMA_RING_BITS)/sizeof(adc_sample_t))
+
+static_assert((SEISMOMETER_ADC_CIC_ORDER >= 1) && (SEISMOMETER_ADC_CIC_ORDER <= 3), "CIC order must be 1 to 3");
+/* Integrators wrap modulo 2^32, the CIC output must still fit */
+static_assert((12+ADC_MANAGER_CIC_SHIFT) <= 32, "CIC register growth exceeds 32 bits");
+static_assert(ADC_MANAGER_CIC_SHIFT > ADC_MANAGER_FRACTION_BITS, "Too few conversions per sample for the fraction bits");
+/* A read late by a sample period must not find the ring wrapped */
+static_assert((3*ADC_CH_MAX*ADC_MANAGER_OVERSAMPLE) <= ADC_MANAGER_DMA_RING_LENGTH, "ADC DMA ring too short");
+
+/* Round robin slot of each enabled channel, in channel order from the first enabled channel */
+static adc_channel_t channel_order[ADC_CH_MAX] = {0};
+static unsigned int  channel_count = 0;
+
+static adc_sample_t __attribute__((aligned(1 << ADC_MANAGER_DMA_RING_BITS))) adc_dma_ring[ADC_MANAGER_DMA_RING_LENGTH];
+/* Reloaded into the data channel by the control channel each time it completes the ring, so it never stops */
+static uint32_t       adc_dma_ring_length = ADC_MANAGER_DMA_RING_LENGTH;
+static int            adc_dma_data_channel    = -1;
+static int            adc_dma_control_channel = -1;
+static uint64_t       adc_dma_start_us        = 0;
+static size_t         adc_dma_read_position   = 0; /* Ring index of the next window */
+static uint64_t       adc_dma_window_index    = 0; /* Windows decimated since start */
+/* One window per sample period, set for the sample rate at init */
+static uint32_t       adc_dma_window_us       = 0;
+static int64_t        adc_dma_cic_centre_us   = 0;
+
+/* CIC integrator and comb delay states per round robin slot */
+static uint32_t cic_integrator[ADC_CH_MAX][SEISMOMETER_ADC_CIC_ORDER] = {0};
+static uint32_t cic_comb[ADC_CH_MAX][SEISMOMETER_ADC_CIC_ORDER]       = {0};
+static int32_t  cic_previous_output[ADC_CH_MAX] = {0};
+
+/* Decimates the window of OVERSAMPLE conversions of each channel at adc_dma_read_position */
+static void __time_critical_func(adc_manager_decimate_window)()
+{
+  size_t position = adc_dma_read_position;
+  for(unsigned int conversion = 0; conversion < ADC_MANAGER_OVERSAMPLE; conversion++)
+  {
+    for(unsigned int slot = 0; slot < channel_count; slot++)
+    {
+      uint32_t *integrator = cic_integrator[slot];
+      integrator[0] += (adc_dma_ring[position] & ADC_MANAGER_SAMPLE_MAX_VALUE);
+      for(unsigned int stage = 1; stage < SEISMOMETER_ADC_CIC_ORDER; stage++)
+      {
+        integrator[stage] += integrator[stage-1];
+      }
+      position = (position+1) & (ADC_MANAGER_DMA_RING_LENGTH-1);
+    }
+  }
+  adc_dma_read_position = position;
+
+  const int32_t window_length = (int32_t)(channel_count*ADC_MANAGER_OVERSAMPLE);
+  for(unsigned int slot = 0; slot < channel_count; slot++)
+  {
+    uint32_t output = cic_integrator[slot][SEISMOMETER_ADC_CIC_ORDER-1];
+    for(unsigned int stage = 0; stage < SEISMOMETER_ADC_CIC_ORDER; stage++)
+    {
+      const uint32_t delayed = cic_comb[slot][stage];
+      cic_comb[slot][stage] = output;
+      output -= delayed;
+    }
+    /* Remove the CIC gain, keeping the fraction bits */
+    const int32_t sample = (int32_t)((output + (1 << (ADC_MANAGER_CIC_SHIFT-ADC_MANAGER_FRACTION_BITS-1))) >> (ADC_MANAGER_CIC_SHIFT-ADC_MANAGER_FRACTION_BITS));
+
+    /* Slot k converts k conversions after slot 0, interpolate back to the time of slot 0 along the previous output */
+    int32_t aligned = sample - (((sample - cic_previous_output[slot]) * (int32_t)slot) / window_length);
+    cic_previous_output[slot] = sample;
+    aligned = SEISMOMETER_MAX(aligned, 0);
+    aligned = SEISMOMETER_MIN(aligned, ADC_MANAGER_SAMPLE_Q_MAX);
+    current_sample[channel_order[slot]] = (uint32_t)aligned;
+  }
+  adc_dma_window_index++;
+}
+#endif
 
 void adc_manager_init(adc_channel_mask_t enabled_channels_init)
 {
@@ -29,14 +120,99 @@ void adc_manager_init(adc_channel_mask_t enabled_channels_init)
     if(enabled_channels_copy & ADC_CH_TO_MASK(adc_channel))
     {
       adc_gpio_init(ADC_CH_TO_PIN(adc_channel));
+#if SEISMOMETER_ADC_DMA
+      channel_order[channel_count++] = adc_channel;
+#endif
     }
     enabled_channels_copy &= ~(ADC_CH_TO_MASK(adc_channel));
     adc_channel++;
   }
+
+#if SEISMOMETER_ADC_DMA
+  SEISMOMETER_ASSERT(channel_count > 0);
+
+  /* Free running round robin over the enabled channels at OVERSAMPLE conversions per channel per sample period, the
+     ADC clock and sample timer share the crystal so every period is exactly one window */
+  const float conversion_cycles = ((float)ADC_MANAGER_CLOCK_HZ)/((float)(sample_rate_hz()*ADC_MANAGER_OVERSAMPLE*channel_count));
+  SEISMOMETER_ASSERT(conversion_cycles >= ADC_MANAGER_CONVERSION_CYCLES);
+  adc_dma_window_us     = sample_rate_period_us();
+  adc_dma_cic_centre_us = ADC_MANAGER_CIC_CENTRE_US(adc_dma_window_us);
+  adc_set_clkdiv(conversion_cycles-1.0f);
+  adc_set_round_robin(enabled_channels);
+  /* DREQ on each conversion, 12 bit samples without the error flag */
+  adc_fifo_setup(true, true, 1, false, false);
+
+  adc_dma_data_channel    = dma_claim_unused_channel(true);
+  adc_dma_control_channel = dma_claim_unused_channel(true);
+
+  /* Control channel retriggers the data channel with another ring of transfers */
+  dma_channel_config control_config = dma_channel_get_default_config(adc_dma_control_channel);
+  channel_config_set_transfer_data_size(&control_config, DMA_SIZE_32);
+  channel_config_set_read_increment(&control_config, false);
+  channel_config_set_write_increment(&control_config, false);
+  dma_channel_configure(adc_dma_control_channel, &control_config,
+                        &dma_channel_hw_addr(adc_dma_data_channel)->al1_transfer_count_trig, &adc_dma_ring_length, 1, false);
+
+  SEISMOMETER_PRINTF(SEISMOMETER_LOG_INFO, "ADC round robin %u channels at %u conversions per sample, DMA channels %d/%d.\n",
+                     channel_count, ADC_MANAGER_OVERSAMPLE, adc_dma_data_channel, adc_dma_control_channel);
+#endif
 }
 
-void __time_critical_func(adc_manager_read())
+void adc_manager_start()
 {
+#if SEISMOMETER_ADC_DMA
+  /* Regulator ripple couples into every conversion, keep the SMPS in PWM mode while the ADC free runs */
+  smps_control_force_pwm(SMPS_CONTROL_CLIENT_ADC);
+
+  /* Round robin starts from the selected input, so slot 0 is the first enabled channel */
+  adc_select_input(channel_order[0]);
+  adc_fifo_drain();
+
+  /* Data channel writes each conversion into the ring, wrapping its write address, then chains to the control channel */
+  dma_channel_config data_config = dma_channel_get_default_config(adc_dma_data_channel);
+  channel_config_set_transfer_data_size(&data_config, DMA_SIZE_16);
+  channel_config_set_read_increment(&data_config, false);
+  channel_config_set_write_increment(&data_config, true);
+  channel_config_set_ring(&data_config, true, ADC_MANAGER_DMA_RING_BITS);
+  channel_config_set_dreq(&data_config, DREQ_ADC);
+  channel_config_set_chain_to(&data_config, adc_dma_control_channel);
+  dma_channel_configure(adc_dma_data_channel, &data_config, adc_dma_ring, &adc_hw->fifo, ADC_MANAGER_DMA_RING_LENGTH, true);
+
+  adc_dma_start_us = to_us_since_boot(get_absolute_time());
+  adc_run(true);
+#endif
+}
+
+absolute_time_t __time_critical_func(adc_manager_read())
+{
+  absolute_time_t ret_val = get_absolute_time();
+#if SEISMOMETER_ADC_DMA
+  const size_t write_position = (size_t)((dma_channel_hw_addr(adc_dma_data_channel)->write_addr - (uintptr_t)adc_dma_ring)/sizeof(adc_sample_t));
+  const size_t window_length  = channel_count*ADC_MANAGER_OVERSAMPLE;
+  size_t       available      = (write_position - adc_dma_read_position) & (ADC_MANAGER_DMA_RING_LENGTH-1);
+  unsigned int windows        = 0;
+  while(available >= window_length)
+  {
+    adc_manager_decimate_window();
+    available -= window_length;
+    windows++;
+  }
+
+  adc_manager_stats.window_count += windows;
+  if(0 == windows)
+  {
+    adc_manager_stats.hold_count++;
+  }
+  else if(windows > 1)
+  {
+    adc_manager_stats.catch_up_count++;
+  }
+
+  if(adc_dma_window_index > 0)
+  {
+    ret_val = from_us_since_boot(adc_dma_start_us + ((adc_dma_window_index-1)*adc_dma_window_us) + adc_dma_cic_centre_us);
+  }
+#else
   adc_channel_t      adc_channel = 0;
   adc_channel_mask_t enabled_channels_copy = enabled_channels;
   while(enabled_channels_copy)
@@ -45,11 +221,19 @@ void __time_critical_func(adc_manager_read())
     if(enabled_channels_copy & ADC_CH_TO_MASK(adc_channel))
     {
       adc_select_input(adc_channel);
-      current_sample[adc_channel] = adc_read();
+      current_sample[adc_channel] = ((uint32_t)adc_read()) << ADC_MANAGER_FRACTION_BITS;
     }
     enabled_channels_copy &= ~(ADC_CH_TO_MASK(adc_channel));
     adc_channel++;
   }
+#endif
+  return ret_val;
+}
+
+void adc_manager_get_stats(adc_manager_stats_s *stats)
+{
+  SEISMOMETER_ASSERT(stats != nullptr);
+  *stats = adc_manager_stats;
 }
 
 adc_sample_t adc_manager_get_sample(adc_channel_t channel)
@@ -60,7 +244,8 @@ adc_sample_t adc_manager_get_sample(adc_channel_t channel)
 
   if(enabled_channels & ADC_CH_TO_MASK(channel))
   {
-    ret_val = current_sample[channel];
+    ret_val = (adc_sample_t)((current_sample[channel] + (1 << (ADC_MANAGER_FRACTION_BITS-1))) >> ADC_MANAGER_FRACTION_BITS);
+    ret_val = SEISMOMETER_MIN(ret_val, ADC_MANAGER_SAMPLE_MAX_VALUE);
   }
 
   return ret_val;
@@ -68,12 +253,14 @@ adc_sample_t adc_manager_get_sample(adc_channel_t channel)
 
 m_volts_t adc_manager_get_sample_mv(adc_channel_t channel)
 {
-  m_volts_t    ret_val = 0;
-  adc_sample_t raw_sample = adc_manager_get_sample(channel);
- 
-  if(raw_sample <= ADC_MANAGER_SAMPLE_MAX_VALUE)
+  m_volts_t ret_val = 0;
+
+  SEISMOMETER_ASSERT(channel < ADC_CH_MAX);
+
+  /* From the fixed point sample so the oversampled resolution is not rounded away first */
+  if(enabled_channels & ADC_CH_TO_MASK(channel))
   {
-    ret_val = (raw_sample*ADC_REFERENCE_VOLTAGE_MV)/ADC_MANAGER_SAMPLE_MAX_VALUE;
+    ret_val = (current_sample[channel]*ADC_REFERENCE_VOLTAGE_MV)/ADC_MANAGER_SAMPLE_Q_MAX;
   }
 
   return ret_val;
@@ -1,11 +1,18 @@
 #include <cstdlib>
 #include <cstring>
 
+#include <pico/time.h>
+
 #include "at24c_eeprom.hpp"
 #include "seismometer_debug.hpp"
 #include "seismometer_utils.hpp"
 
 #define AT4C_EEPROM_BASE_ADDRESS 0x50
+#define AT24C_EEPROM_PAGE_SIZE   32
+/* Reads are split so a sensor transaction never waits behind more than a page of EEPROM data on the shared bus */
+#define AT24C_EEPROM_READ_CHUNK  32
+/* Time between acknowledge polls while a page write completes (5ms max), leaving the bus free for other transactions */
+#define AT24C_EEPROM_POLL_US     200
 
 at24c_eeprom_c::at24c_eeprom_c(seismometer_i2c_handle_s * i2c_handle_init, at24c_eeprom_address_e address_init, at24c_eeprom_size_e size_init)
   : address(address_init), size(size_init), i2c_addr(AT4C_EEPROM_BASE_ADDRESS | (address_init & 0x7))
@@ -25,13 +32,17 @@ at24c_eeprom_data_size_t at24c_eeprom_c::read_data(at24c_eeprom_data_address_t s
   if((bytes_to_read > 0) && (start_address < get_size_bytes()))
   {
     ret_val = SEISMOMETER_MIN(bytes_to_read, (get_size_bytes()-start_address));
-    uint8_t write_buffer[2]; /* 2 byte address */
-    write_buffer[0] = (start_address>>8) & ((AT24C_EEPROM_SIZE_64K==size)?0x1F:0x0F);
-    write_buffer[1] = (start_address&0xFF);
-    seismometer_i2c_lock(i2c_handle);
-    SEISMOMETER_ASSERT_CALL(2       == i2c_write_blocking(i2c_handle->i2c_inst, i2c_addr, write_buffer, 2, true));
-    SEISMOMETER_ASSERT_CALL(ret_val == i2c_read_blocking (i2c_handle->i2c_inst, i2c_addr, buffer, ret_val, false));
-    seismometer_i2c_unlock(i2c_handle);
+    at24c_eeprom_data_size_t bytes_read = 0;
+    while(bytes_read < ret_val)
+    {
+      at24c_eeprom_data_address_t read_address = (start_address + bytes_read);
+      at24c_eeprom_data_size_t    btr_now      = SEISMOMETER_MIN((ret_val - bytes_read), AT24C_EEPROM_READ_CHUNK);
+      uint8_t write_buffer[2]; /* 2 byte address */
+      write_buffer[0] = (read_address>>8) & ((AT24C_EEPROM_SIZE_64K==size)?0x1F:0x0F);
+      write_buffer[1] = (read_address&0xFF);
+      SEISMOMETER_ASSERT_CALL(seismometer_i2c_transfer_blocking(i2c_handle, i2c_addr, write_buffer, 2, &buffer[bytes_read], btr_now));
+      bytes_read += btr_now;
+    }
   }
 
   return ret_val;
@@ -44,29 +55,26 @@ at24c_eeprom_data_size_t at24c_eeprom_c::write_data(at24c_eeprom_data_address_t
   if((bytes_to_write > 0) && (start_address < get_size_bytes()))
   {
     at24c_eeprom_data_size_t btw = SEISMOMETER_MIN(bytes_to_write, (get_size_bytes()-start_address));
-    uint8_t write_buffer[34]; /* 32-byte page + 2 byte address */
+    uint8_t write_buffer[AT24C_EEPROM_PAGE_SIZE+2]; /* 32-byte page + 2 byte address */
 
-    seismometer_i2c_lock(i2c_handle);
     while(btw > 0)
     {
       at24c_eeprom_data_address_t write_address = (start_address + bytes_written);
       write_buffer[0] = (write_address >>   8) & ((AT24C_EEPROM_SIZE_64K==size)?0x1F:0x0F);
       write_buffer[1] = (write_address & 0xFF);
 
-      at24c_eeprom_data_size_t btw_now = ((btw > 32)?32:btw);
+      at24c_eeprom_data_size_t btw_now = ((btw > AT24C_EEPROM_PAGE_SIZE)?AT24C_EEPROM_PAGE_SIZE:btw);
       memcpy(&write_buffer[2], &buffer[bytes_written], btw_now);
-      at24c_eeprom_data_size_t bytes_written_now = i2c_write_blocking(i2c_handle->i2c_inst, i2c_addr, write_buffer, btw_now+2, false);
-      if(bytes_written_now != btw_now+2)
+      if(!seismometer_i2c_transfer_blocking(i2c_handle, i2c_addr, write_buffer, btw_now+2, nullptr, 0))
       {
         SEISMOMETER_PRINTF(SEISMOMETER_LOG_ERROR, "Failed to write to AT24C EEPROM %u.\n", address);
         break;
       }
-      bytes_written+=((bytes_written_now > 2)?(bytes_written_now-2):0);
+      bytes_written += btw_now;
       btw -= btw_now;
-      /* Wait for eeprom to ack write*/
-      while(PICO_ERROR_GENERIC == i2c_write_blocking(i2c_handle->i2c_inst, i2c_addr, write_buffer, 2, false)) {tight_loop_contents();}
+      /* Wait for eeprom to ack write, each poll is a separate transaction so other devices are not held off */
+      while(!seismometer_i2c_poll_blocking(i2c_handle, i2c_addr, write_buffer, 2)) {sleep_us(AT24C_EEPROM_POLL_US);}
     }
-    seismometer_i2c_unlock(i2c_handle);
   }
 
   return bytes_written;
@@ -0,0 +1,120 @@
+#include <cstdlib>
+#include <cstring>
+
+#include "biquad_filter.hpp"
+#include "seismometer_debug.hpp"
+
+/* Round half up when dropping the coefficient fraction bits */
+#define BIQUAD_ROUND ((int64_t)1 << (BIQUAD_COEFFICIENT_FRACTION_BITS-1))
+
+biquad_filter_c::biquad_filter_c( size_t section_count_init, const biquad_section_s *section_init, const fir_filter_config_s *config_init)
+  : config(*config_init), section_count(section_count_init), section(section_init)
+{
+  SEISMOMETER_ASSERT(config_init != nullptr);
+  SEISMOMETER_ASSERT(section != nullptr);
+  SEISMOMETER_ASSERT(section_count > 0);
+  SEISMOMETER_ASSERT(config.gain_denominator != 0);
+  SEISMOMETER_ASSERT(config.dc_blocker_shift <= FIR_FILTER_DC_BLOCKER_SHIFT_MAX);
+  SEISMOMETER_ASSERT(0 == config.moving_average_order);
+  state = (biquad_state_s*) calloc(sizeof(biquad_state_s), section_count);
+  SEISMOMETER_ASSERT(state != nullptr);
+}
+biquad_filter_c::~biquad_filter_c()
+{
+  free(state);
+}
+
+/* Runs 'count' samples through the cascade in place, one section at a time over the whole block so each section's
+   coefficients and state are held in locals and the state written back once */
+void biquad_filter_c::filter_block(filter_sample_t *sample, size_t count)
+{
+  for(size_t i = 0; i < section_count; i++)
+  {
+    const biquad_section_s s  = section[i];
+    biquad_state_s         st = state[i];
+    for(size_t n = 0; n < count; n++)
+    {
+      const filter_sample_t x = sample[n];
+      /* Second order error feedback of the dropped fractions cancels the (1-z^-1)^2 of poles near z=1, without it low
+         corner high pass sections stick at large DC offsets */
+      int64_t accumulator = ((2*((int64_t)st.e1)) - st.e2);
+      accumulator += ((int64_t)s.b0)*x;
+      accumulator += ((int64_t)s.b1)*st.x1;
+      accumulator += ((int64_t)s.b2)*st.x2;
+      accumulator -= ((int64_t)s.a1)*st.y1;
+      accumulator -= ((int64_t)s.a2)*st.y2;
+      filter_sample_t y = (filter_sample_t)((accumulator + BIQUAD_ROUND) >> BIQUAD_COEFFICIENT_FRACTION_BITS);
+
+      st.e2 = st.e1;
+      st.e1 = (int32_t)(accumulator - (((int64_t)y) * ((int64_t)1 << BIQUAD_COEFFICIENT_FRACTION_BITS)));
+
+      st.x2 = st.x1;
+      st.x1 = x;
+      st.y2 = st.y1;
+      st.y1 = y;
+      sample[n] = y;
+    }
+    state[i] = st;
+  }
+  for(size_t n = 0; n < count; n++)
+  {
+    sample[n] *= config.gain_numerator;
+    sample[n] /= config.gain_denominator;
+  }
+}
+
+/* Updates the DC blocker with 'count' raw samples, subtracting each estimate from 'output' */
+void biquad_filter_c::remove_dc_offset(const filter_sample_t *sample, size_t count, filter_sample_t *output)
+{
+  if(config.dc_blocker_shift > 0)
+  {
+    /* Start from the first sample instead of settling up from 0 */
+    if(!dc_blocker_seeded && (count > 0))
+    {
+      dc_blocker_state  = (sample[0] * (1 << config.dc_blocker_shift));
+      dc_blocker_seeded = true;
+    }
+    filter_sample_t dc_state = dc_blocker_state;
+    filter_sample_t average  = moving_average;
+    for(size_t n = 0; n < count; n++)
+    {
+      dc_state  += (sample[n] - (dc_state >> config.dc_blocker_shift));
+      average    = (dc_state >> config.dc_blocker_shift);
+      output[n] -= average;
+    }
+    dc_blocker_state = dc_state;
+    moving_average   = average;
+  }
+}
+
+void biquad_filter_c::push_sample(filter_sample_t sample)
+{
+  filtered_sample = sample;
+  filter_block(&filtered_sample, 1);
+  filter_sample_t output = filtered_sample;
+  remove_dc_offset(&sample, 1, &output);
+}
+
+void biquad_filter_c::push_samples(const filter_sample_t *sample, size_t count, filter_sample_t *output)
+{
+  SEISMOMETER_ASSERT(sample != nullptr);
+  SEISMOMETER_ASSERT(output != nullptr);
+  /* The DC blocker runs on the raw samples, so blocks are filtered in place through a copy when it is enabled */
+  filter_sample_t raw[BIQUAD_FILTER_BLOCK_SIZE];
+  while(count > 0)
+  {
+    const size_t block = ((count < BIQUAD_FILTER_BLOCK_SIZE) ? count : BIQUAD_FILTER_BLOCK_SIZE);
+    if(config.dc_blocker_shift > 0)
+    {
+      memcpy(raw, sample, (block*sizeof(filter_sample_t)));
+    }
+    memmove(output, sample, (block*sizeof(filter_sample_t)));
+    filter_block(output, block);
+    filtered_sample = output[block-1];
+    remove_dc_offset(raw, block, output);
+
+    sample += block;
+    output += block;
+    count  -= block;
+  }
+}
\ No newline at end of file
@@ -0,0 +1,170 @@
+#include <cassert>
+#include <cstdlib>
+
+#include <pico/sync.h>
+
+#include "clock_discipline.hpp"
+#include "seismometer_config.hpp"
+#include "seismometer_debug.hpp"
+
+/* Rates are fixed-point Q32 offsets from 1, the disciplined rate is (1 + rate_q32/2^32) epoch us per timer us */
+#define CLOCK_DISCIPLINE_Q32_PER_PPM   4295 /* 2^32/10^6 */
+#define CLOCK_DISCIPLINE_RATE_MAX_Q32  (SEISMOMETER_CLOCK_DISCIPLINE_MAX_PPM*CLOCK_DISCIPLINE_Q32_PER_PPM)
+static_assert(SEISMOMETER_CLOCK_DISCIPLINE_MAX_PPM < 1000000, "Disciplined rate must stay positive for monotonic time");
+
+/* Linear epoch time from 'local_us' on, continuous with the previous segment at 'local_us' */
+typedef struct
+{
+  uint64_t local_us;
+  uint64_t epoch_ms;
+  int32_t  epoch_us_fraction;           /* 0-999 us past epoch_ms */
+  int32_t  rate_q32;
+} clock_discipline_segment_s;
+
+/* Published segments, written only by clock_discipline_tick().  The sequence is odd while an update is in progress
+   and readers retry if it changed.  Times before the current segment use the previous segment so time stays
+   monotonic for samples taken just before a tick but converted after it */
+typedef struct
+{
+  volatile uint32_t          sequence;
+  clock_discipline_segment_s current;
+  clock_discipline_segment_s previous;
+} clock_discipline_reference_s;
+
+static clock_discipline_reference_s reference = {0};
+
+/* Tick state, only used by clock_discipline_tick() */
+static bool     tick_valid        = false;
+static uint64_t tick_local_us     = 0;
+static uint64_t tick_epoch_ms     = 0;
+static int32_t  frequency_q32     = 0;
+static volatile int32_t  phase_error_us = 0;
+static volatile uint32_t step_count     = 0;
+
+static inline int32_t floor_div_1000(int32_t value)
+{
+  return (value >= 0) ? (value/1000) : -((999-value)/1000);
+}
+
+static void __time_critical_func(clock_discipline_read)(uint64_t local_us, clock_discipline_segment_s *segment)
+{
+  uint32_t sequence;
+  do
+  {
+    sequence = reference.sequence;
+    __dmb();
+    *segment = (local_us >= reference.current.local_us) ? reference.current : reference.previous;
+    __dmb();
+  } while((0 != (sequence & 1)) || (sequence != reference.sequence));
+}
+
+/* Returns us of 'local_us' past the start of 'segment' in epoch time */
+static inline int64_t segment_offset_us(const clock_discipline_segment_s *segment, uint64_t local_us)
+{
+  int64_t delta_us = (int64_t)(local_us - segment->local_us);
+  return (delta_us + ((delta_us * segment->rate_q32) >> 32));
+}
+
+uint64_t __time_critical_func(clock_discipline_epoch_ms)(uint64_t local_us)
+{
+  clock_discipline_segment_s segment;
+  clock_discipline_read(local_us, &segment);
+
+  uint64_t ret_val;
+  int64_t  delta_us = (int64_t)(local_us - segment.local_us);
+  /* Conversions are within a few seconds of the last tick, keep to 32 bit multiplies and the hardware divider */
+  if((delta_us > -(1<<30)) && (delta_us < (1<<30)))
+  {
+    int32_t offset_us = (int32_t)delta_us + (int32_t)(((int64_t)(int32_t)delta_us * segment.rate_q32) >> 32);
+    ret_val = (segment.epoch_ms + floor_div_1000(segment.epoch_us_fraction + offset_us));
+  }
+  else
+  {
+    ret_val = (clock_discipline_epoch_us(local_us)/1000);
+  }
+  return ret_val;
+}
+
+uint64_t clock_discipline_epoch_us(uint64_t local_us)
+{
+  clock_discipline_segment_s segment;
+  clock_discipline_read(local_us, &segment);
+
+  return ((segment.epoch_ms*1000) + segment.epoch_us_fraction + segment_offset_us(&segment, local_us));
+}
+
+static void clock_discipline_publish(const clock_discipline_segment_s *current, const clock_discipline_segment_s *previous)
+{
+  reference.sequence++;
+  __dmb();
+  reference.current  = *current;
+  reference.previous = *previous;
+  __dmb();
+  reference.sequence++;
+}
+
+void clock_discipline_tick(uint64_t local_us, uint64_t epoch_ms)
+{
+  const clock_discipline_segment_s current = reference.current;
+
+  /* Epoch time error at this tick, positive when disciplined time is behind the RTC */
+  int64_t predicted_us = (current.epoch_us_fraction + segment_offset_us(&current, local_us));
+  int64_t error_us     = ((int64_t)(epoch_ms - current.epoch_ms)*1000) - predicted_us;
+
+  if(!tick_valid || (llabs(error_us) >= SEISMOMETER_CLOCK_DISCIPLINE_STEP_US))
+  {
+    if(tick_valid)
+    {
+      SEISMOMETER_PRINTF(SEISMOMETER_LOG_WARNING, "Stepping clock by %lldus.\n", error_us);
+    }
+    const clock_discipline_segment_s segment =
+    {
+      .local_us          = local_us,
+      .epoch_ms          = epoch_ms,
+      .epoch_us_fraction = 0,
+      .rate_q32          = frequency_q32,
+    };
+    clock_discipline_publish(&segment, &segment);
+    step_count++;
+  }
+  else
+  {
+    /* Frequency from the tick interval, averaged to filter interrupt latency */
+    int64_t interval_us = (int64_t)(local_us - tick_local_us);
+    if(interval_us > 0)
+    {
+      int64_t interval_error_us = ((int64_t)(epoch_ms - tick_epoch_ms)*1000) - interval_us;
+      int32_t measured_q32      = (int32_t)((interval_error_us * ((int64_t)1<<32)) / interval_us);
+      frequency_q32 += ((measured_q32 - frequency_q32) >> SEISMOMETER_CLOCK_DISCIPLINE_FREQUENCY_SHIFT);
+    }
+
+    /* Slew the phase error out over SEISMOMETER_CLOCK_DISCIPLINE_SLEW_S */
+    int64_t rate_q32 = frequency_q32 + ((error_us*CLOCK_DISCIPLINE_Q32_PER_PPM)/SEISMOMETER_CLOCK_DISCIPLINE_SLEW_S);
+    if(rate_q32 >  CLOCK_DISCIPLINE_RATE_MAX_Q32) { rate_q32 =  CLOCK_DISCIPLINE_RATE_MAX_Q32; }
+    if(rate_q32 < -CLOCK_DISCIPLINE_RATE_MAX_Q32) { rate_q32 = -CLOCK_DISCIPLINE_RATE_MAX_Q32; }
+
+    /* New segment starts where the current segment is at this tick */
+    int32_t predicted_ms = floor_div_1000((int32_t)predicted_us);
+    const clock_discipline_segment_s segment =
+    {
+      .local_us          = local_us,
+      .epoch_ms          = (current.epoch_ms + predicted_ms),
+      .epoch_us_fraction = ((int32_t)predicted_us - (predicted_ms*1000)),
+      .rate_q32          = (int32_t)rate_q32,
+    };
+    clock_discipline_publish(&segment, &current);
+  }
+
+  phase_error_us = (int32_t)error_us;
+  tick_valid     = true;
+  tick_local_us  = local_us;
+  tick_epoch_ms  = epoch_ms;
+}
+
+void clock_discipline_get_stats(clock_discipline_stats_s *stats)
+{
+  SEISMOMETER_ASSERT(stats != nullptr);
+  stats->frequency_offset_ppb = (int32_t)(((int64_t)frequency_q32*1000000000) >> 32);
+  stats->phase_error_us       = phase_error_us;
+  stats->step_count           = step_count;
+}
\ No newline at end of file
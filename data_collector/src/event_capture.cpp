@@ -0,0 +1,233 @@
+#include <cassert>
+#include <cstring>
+
+#include "event_capture.hpp"
+#include "sample_file.hpp"
+#include "sample_rate.hpp"
+#include "sample_record.hpp"
+#include "seismometer_config.hpp"
+#include "seismometer_debug.hpp"
+#include "seismometer_utils.hpp"
+#include "sta_lta.hpp"
+
+/* The pre-trigger ring is sized at the default sample rate, higher rates hold fewer seconds */
+#define EVENT_CAPTURE_PRE_TRIGGER_SAMPLES_MAX (SEISMOMETER_EVENT_PRE_TRIGGER_S*SEISMOMETER_SAMPLE_RATE_DEFAULT)
+/* Acceleration samples are pushed up to a sample handler batch ahead of the pendulum samples that complete them */
+#define EVENT_CAPTURE_RING_LENGTH   (EVENT_CAPTURE_PRE_TRIGGER_SAMPLES_MAX+SEISMOMETER_SAMPLE_HANDLER_BATCH_SIZE+1)
+/* The detectors run on 10Hz low passed channels, above DETECTOR_RATE they take every rate/DETECTOR_RATE'th sample
+   without aliasing so their histories stay the size they are at 100Hz */
+#define EVENT_CAPTURE_DETECTOR_RATE 100
+/* Ring entries written to the event file per completed sample.  The pre-trigger samples are caught up over
+   PRE_TRIGGER_SAMPLES/(CATCH_UP-1) samples rather than all at once so they can not take every staging buffer */
+#define EVENT_CAPTURE_CATCH_UP      4
+
+/* Keys of the captured raw samples, in key order */
+typedef enum
+{
+  EVENT_CAPTURE_ACCEL_X,
+  EVENT_CAPTURE_ACCEL_Y,
+  EVENT_CAPTURE_ACCEL_Z,
+  EVENT_CAPTURE_PENDULUM_10X,
+  EVENT_CAPTURE_PENDULUM_100X,
+  EVENT_CAPTURE_KEY_MAX,
+} event_capture_key_e;
+#define EVENT_CAPTURE_KEY_MASK ((1<<SAMPLE_LOG_ACCEL_X)       | (1<<SAMPLE_LOG_ACCEL_Y) | (1<<SAMPLE_LOG_ACCEL_Z) | \
+                                (1<<SAMPLE_LOG_PENDULUM_10X) | (1<<SAMPLE_LOG_PENDULUM_100X))
+
+typedef struct
+{
+  uint64_t       timestamp; /* ms since unix epoch of the acceleration sample */
+  sample_index_t index;
+  int32_t        data[EVENT_CAPTURE_KEY_MAX];
+} event_capture_entry_s;
+
+typedef enum
+{
+  EVENT_CAPTURE_STATE_IDLE,
+  EVENT_CAPTURE_STATE_TRIGGERED,    /* At least one detector triggered */
+  EVENT_CAPTURE_STATE_POST_TRIGGER, /* Both detectors detriggered, capturing the post-trigger samples */
+} event_capture_state_e;
+
+/* Created for the sample rate at init */
+static sta_lta_c *acceleration_detector = nullptr;
+static sta_lta_c *pendulum_detector     = nullptr;
+static uint32_t   detector_stride       = 1;
+static uint32_t   pre_trigger_samples   = 0;
+static uint32_t   post_trigger_samples  = 0;
+
+/* Entry of index i is ring[i % EVENT_CAPTURE_RING_LENGTH] */
+static event_capture_entry_s ring[EVENT_CAPTURE_RING_LENGTH];
+static bool                  ring_started      = false;
+static sample_index_t        ring_first_index  = 0;
+
+static bool                  event_capture_enabled = SEISMOMETER_EVENT_CAPTURE_DEFAULT;
+static event_capture_state_e event_state           = EVENT_CAPTURE_STATE_IDLE;
+static sample_index_t        event_next_index      = 0; /* Next ring entry to write to the event file */
+static uint32_t              event_post_remaining  = 0; /* Samples left in the post-trigger window */
+
+static uint8_t event_record_buffer[sizeof(sample_record_frame_s)+(EVENT_CAPTURE_KEY_MAX*sizeof(int32_t))];
+
+/* Returns the ring entry of 'index', starting a new entry if it holds an older index */
+static event_capture_entry_s *event_capture_entry(sample_index_t index, uint64_t timestamp)
+{
+  event_capture_entry_s *entry = &ring[index % EVENT_CAPTURE_RING_LENGTH];
+  if(!ring_started)
+  {
+    ring_started     = true;
+    ring_first_index = index;
+  }
+  if((entry->index != index) || (entry->timestamp == 0))
+  {
+    memset(entry, 0, sizeof(*entry));
+    entry->index     = index;
+    entry->timestamp = timestamp;
+  }
+  return entry;
+}
+
+/* Writes up to 'count' ring entries to the event file, ending at 'index' */
+static void event_capture_write(sample_index_t index, size_t count)
+{
+  while((count > 0) && (((int32_t)(index-event_next_index)) >= 0))
+  {
+    const event_capture_entry_s *entry = &ring[event_next_index % EVENT_CAPTURE_RING_LENGTH];
+    /* Skip indices lost to a sample ring overrun */
+    if(entry->index == event_next_index)
+    {
+      const sample_record_frame_s record =
+      {
+        .type      = SAMPLE_RECORD_TYPE_FRAME,
+        .key_mask  = EVENT_CAPTURE_KEY_MASK,
+        .index     = (uint32_t)entry->index,
+        .timestamp = entry->timestamp,
+      };
+      memcpy(event_record_buffer, &record, sizeof(record));
+      memcpy(&event_record_buffer[sizeof(record)], entry->data, sizeof(entry->data));
+      sample_file_event_write(event_record_buffer, sizeof(event_record_buffer));
+    }
+    event_next_index++;
+    count--;
+  }
+}
+
+static void event_capture_start(sample_index_t index)
+{
+  SEISMOMETER_PRINTF(SEISMOMETER_LOG_INFO, "Event triggered at index %u, STA/LTA acceleration %lu/10 pendulum %lu/10.\n",
+                     index, acceleration_detector->get_ratio_x10(), pendulum_detector->get_ratio_x10());
+  sample_file_event_open();
+  event_next_index = ((index-ring_first_index) >= pre_trigger_samples) ? (index-pre_trigger_samples) : ring_first_index;
+  event_state      = EVENT_CAPTURE_STATE_TRIGGERED;
+}
+
+static void event_capture_end(sample_index_t index)
+{
+  /* Write whatever is left of the pre-trigger samples */
+  event_capture_write(index, EVENT_CAPTURE_RING_LENGTH);
+  sample_file_event_close();
+  event_state = EVENT_CAPTURE_STATE_IDLE;
+  SEISMOMETER_PRINTF(SEISMOMETER_LOG_INFO, "Event capture ended at index %u.\n", index);
+}
+
+void event_capture_init()
+{
+  const uint32_t rate_hz = sample_rate_hz();
+  detector_stride = SEISMOMETER_MAX((rate_hz/EVENT_CAPTURE_DETECTOR_RATE), 1);
+  const uint32_t detector_hz = (rate_hz/detector_stride);
+  acceleration_detector = new sta_lta_c(SEISMOMETER_STA_LTA_STA_S*detector_hz, SEISMOMETER_STA_LTA_LTA_S*detector_hz,
+                                        SEISMOMETER_STA_LTA_TRIGGER_RATIO_X10, SEISMOMETER_STA_LTA_DETRIGGER_RATIO_X10);
+  pendulum_detector     = new sta_lta_c(SEISMOMETER_STA_LTA_STA_S*detector_hz, SEISMOMETER_STA_LTA_LTA_S*detector_hz,
+                                        SEISMOMETER_STA_LTA_TRIGGER_RATIO_X10, SEISMOMETER_STA_LTA_DETRIGGER_RATIO_X10);
+  pre_trigger_samples  = SEISMOMETER_MIN((SEISMOMETER_EVENT_PRE_TRIGGER_S*rate_hz), EVENT_CAPTURE_PRE_TRIGGER_SAMPLES_MAX);
+  post_trigger_samples = (SEISMOMETER_EVENT_POST_TRIGGER_S*rate_hz);
+  SEISMOMETER_PRINTF(SEISMOMETER_LOG_INFO, "Event capture detectors at %luHz, %lums pre-trigger.\n",
+                     detector_hz, ((pre_trigger_samples*1000)/rate_hz));
+}
+
+void event_capture_acceleration(sample_index_t index, uint64_t timestamp, const acceleration_sample_s *acceleration, filter_sample_t magnitude_filtered)
+{
+  SEISMOMETER_ASSERT(acceleration != nullptr);
+  event_capture_entry_s *entry = event_capture_entry(index, timestamp);
+  entry->data[EVENT_CAPTURE_ACCEL_X] = acceleration->x;
+  entry->data[EVENT_CAPTURE_ACCEL_Y] = acceleration->y;
+  entry->data[EVENT_CAPTURE_ACCEL_Z] = acceleration->z;
+  if(0 == (index % detector_stride))
+  {
+    acceleration_detector->push_sample(magnitude_filtered);
+  }
+}
+
+void event_capture_pendulum(sample_index_t index, uint64_t timestamp, const pendulum_sample_s *pendulum, filter_sample_t pendulum_filtered)
+{
+  SEISMOMETER_ASSERT(pendulum != nullptr);
+  event_capture_entry_s *entry = event_capture_entry(index, timestamp);
+  entry->data[EVENT_CAPTURE_PENDULUM_10X]  = (int32_t)pendulum->x10;
+  entry->data[EVENT_CAPTURE_PENDULUM_100X] = (int32_t)pendulum->x100;
+  if(0 == (index % detector_stride))
+  {
+    pendulum_detector->push_sample(pendulum_filtered);
+  }
+
+  const bool triggered = (acceleration_detector->is_triggered() || pendulum_detector->is_triggered());
+  switch(event_state)
+  {
+    case EVENT_CAPTURE_STATE_IDLE:
+    {
+      if(triggered && event_capture_enabled)
+      {
+        event_capture_start(index);
+      }
+      break;
+    }
+    case EVENT_CAPTURE_STATE_TRIGGERED:
+    {
+      if(!triggered)
+      {
+        SEISMOMETER_PRINTF(SEISMOMETER_LOG_INFO, "Event detriggered at index %u.\n", index);
+        event_post_remaining = post_trigger_samples;
+        event_state          = EVENT_CAPTURE_STATE_POST_TRIGGER;
+      }
+      break;
+    }
+    case EVENT_CAPTURE_STATE_POST_TRIGGER:
+    {
+      if(triggered)
+      {
+        SEISMOMETER_PRINTF(SEISMOMETER_LOG_INFO, "Event retriggered at index %u.\n", index);
+        event_state = EVENT_CAPTURE_STATE_TRIGGERED;
+      }
+      else if(event_post_remaining > 0)
+      {
+        event_post_remaining--;
+      }
+      break;
+    }
+    default:
+    {
+      SEISMOMETER_ASSERT(0);
+      break;
+    }
+  }
+
+  if(EVENT_CAPTURE_STATE_IDLE != event_state)
+  {
+    event_capture_write(index, EVENT_CAPTURE_CATCH_UP);
+    if((EVENT_CAPTURE_STATE_POST_TRIGGER == event_state) && (0 == event_post_remaining))
+    {
+      event_capture_end(index);
+    }
+  }
+}
+
+void event_capture_set_enabled(bool enabled)
+{
+  event_capture_enabled = enabled;
+  if(!enabled && (EVENT_CAPTURE_STATE_IDLE != event_state))
+  {
+    event_capture_end(event_next_index-1);
+  }
+}
+
+bool event_capture_get_enabled()
+{
+  return event_capture_enabled;
+}
\ No newline at end of file
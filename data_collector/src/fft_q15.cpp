@@ -0,0 +1,151 @@
+#include <cassert>
+#include <cmath>
+#include <cstdlib>
+
+#include "fft_q15.hpp"
+#include "seismometer_debug.hpp"
+
+/* Largest magnitude ahead of a butterfly, |a+w*b| grows by up to 1+sqrt(2) so 2^13 stays below 2^15 */
+#define FFT_Q15_HEADROOM_MAX (1<<13)
+
+/* Q15 multiply with rounding */
+#define Q15_MULTIPLY(a, b) ((int32_t)((((int32_t)(a))*((int32_t)(b))) + (1<<14)) >> 15)
+
+/* Shifts 'data' right until every value is below FFT_Q15_HEADROOM_MAX, returns the shift */
+static int fft_q15_block_scale(q15_t *data, size_t count)
+{
+  int32_t max = 0;
+  for(size_t i = 0; i < count; i++)
+  {
+    int32_t magnitude = ((data[i] < 0) ? -data[i] : data[i]);
+    if(magnitude > max)
+    {
+      max = magnitude;
+    }
+  }
+
+  int shift = 0;
+  while((max >> shift) >= FFT_Q15_HEADROOM_MAX)
+  {
+    shift++;
+  }
+  if(shift > 0)
+  {
+    for(size_t i = 0; i < count; i++)
+    {
+      data[i] >>= shift;
+    }
+  }
+  return shift;
+}
+
+fft_q15_c::fft_q15_c(size_t length_init)
+  : length(length_init)
+{
+  SEISMOMETER_ASSERT(length >= 4);
+  SEISMOMETER_ASSERT(0 == (length & (length-1)));
+  twiddle = (q15_t*) calloc(sizeof(q15_t), length);
+  SEISMOMETER_ASSERT(twiddle != nullptr);
+  for(size_t k = 0; k < length/2; k++)
+  {
+    const double angle = (2*M_PI*k)/length;
+    twiddle[2*k]   = (q15_t)fmin(round(cos(angle)*Q15_ONE), Q15_ONE-1);
+    twiddle[2*k+1] = (q15_t)fmin(round(sin(angle)*Q15_ONE), Q15_ONE-1);
+  }
+}
+fft_q15_c::~fft_q15_c()
+{
+  free(twiddle);
+}
+
+int fft_q15_c::forward_real(q15_t *data) const
+{
+  SEISMOMETER_ASSERT(data != nullptr);
+  /* 'data' holds half_length complex samples z[n] = x[2n] + j*x[2n+1] */
+  const size_t half_length = length/2;
+  int exponent = 0;
+
+  /* Bit reversed order */
+  for(size_t i = 1, j = 0; i < half_length; i++)
+  {
+    size_t bit = (half_length >> 1);
+    for(; (j & bit); bit >>= 1)
+    {
+      j ^= bit;
+    }
+    j ^= bit;
+    if(i < j)
+    {
+      q15_t re = data[2*i];
+      q15_t im = data[2*i+1];
+      data[2*i]   = data[2*j];
+      data[2*i+1] = data[2*j+1];
+      data[2*j]   = re;
+      data[2*j+1] = im;
+    }
+  }
+
+  /* Radix-2 stages, the twiddle of butterfly k in a group of 2*span is W_length^(k*length/(2*span)) */
+  for(size_t span = 1; span < half_length; span <<= 1)
+  {
+    exponent += fft_q15_block_scale(data, length);
+    const size_t twiddle_step = (length/(2*span));
+    for(size_t group = 0; group < half_length; group += 2*span)
+    {
+      for(size_t k = 0; k < span; k++)
+      {
+        const q15_t c = twiddle[2*k*twiddle_step];
+        const q15_t s = twiddle[2*k*twiddle_step+1];
+        q15_t *a = &data[2*(group+k)];
+        q15_t *b = &data[2*(group+k+span)];
+        /* t = b*(c - j*s) */
+        const int32_t tr = Q15_MULTIPLY(c, b[0]) + Q15_MULTIPLY(s, b[1]);
+        const int32_t ti = Q15_MULTIPLY(c, b[1]) - Q15_MULTIPLY(s, b[0]);
+        b[0] = (q15_t)(a[0] - tr);
+        b[1] = (q15_t)(a[1] - ti);
+        a[0] = (q15_t)(a[0] + tr);
+        a[1] = (q15_t)(a[1] + ti);
+      }
+    }
+  }
+
+  /* Split the half length spectrum Z into X[k] = E[k] + W^k*O[k] and X[half_length-k] = conj(E[k] - W^k*O[k]), with
+     the spectra of the even and odd samples E[k] = (Z[k] + conj(Z[half_length-k]))/2 and
+     O[k] = -j*(Z[k] - conj(Z[half_length-k]))/2 */
+  exponent += fft_q15_block_scale(data, length);
+  const int32_t z0_re = data[0];
+  const int32_t z0_im = data[1];
+  data[0] = (q15_t)(z0_re + z0_im);
+  data[1] = (q15_t)(z0_re - z0_im);
+  for(size_t k = 1; k <= half_length/2; k++)
+  {
+    q15_t *a = &data[2*k];
+    q15_t *b = &data[2*(half_length-k)];
+    const int32_t er = ((a[0] + b[0]) >> 1);
+    const int32_t ei = ((a[1] - b[1]) >> 1);
+    const int32_t or_ = ((a[1] + b[1]) >> 1);
+    const int32_t oi = ((b[0] - a[0]) >> 1);
+    const q15_t c = twiddle[2*k];
+    const q15_t s = twiddle[2*k+1];
+    /* t = O*(c - j*s) */
+    const int32_t tr = Q15_MULTIPLY(c, or_) + Q15_MULTIPLY(s, oi);
+    const int32_t ti = Q15_MULTIPLY(c, oi)  - Q15_MULTIPLY(s, or_);
+    a[0] = (q15_t)(er + tr);
+    a[1] = (q15_t)(ei + ti);
+    if(a != b)
+    {
+      b[0] = (q15_t)(er - tr);
+      b[1] = (q15_t)(ti - ei);
+    }
+  }
+
+  return exponent;
+}
+
+q15_t fft_q15_c::window_hann(size_t n) const
+{
+  SEISMOMETER_ASSERT(n < length);
+  /* (1 - cos(2*pi*n/length))/2, cos(2*pi*n/length) = -cos(2*pi*(n-length/2)/length) in the second half */
+  const int32_t c = ((n < length/2) ? twiddle[2*n] : -twiddle[2*(n-length/2)]);
+  return (q15_t)((Q15_ONE - c) >> 1);
+}
\ No newline at end of file
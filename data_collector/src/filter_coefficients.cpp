@@ -1,13 +0,0 @@
-#include "filter_coefficients.hpp"
-
-const filter_coefficient_t fir_hamming_lpf_100hz_fs_10hz_cutoff[FIR_HAMMING_LPF_100HZ_FS_10HZ_CUTOFF_ORDER] =
-{
-      76,       50,        0,      -65,     -126,     -153,     -115,        0,
-     171,      333,      400,      294,        0,     -409,     -774,     -900,
-    -645,        0,      858,     1599,     1840,     1310,        0,    -1755,
-   -3319,    -3921,    -2908,        0,     4548,     9947,    15059,    18699,
-   19989,    18614,    14921,     9811,     4464,        0,    -2827,    -3794,
-   -3195,    -1681,        0,     1240,     1732,     1496,      798,        0,
-    -591,     -819,     -699,     -366,        0,      259,      348,      288,
-     146,        0,      -98,     -130,     -109,      -57,        0,       48
-};
\ No newline at end of file
@@ -1,68 +1,139 @@
 #include <cassert>
 #include <cstdlib>
+#include <cstring>
 
 #include "fir_filter.hpp"
 #include "seismometer_debug.hpp"
 #include "seismometer_utils.hpp"
 
-#define INCREMENT_CIRCULAR_BUFFER_ITERATOR(iterator, buffer_size) \
-  ((((iterator)+1) < (buffer_size))?((iterator)+1):(0)) /* If iterator exceeds buffer size, reset to 0 */
-#define CIRCULAR_BUFFER_OFFSET_NEG(index, buffer_size, offset) \
-  (((offset) <= (index))?((index)-(offset)):((index)+(buffer_size)-(offset)))
-#define CIRCULAR_BUFFER_OFFSET_POS(index, buffer_size, offset) \
-  ((((index)+(offset)) < (buffer_size))?((index)+(offset)):((index)+(offset)-(buffer_size)))
-
 const fir_filter_config_s default_fir_filter_config
 {
   .moving_average_order = 0,
+  .dc_blocker_shift     = 0,
   .gain_numerator   = 1,
   .gain_denominator = 1,
 };
 
 fir_filter_c::fir_filter_c( filter_order_t order_init, const filter_coefficient_t *coefficient_init, const fir_filter_config_s *config_init)
   : order(order_init), coefficient(coefficient_init), config(*config_init), 
-    circular_buffer_size(SEISMOMETER_MAX(order_init, config_init->moving_average_order))
+    history_length(SEISMOMETER_MAX(order_init, config_init->moving_average_order))
 {
   SEISMOMETER_ASSERT(config_init != nullptr);
   SEISMOMETER_ASSERT(coefficient != nullptr);
   SEISMOMETER_ASSERT(order > 0);
   SEISMOMETER_ASSERT(config.gain_denominator != 0);
-  SEISMOMETER_ASSERT(circular_buffer_size > 0);
-  circular_buffer = (filter_sample_t*) calloc(sizeof(filter_sample_t), circular_buffer_size);
-  SEISMOMETER_ASSERT(circular_buffer != nullptr);
+  SEISMOMETER_ASSERT(config.dc_blocker_shift <= FIR_FILTER_DC_BLOCKER_SHIFT_MAX);
+  SEISMOMETER_ASSERT((0 == config.moving_average_order) || (0 == config.dc_blocker_shift));
+  SEISMOMETER_ASSERT(history_length > 0);
+  history = (filter_sample_t*) calloc(sizeof(filter_sample_t), (2*history_length));
+  SEISMOMETER_ASSERT(history != nullptr);
+  next_write = history_length;
 }
 fir_filter_c::~fir_filter_c()
 {
-  free(circular_buffer);
+  free(history);
 }
 
-void fir_filter_c::push_sample(filter_sample_t sample)
+/* Returns the filtered sample of 'window', oldest to newest sample */
+filter_sample_t fir_filter_c::filter(const filter_sample_t *window) const
+{
+  filter_sample_t sum = 0;
+  for(filter_order_t i = 0; i < order; i++)
+  {
+    sum += coefficient[i]*window[i];
+  }
+  sum *= config.gain_numerator;
+  sum /= config.gain_denominator;
+  return sum;
+}
+
+/* Updates the moving average (or DC blocker) with 'count' raw samples from the history, subtracting each estimate
+   from 'output'.  The state is held in locals over the block and written back once */
+void fir_filter_c::remove_dc_offset(const filter_sample_t *sample, size_t count, filter_sample_t *output)
 {
   if(config.moving_average_order > 0)
   {
-    moving_average_sum -= circular_buffer[CIRCULAR_BUFFER_OFFSET_NEG(next_write, circular_buffer_size, config.moving_average_order)];
-    moving_average_sum += sample;
-    if(moving_average_history < config.moving_average_order)
+    /* The sample leaving the moving average is still in the history */
+    const filter_sample_t *leaving = (sample - config.moving_average_order);
+    filter_order_t  history_local  = moving_average_history;
+    filter_sample_t sum            = moving_average_sum;
+    filter_sample_t average        = moving_average;
+    for(size_t i = 0; i < count; i++)
     {
-      moving_average_history++;
+      sum -= leaving[i];
+      sum += sample[i];
+      if(history_local < config.moving_average_order)
+      {
+        history_local++;
+      }
+      average    = (sum/((filter_sample_t)history_local));
+      output[i] -= average;
     }
+    moving_average_history = history_local;
+    moving_average_sum     = sum;
+    moving_average         = average;
   }
-  circular_buffer[next_write]=sample;
-  next_write = INCREMENT_CIRCULAR_BUFFER_ITERATOR(next_write, circular_buffer_size);
- 
-  filter_order_t i = 0;
-  filtered_sample = 0;
-  filter_order_t iterator = CIRCULAR_BUFFER_OFFSET_NEG(next_write, circular_buffer_size, order-1);
-  for(i = 0; i < order; i++)
+  else if(config.dc_blocker_shift > 0)
   {
-    filtered_sample += coefficient[i]*circular_buffer[iterator];
-    iterator         = INCREMENT_CIRCULAR_BUFFER_ITERATOR(iterator, circular_buffer_size);
+    /* Start from the first sample instead of settling up from 0 */
+    if(!dc_blocker_seeded && (count > 0))
+    {
+      dc_blocker_state  = (sample[0] * (1 << config.dc_blocker_shift));
+      dc_blocker_seeded = true;
+    }
+    filter_sample_t state   = dc_blocker_state;
+    filter_sample_t average = moving_average;
+    for(size_t i = 0; i < count; i++)
+    {
+      state     += (sample[i] - (state >> config.dc_blocker_shift));
+      average    = (state >> config.dc_blocker_shift);
+      output[i] -= average;
+    }
+    dc_blocker_state = state;
+    moving_average   = average;
   }
-  filtered_sample*=config.gain_numerator;
-  filtered_sample/=config.gain_denominator;
+}
 
-  if(moving_average_history > 0)
+/* Moves the last history_length samples to the front once the history is full */
+void fir_filter_c::history_wrap()
+{
+  if((2*history_length) == next_write)
   {
-    moving_average   = (moving_average_sum/((filter_sample_t)moving_average_history));
+    memcpy(&history[0], &history[history_length], (history_length*sizeof(filter_sample_t)));
+    next_write = history_length;
+  }
+}
+
+void fir_filter_c::push_sample(filter_sample_t sample)
+{
+  history[next_write++] = sample;
+  filtered_sample = filter(&history[next_write-order]);
+  filter_sample_t output = filtered_sample;
+  remove_dc_offset(&history[next_write-1], 1, &output);
+  history_wrap();
+}
+
+void fir_filter_c::push_samples(const filter_sample_t *sample, size_t count, filter_sample_t *output)
+{
+  SEISMOMETER_ASSERT(sample != nullptr);
+  SEISMOMETER_ASSERT(output != nullptr);
+  while(count > 0)
+  {
+    /* Copy as much of the block as fits behind the history, filter it from the buffer then remove the DC offset */
+    const size_t block = SEISMOMETER_MIN(((2*history_length)-next_write), count);
+    memcpy(&history[next_write], sample, (block*sizeof(filter_sample_t)));
+    const filter_sample_t *window = &history[next_write+1-order];
+    for(size_t i = 0; i < block; i++)
+    {
+      output[i] = filter(&window[i]);
+    }
+    filtered_sample = output[block-1];
+    remove_dc_offset(&history[next_write], block, output);
+    next_write += block;
+    history_wrap();
+
+    sample += block;
+    output += block;
+    count  -= block;
   }
 }
\ No newline at end of file
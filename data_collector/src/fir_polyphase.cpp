@@ -0,0 +1,114 @@
+#include <cassert>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#include "fir_polyphase.hpp"
+#include "seismometer_debug.hpp"
+
+fir_polyphase_c::fir_polyphase_c(filter_order_t order, const filter_coefficient_t *coefficient, filter_order_t interpolation_init,
+                                 filter_order_t decimation_init, filter_sample_t gain_numerator_init, filter_sample_t gain_denominator_init)
+  : interpolation(interpolation_init), decimation(decimation_init), phase_order((order + interpolation_init - 1)/interpolation_init),
+    gain_numerator(gain_numerator_init), gain_denominator(gain_denominator_init)
+{
+  SEISMOMETER_ASSERT(coefficient != nullptr);
+  SEISMOMETER_ASSERT(order > 0);
+  SEISMOMETER_ASSERT(interpolation > 0);
+  SEISMOMETER_ASSERT(decimation > 0);
+  SEISMOMETER_ASSERT(gain_denominator != 0);
+
+  /* Phase p output is sum(coefficient[p + k*interpolation] * x[n-k]), stored oldest sample first */
+  phase_coefficient = (filter_coefficient_t*) calloc(sizeof(filter_coefficient_t), (interpolation*phase_order));
+  SEISMOMETER_ASSERT(phase_coefficient != nullptr);
+  for(filter_order_t phase = 0; phase < interpolation; phase++)
+  {
+    for(filter_order_t k = 0; k < phase_order; k++)
+    {
+      filter_order_t index = (phase + (k*interpolation));
+      if(index < order)
+      {
+        phase_coefficient[(phase*phase_order) + (phase_order-1-k)] = coefficient[index];
+      }
+    }
+  }
+
+  history = (filter_sample_t*) calloc(sizeof(filter_sample_t), (2*phase_order));
+  SEISMOMETER_ASSERT(history != nullptr);
+  next_write = phase_order;
+}
+fir_polyphase_c::~fir_polyphase_c()
+{
+  free(phase_coefficient);
+  free(history);
+}
+
+/* Runs the outputs of 'count' input samples, the window of the first ending at 'window'+phase_order.  The phase is
+   held in a local over the block and written back once, returns the number of outputs written */
+size_t fir_polyphase_c::filter_block(const filter_sample_t *window, size_t count, filter_sample_t *output)
+{
+  size_t         output_count = 0;
+  filter_order_t phase        = next_phase;
+  for(size_t n = 0; n < count; n++)
+  {
+    /* Outputs fall 'decimation' interpolated samples apart, phase is the next output relative to this input */
+    while(phase < interpolation)
+    {
+      const filter_coefficient_t *phase_coefficient_ptr = &phase_coefficient[phase*phase_order];
+      int64_t sum = 0;
+      for(filter_order_t i = 0; i < phase_order; i++)
+      {
+        sum += (int64_t)phase_coefficient_ptr[i]*window[n+i];
+      }
+      output[output_count++] = (filter_sample_t)((sum*gain_numerator)/gain_denominator);
+      phase                 += decimation;
+    }
+    phase -= interpolation;
+  }
+  next_phase = phase;
+  if(output_count > 0)
+  {
+    filtered_sample = output[output_count-1];
+  }
+  return output_count;
+}
+
+/* Moves the last phase_order samples to the front once the history is full */
+void fir_polyphase_c::history_wrap()
+{
+  if((2*phase_order) == next_write)
+  {
+    memcpy(&history[0], &history[phase_order], (phase_order*sizeof(filter_sample_t)));
+    next_write = phase_order;
+  }
+}
+
+size_t fir_polyphase_c::push_sample(filter_sample_t sample, filter_sample_t *output)
+{
+  SEISMOMETER_ASSERT(output != nullptr);
+
+  history[next_write++] = sample;
+  size_t output_count = filter_block(&history[next_write-phase_order], 1, output);
+  history_wrap();
+
+  return output_count;
+}
+
+size_t fir_polyphase_c::push_samples(const filter_sample_t *sample, size_t count, filter_sample_t *output)
+{
+  SEISMOMETER_ASSERT(sample != nullptr);
+  SEISMOMETER_ASSERT(output != nullptr);
+  size_t output_count = 0;
+  while(count > 0)
+  {
+    /* Copy as much of the block as fits behind the history then run its outputs from the buffer */
+    const size_t block = ((((2*phase_order)-next_write) < count) ? ((2*phase_order)-next_write) : count);
+    memcpy(&history[next_write], sample, (block*sizeof(filter_sample_t)));
+    output_count += filter_block(&history[next_write+1-phase_order], block, &output[output_count]);
+    next_write   += block;
+    history_wrap();
+
+    sample += block;
+    count  -= block;
+  }
+  return output_count;
+}
\ No newline at end of file
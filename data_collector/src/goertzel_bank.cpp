@@ -0,0 +1,71 @@
+#include <cassert>
+#include <cmath>
+#include <cstdlib>
+
+#include "goertzel_bank.hpp"
+#include "seismometer_debug.hpp"
+
+goertzel_bank_c::goertzel_bank_c(size_t channel_count_init, size_t bin_count_init, const float *frequency, unsigned int sample_rate, size_t block_length_init)
+  : channel_count(channel_count_init), bin_count(bin_count_init), block_length(block_length_init)
+{
+  SEISMOMETER_ASSERT(frequency != nullptr);
+  SEISMOMETER_ASSERT(channel_count > 0);
+  SEISMOMETER_ASSERT(bin_count > 0);
+  SEISMOMETER_ASSERT(block_length > 0);
+  SEISMOMETER_ASSERT(sample_rate > 0);
+  coefficient = (goertzel_coefficient_t*) calloc(sizeof(goertzel_coefficient_t), bin_count);
+  state       = (int64_t*)                calloc(sizeof(int64_t), 2*channel_count*bin_count);
+  power       = (float*)                  calloc(sizeof(float),   channel_count*bin_count);
+  SEISMOMETER_ASSERT(coefficient != nullptr);
+  SEISMOMETER_ASSERT(state       != nullptr);
+  SEISMOMETER_ASSERT(power       != nullptr);
+  for(size_t bin = 0; bin < bin_count; bin++)
+  {
+    SEISMOMETER_ASSERT((frequency[bin] > 0) && ((2*frequency[bin]) < sample_rate));
+    coefficient[bin] = (goertzel_coefficient_t)lround(2*cos((2*M_PI*frequency[bin])/sample_rate)*(1<<GOERTZEL_COEFFICIENT_FRACTION_BITS));
+  }
+}
+goertzel_bank_c::~goertzel_bank_c()
+{
+  free(coefficient);
+  free(state);
+  free(power);
+}
+
+bool goertzel_bank_c::push_sample(const filter_sample_t *sample)
+{
+  SEISMOMETER_ASSERT(sample != nullptr);
+  int64_t *s = state;
+  for(size_t channel = 0; channel < channel_count; channel++)
+  {
+    for(size_t bin = 0; bin < bin_count; bin++)
+    {
+      const int64_t s0 = sample[channel] + ((coefficient[bin]*s[0]) >> GOERTZEL_COEFFICIENT_FRACTION_BITS) - s[1];
+      s[1] = s[0];
+      s[0] = s0;
+      s   += 2;
+    }
+  }
+
+  bool ret_val = false;
+  block_fill++;
+  if(block_length == block_fill)
+  {
+    /* A tone of amplitude A gives |X|^2 = (A*N/2)^2, so the mean square amplitude A^2/2 is 2*|X|^2/N^2 */
+    const double scale = 2.0/((double)block_length*block_length);
+    s = state;
+    for(size_t i = 0; i < (channel_count*bin_count); i++)
+    {
+      const double c  = ((double)coefficient[i % bin_count])/(1<<GOERTZEL_COEFFICIENT_FRACTION_BITS);
+      const double s1 = (double)s[0];
+      const double s2 = (double)s[1];
+      power[i] = (float)(((s1*s1) + (s2*s2) - (c*s1*s2))*scale);
+      s[0] = 0;
+      s[1] = 0;
+      s   += 2;
+    }
+    block_fill = 0;
+    ret_val    = true;
+  }
+  return ret_val;
+}
\ No newline at end of file
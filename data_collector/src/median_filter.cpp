@@ -0,0 +1,224 @@
+#include <cassert>
+#include <cstdlib>
+
+#include "circular_buffer.hpp"
+#include "median_filter.hpp"
+#include "seismometer_debug.hpp"
+
+median_filter_c::median_filter_c(size_t window_length_init)
+  : window_length(window_length_init)
+{
+  SEISMOMETER_ASSERT(1 == (window_length % 2));
+  window       = (filter_sample_t*) calloc(sizeof(filter_sample_t), window_length);
+  position     = (int*)             calloc(sizeof(int),             window_length);
+  heap_storage = (int*)             calloc(sizeof(int),             window_length);
+  SEISMOMETER_ASSERT(window       != nullptr);
+  SEISMOMETER_ASSERT(position     != nullptr);
+  SEISMOMETER_ASSERT(heap_storage != nullptr);
+  heap = &heap_storage[window_length/2];
+
+  /* Slots take heap positions 0, -1, 1, -2, 2... in fill order, so the heaps grow outwards from the median */
+  for(size_t slot = 0; slot < window_length; slot++)
+  {
+    const int slot_position = (int)((slot+1)/2) * ((slot & 1) ? -1 : 1);
+    position[slot]       = slot_position;
+    heap[slot_position]  = (int)slot;
+  }
+}
+median_filter_c::~median_filter_c()
+{
+  free(window);
+  free(position);
+  free(heap_storage);
+}
+
+void median_filter_c::exchange(int i, int j)
+{
+  const int slot = heap[i];
+  heap[i] = heap[j];
+  heap[j] = slot;
+  position[heap[i]] = i;
+  position[heap[j]] = j;
+}
+
+/* Restores the min heap order downwards from position 'child' (> 0), which is first compared with its parent */
+void median_filter_c::min_heap_sift_down(int child)
+{
+  const int count = min_heap_count();
+  for(int i = child; i <= count; i *= 2)
+  {
+    /* Take the smaller sibling */
+    if((i > 1) && (i < count) && less(i+1, i))
+    {
+      i++;
+    }
+    if(!less(i, i/2))
+    {
+      break;
+    }
+    exchange(i, i/2);
+  }
+}
+
+/* Restores the max heap order downwards from position 'child' (< 0), which is first compared with its parent */
+void median_filter_c::max_heap_sift_down(int child)
+{
+  const int count = max_heap_count();
+  for(int i = child; i >= -count; i *= 2)
+  {
+    /* Take the larger sibling */
+    if((i < -1) && (i > -count) && less(i, i-1))
+    {
+      i--;
+    }
+    if(!less(i/2, i))
+    {
+      break;
+    }
+    exchange(i/2, i);
+  }
+}
+
+/* Moves position 'i' (> 0) up the min heap, returns true if it reached the median */
+bool median_filter_c::min_heap_sift_up(int i)
+{
+  while((i > 0) && less(i, i/2))
+  {
+    exchange(i, i/2);
+    i /= 2;
+  }
+  return (0 == i);
+}
+
+/* Moves position 'i' (< 0) up the max heap, returns true if it reached the median */
+bool median_filter_c::max_heap_sift_up(int i)
+{
+  while((i < 0) && less(i/2, i))
+  {
+    exchange(i/2, i);
+    i /= 2;
+  }
+  return (0 == i);
+}
+
+void median_filter_c::push_sample(filter_sample_t sample)
+{
+  /* The new sample takes the slot, and heap position, of the sample leaving the window */
+  const bool            filling  = (window_fill < window_length);
+  const int             i        = position[next_write];
+  const filter_sample_t previous = window[next_write];
+  window[next_write] = sample;
+  next_write = INCREMENT_CIRCULAR_BUFFER_ITERATOR(next_write, window_length);
+  if(filling)
+  {
+    window_fill++;
+  }
+
+  if(i > 0)
+  {
+    if(!filling && (previous < sample))
+    {
+      min_heap_sift_down(i*2);
+    }
+    else if(min_heap_sift_up(i))
+    {
+      /* New median, may now be below the top of the max heap */
+      max_heap_sift_down(-1);
+    }
+  }
+  else if(i < 0)
+  {
+    if(!filling && (sample < previous))
+    {
+      max_heap_sift_down(i*2);
+    }
+    else if(max_heap_sift_up(i))
+    {
+      min_heap_sift_down(1);
+    }
+  }
+  else
+  {
+    if(max_heap_count() > 0)
+    {
+      max_heap_sift_down(-1);
+    }
+    if(min_heap_count() > 0)
+    {
+      min_heap_sift_down(1);
+    }
+  }
+}
+
+void median_filter_c::push_samples(const filter_sample_t *sample, size_t count, filter_sample_t *output)
+{
+  SEISMOMETER_ASSERT(sample != nullptr);
+  SEISMOMETER_ASSERT(output != nullptr);
+  if(window_length > MEDIAN_FILTER_BLOCK_WINDOW_MAX)
+  {
+    for(size_t i = 0; i < count; i++)
+    {
+      push_sample(sample[i]);
+      output[i] = get_median();
+    }
+    return;
+  }
+
+  /* Filled window slots in ascending sample order, slots fill in order so the filled slots are 0 to fill-1 */
+  int    sorted[MEDIAN_FILTER_BLOCK_WINDOW_MAX];
+  size_t fill  = window_fill;
+  size_t write = next_write;
+  for(size_t rank = 0; rank < fill; rank++)
+  {
+    size_t i = rank;
+    for(; (i > 0) && (window[rank] < window[sorted[i-1]]); i--)
+    {
+      sorted[i] = sorted[i-1];
+    }
+    sorted[i] = (int)rank;
+  }
+
+  for(size_t n = 0; n < count; n++)
+  {
+    /* The new sample takes the slot of the sample leaving the window, then moves to its rank */
+    const filter_sample_t value = sample[n];
+    size_t rank = 0;
+    if(fill < window_length)
+    {
+      rank         = fill++;
+      sorted[rank] = (int)write;
+    }
+    else
+    {
+      while(sorted[rank] != (int)write)
+      {
+        rank++;
+      }
+    }
+    window[write] = value;
+    for(; (rank > 0) && (value < window[sorted[rank-1]]); rank--)
+    {
+      sorted[rank]   = sorted[rank-1];
+      sorted[rank-1] = (int)write;
+    }
+    for(; ((rank+1) < fill) && (window[sorted[rank+1]] < value); rank++)
+    {
+      sorted[rank]   = sorted[rank+1];
+      sorted[rank+1] = (int)write;
+    }
+    write = INCREMENT_CIRCULAR_BUFFER_ITERATOR(write, window_length);
+    output[n] = window[sorted[fill/2]];
+  }
+  window_fill = fill;
+  next_write  = write;
+
+  /* A sorted window is a valid double heap, ranks below the median fill the max heap and above it the min heap in
+     order of distance from the median.  Unfilled slots keep their positions */
+  const int median = (int)(fill/2);
+  for(size_t rank = 0; rank < fill; rank++)
+  {
+    const int slot_position = ((int)rank - median);
+    position[sorted[rank]] = slot_position;
+    heap[slot_position]    = sorted[rank];
+  }
+}
\ No newline at end of file
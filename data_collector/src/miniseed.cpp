@@ -0,0 +1,82 @@
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+
+#include "miniseed.hpp"
+#include "seismometer_debug.hpp"
+#include "seismometer_types.hpp"
+
+#define MINISEED_BLOCKETTE_1000        1000
+#define MINISEED_ENCODING_STEIM1       10
+#define MINISEED_WORD_ORDER_BIG_ENDIAN 1
+
+#define MINISEED_BE16(value) __builtin_bswap16(value)
+#define MINISEED_BE32(value) __builtin_bswap32(value)
+
+/* Copies 'code' into the fixed length 'field' padded with spaces */
+static void miniseed_copy_code(char *field, size_t field_length, const char *code)
+{
+  SEISMOMETER_ASSERT(code != nullptr);
+  size_t code_length = strlen(code);
+  SEISMOMETER_ASSERT(code_length <= field_length);
+  memset(field, ' ', field_length);
+  memcpy(field, code, code_length);
+}
+
+void miniseed_build_record(uint8_t *record, const miniseed_nslc_s *nslc, uint32_t sequence_number,
+                           uint64_t start_time_ms, uint16_t sample_rate, const steim1_encoder_c *encoder)
+{
+  SEISMOMETER_ASSERT(record  != nullptr);
+  SEISMOMETER_ASSERT(nslc    != nullptr);
+  SEISMOMETER_ASSERT(encoder != nullptr);
+  SEISMOMETER_ASSERT(MINISEED_RECORD_FRAMES == encoder->get_frame_count());
+  SEISMOMETER_ASSERT((sequence_number > 0) && (sequence_number <= MINISEED_SEQUENCE_NUMBER_MAX));
+
+  seismometer_time_t start_time = (seismometer_time_t)(start_time_ms/1000);
+  seismometer_time_s start_time_s;
+  seismometer_time_t_to_time_s(&start_time, &start_time_s);
+
+  miniseed_fixed_header_s header;
+  char sequence_number_string[sizeof(header.sequence_number)+1];
+  SEISMOMETER_ASSERT_CALL(sizeof(header.sequence_number) == snprintf(sequence_number_string, sizeof(sequence_number_string), "%06lu", (unsigned long)sequence_number));
+  memcpy(header.sequence_number, sequence_number_string, sizeof(header.sequence_number));
+  header.data_quality = 'D';
+  header.reserved     = ' ';
+  miniseed_copy_code(header.station,  sizeof(header.station),  nslc->station);
+  miniseed_copy_code(header.location, sizeof(header.location), nslc->location);
+  miniseed_copy_code(header.channel,  sizeof(header.channel),  nslc->channel);
+  miniseed_copy_code(header.network,  sizeof(header.network),  nslc->network);
+  header.start_year             = MINISEED_BE16((uint16_t)(start_time_s.tm_year+1900));
+  header.start_day_of_year      = MINISEED_BE16((uint16_t)(start_time_s.tm_yday+1));
+  header.start_hour             = start_time_s.tm_hour;
+  header.start_minute           = start_time_s.tm_min;
+  header.start_second           = start_time_s.tm_sec;
+  header.start_unused           = 0;
+  header.start_fraction         = MINISEED_BE16((uint16_t)((start_time_ms%1000)*10));
+  header.sample_count           = MINISEED_BE16(encoder->get_block_sample_count());
+  header.sample_rate_factor     = MINISEED_BE16((int16_t)sample_rate);
+  header.sample_rate_multiplier = MINISEED_BE16((int16_t)1);
+  header.activity_flags         = 0;
+  header.io_flags               = 0;
+  header.data_quality_flags     = 0;
+  header.blockette_count        = 1;
+  header.time_correction        = 0;
+  header.data_offset            = MINISEED_BE16((uint16_t)MINISEED_DATA_OFFSET);
+  header.first_blockette_offset = MINISEED_BE16((uint16_t)sizeof(miniseed_fixed_header_s));
+
+  const miniseed_blockette_1000_s blockette =
+  {
+    .type                  = MINISEED_BE16((uint16_t)MINISEED_BLOCKETTE_1000),
+    .next_blockette_offset = 0,
+    .encoding              = MINISEED_ENCODING_STEIM1,
+    .word_order            = MINISEED_WORD_ORDER_BIG_ENDIAN,
+    .record_length         = MINISEED_RECORD_LENGTH_EXP,
+    .reserved              = 0,
+  };
+
+  memset(record, 0, MINISEED_DATA_OFFSET);
+  memcpy(record, &header, sizeof(header));
+  memcpy(&record[sizeof(header)], &blockette, sizeof(blockette));
+  /* Unused frames of a partial block are zero */
+  memcpy(&record[MINISEED_DATA_OFFSET], encoder->get_block(), (MINISEED_RECORD_SIZE-MINISEED_DATA_OFFSET));
+}
\ No newline at end of file
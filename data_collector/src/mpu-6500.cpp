@@ -2,8 +2,13 @@
 #include <cstdint>
 #include <cstdio>
 
+#include "filter_coefficients.hpp"
+#include "fir_polyphase.hpp"
 #include "mpu-6500.hpp"
+#include "sample_rate.hpp"
+#include "seismometer_config.hpp"
 #include "seismometer_debug.hpp"
+#include "seismometer_utils.hpp"
 
 #define MPU_6500_I2C_ADDRESS 0x69
 
@@ -38,6 +43,39 @@ enum
   ACCEL_ZOUT_L = 64,
   TEMP_OUT_H   = 65,
   TEMP_OUT_L   = 66,
+  USER_CTRL    = 106,
+  FIFO_COUNTH  = 114,
+  FIFO_COUNTL  = 115,
+  FIFO_R_W     = 116,
+};
+
+/* FIFO acquisition, the accelerometer samples at the FIFO rate of the sample rate into the FIFO and is decimated */
+#define MPU_6500_FIFO_SIZE             512
+#define MPU_6500_FIFO_FRAME_SIZE       6 /* ACCEL_XOUT_H to ACCEL_ZOUT_L */
+/* FIFO counts this high are treated as an overflow, the FIFO is reset as frames may no longer be aligned */
+#define MPU_6500_FIFO_OVERFLOW_COUNT   (MPU_6500_FIFO_SIZE-MPU_6500_FIFO_FRAME_SIZE)
+/* Frames read per burst, a late burst reads the rest at the next interrupt */
+#define MPU_6500_FIFO_BURST_FRAMES_MAX (2*SEISMOMETER_MPU_6500_FIFO_BURST_FRAMES)
+
+/* Acquisition at each sample rate.  With the FIFO the accelerometer samples at fifo_rate_hz and is decimated by
+   'decimation' with an anti-alias filter designed relative to the FIFO rate, 500Hz at 50Hz keeps decimation by 10.
+   Without the FIFO the data registers update at 1kHz/(1+register_divider), faster than the sample rate */
+typedef struct
+{
+  uint16_t                    fifo_rate_hz;
+  filter_order_t              decimation;
+  filter_order_t              order;
+  const filter_coefficient_t *coefficient;
+  filter_sample_t             gain_numerator;
+  filter_sample_t             gain_denominator;
+  uint8_t                     register_divider;
+} mpu_6500_rate_config_s;
+static const mpu_6500_rate_config_s mpu_6500_rate_config[SAMPLE_RATE_MAX] =
+{
+  {500,  10, FIR_HAMMING_LPF_DECIMATE_10_ORDER, fir_hamming_lpf_decimate_10, FIR_HAMMING_LPF_DECIMATE_10_GAIN_NUM, FIR_HAMMING_LPF_DECIMATE_10_GAIN_DEN, 7}, /* SAMPLE_RATE_50HZ  */
+  {1000, 10, FIR_HAMMING_LPF_DECIMATE_10_ORDER, fir_hamming_lpf_decimate_10, FIR_HAMMING_LPF_DECIMATE_10_GAIN_NUM, FIR_HAMMING_LPF_DECIMATE_10_GAIN_DEN, 3}, /* SAMPLE_RATE_100HZ */
+  {1000, 5,  FIR_HAMMING_LPF_DECIMATE_5_ORDER,  fir_hamming_lpf_decimate_5,  FIR_HAMMING_LPF_DECIMATE_5_GAIN_NUM,  FIR_HAMMING_LPF_DECIMATE_5_GAIN_DEN,  1}, /* SAMPLE_RATE_200HZ */
+  {1000, 2,  FIR_HAMMING_LPF_DECIMATE_2_ORDER,  fir_hamming_lpf_decimate_2,  FIR_HAMMING_LPF_DECIMATE_2_GAIN_NUM,  FIR_HAMMING_LPF_DECIMATE_2_GAIN_DEN,  0}, /* SAMPLE_RATE_500HZ */
 };
 
 typedef struct 
@@ -48,6 +86,19 @@ typedef struct
 
   mpu_6500_accelerometer_data_s        last_accelerometer_data;
   mpu_6500_temperature_t               last_temperature;
+
+  bool                                 sample_valid;
+  absolute_time_t                      sample_time;           /* Time of last_accelerometer_data */
+  absolute_time_t                      read_time;             /* Time of the register read or FIFO burst in flight */
+
+  /* FIFO acquisition */
+  unsigned int                         fifo_burst_frames;     /* Interrupts per burst */
+  uint32_t                             fifo_frame_period_us;
+  uint32_t                             fifo_filter_delay_us;  /* Group delay of the decimation filter */
+  unsigned int                         fifo_interrupt_count;
+  size_t                               fifo_frames_left;      /* Frames left in the FIFO by a capped burst read */
+  bool                                 fifo_burst_active;
+  mpu_6500_fifo_stats_s                fifo_stats;
 } mpu_6500_s;
 
 static mpu_6500_s mpu_6500_context = 
@@ -56,9 +107,25 @@ static mpu_6500_s mpu_6500_context =
   .acceleration_range      = ACCELEROMETER_02G,
   .accelerometer_offsets   = {0},
   .last_accelerometer_data = {0},
-  .last_temperature        = 0
+  .last_temperature        = 0,
+  .sample_valid            = false,
+  .sample_time             = {0},
+  .read_time               = {0},
+  .fifo_burst_frames       = SEISMOMETER_MPU_6500_FIFO_BURST_FRAMES,
+  .fifo_frame_period_us    = 0,
+  .fifo_filter_delay_us    = 0,
+  .fifo_interrupt_count    = 0,
+  .fifo_frames_left        = 0,
+  .fifo_burst_active       = false,
+  .fifo_stats              = {0},
 };
 
+#if SEISMOMETER_MPU_6500_FIFO
+/* Anti-alias decimation of the FIFO frames per axis, created for the sample rate at init */
+static fir_polyphase_c *mpu_6500_fifo_decimator[3] = {nullptr};
+static uint8_t mpu_6500_fifo_buffer[MPU_6500_FIFO_BURST_FRAMES_MAX*MPU_6500_FIFO_FRAME_SIZE];
+#endif
+
 void mpu_6500_init(seismometer_i2c_handle_s * i2c_inst)
 {
   SEISMOMETER_PRINTF(SEISMOMETER_LOG_INFO, "Initializing MPU-6500.\n");
@@ -68,69 +135,286 @@ void mpu_6500_init(seismometer_i2c_handle_s * i2c_inst)
   uint8_t write_buffer[2];
 
   mpu_6500_context.i2c_handle = i2c_inst;
+  const mpu_6500_rate_config_s *rate_config = &mpu_6500_rate_config[sample_rate_get()];
+#if SEISMOMETER_MPU_6500_FIFO
+  SEISMOMETER_ASSERT((rate_config->fifo_rate_hz/rate_config->decimation) == sample_rate_hz());
+  for(size_t axis = 0; axis < 3; axis++)
+  {
+    mpu_6500_fifo_decimator[axis] = new fir_polyphase_c(rate_config->order, rate_config->coefficient, 1, rate_config->decimation,
+                                                        rate_config->gain_numerator, rate_config->gain_denominator);
+  }
+  /* At least one burst per decimated sample, so each is read before the next sample tick */
+  mpu_6500_context.fifo_burst_frames    = SEISMOMETER_MIN(SEISMOMETER_MPU_6500_FIFO_BURST_FRAMES, rate_config->decimation);
+  mpu_6500_context.fifo_frame_period_us = ((1000*1000)/rate_config->fifo_rate_hz);
+  mpu_6500_context.fifo_filter_delay_us = (((rate_config->order-1)*1000*1000)/(2*rate_config->fifo_rate_hz));
+  SEISMOMETER_PRINTF(SEISMOMETER_LOG_INFO, "MPU-6500 FIFO at %uHz decimated by %u, bursts of %u frames.\n",
+                     rate_config->fifo_rate_hz, rate_config->decimation, mpu_6500_context.fifo_burst_frames);
+#endif
 
-  seismometer_i2c_lock(mpu_6500_context.i2c_handle);
   //Register 107 – Power Management 1
   //Reset device to default settings
   write_buffer[0] = 107;
   write_buffer[1] = (1<<7) /*DEVICE_RESET*/;
-  SEISMOMETER_ASSERT_CALL(2 == i2c_write_blocking(mpu_6500_context.i2c_handle->i2c_inst, MPU_6500_I2C_ADDRESS, write_buffer, 2, false));
+  SEISMOMETER_ASSERT_CALL(seismometer_i2c_transfer_blocking(mpu_6500_context.i2c_handle, MPU_6500_I2C_ADDRESS, write_buffer, 2, nullptr, 0));
   sleep_ms(10);
   //Register 108 – Power Management 2
   write_buffer[0] = 108;
   write_buffer[1] = (0x7) /*DISABLE_X/Y/ZG*/;
-  SEISMOMETER_ASSERT_CALL(2 == i2c_write_blocking(mpu_6500_context.i2c_handle->i2c_inst, MPU_6500_I2C_ADDRESS, write_buffer, 2, false));
+  SEISMOMETER_ASSERT_CALL(seismometer_i2c_transfer_blocking(mpu_6500_context.i2c_handle, MPU_6500_I2C_ADDRESS, write_buffer, 2, nullptr, 0));
   //Register 25 – Sample Rate Divider
   write_buffer[0] = 25;
-  write_buffer[1] = 3; //SAMPLE_RATE = INTERNAL_SAMPLE_RATE / (1 + SMPLRT_DIV) where INTERNAL_SAMPLE_RATE = 1kHz
-  SEISMOMETER_ASSERT_CALL(2 == i2c_write_blocking(mpu_6500_context.i2c_handle->i2c_inst, MPU_6500_I2C_ADDRESS, write_buffer, 2, false));
+#if SEISMOMETER_MPU_6500_FIFO
+  write_buffer[1] = ((1000/rate_config->fifo_rate_hz)-1); //SAMPLE_RATE = INTERNAL_SAMPLE_RATE / (1 + SMPLRT_DIV) where INTERNAL_SAMPLE_RATE = 1kHz
+#else
+  write_buffer[1] = rate_config->register_divider; //SAMPLE_RATE = INTERNAL_SAMPLE_RATE / (1 + SMPLRT_DIV) where INTERNAL_SAMPLE_RATE = 1kHz
+#endif
+  SEISMOMETER_ASSERT_CALL(seismometer_i2c_transfer_blocking(mpu_6500_context.i2c_handle, MPU_6500_I2C_ADDRESS, write_buffer, 2, nullptr, 0));
   //Register 28 – Accelerometer Configuration
   write_buffer[0] = 28;
   write_buffer[1] = (ACCELEROMETER_02G<<3);
-  SEISMOMETER_ASSERT_CALL(2 == i2c_write_blocking(mpu_6500_context.i2c_handle->i2c_inst, MPU_6500_I2C_ADDRESS, write_buffer, 2, false));
+  SEISMOMETER_ASSERT_CALL(seismometer_i2c_transfer_blocking(mpu_6500_context.i2c_handle, MPU_6500_I2C_ADDRESS, write_buffer, 2, nullptr, 0));
   //Register 29 – Accelerometer Configuration 2
   write_buffer[0] = 29;
   write_buffer[1] = (A_DLPF_CFG_092<<0);
-  SEISMOMETER_ASSERT_CALL(2 == i2c_write_blocking(mpu_6500_context.i2c_handle->i2c_inst, MPU_6500_I2C_ADDRESS, write_buffer, 2, false));
+  SEISMOMETER_ASSERT_CALL(seismometer_i2c_transfer_blocking(mpu_6500_context.i2c_handle, MPU_6500_I2C_ADDRESS, write_buffer, 2, nullptr, 0));
+#if SEISMOMETER_MPU_6500_FIFO
+  //Register 26 – Configuration
+  write_buffer[0] = 26;
+  write_buffer[1] = (1<<6) /*FIFO_MODE, stop writing when full*/;
+  SEISMOMETER_ASSERT_CALL(seismometer_i2c_transfer_blocking(mpu_6500_context.i2c_handle, MPU_6500_I2C_ADDRESS, write_buffer, 2, nullptr, 0));
   //Register 35 – FIFO Enable
+  //Temperature is read with the FIFO count instead, it changes too slowly to need 1kHz
   write_buffer[0] = 35;
-  write_buffer[1] = (1<<7) /*TEMP_OUT*/ | (1<<3) /*ACCEL*/;
-// SEISMOMETER_ASSERT_CALL(2 == i2c_write_blocking(mpu_6500_context.i2c_handle->i2c_inst, MPU_6500_I2C_ADDRESS, write_buffer, 2, false));
+  write_buffer[1] = (1<<3) /*ACCEL*/;
+  SEISMOMETER_ASSERT_CALL(seismometer_i2c_transfer_blocking(mpu_6500_context.i2c_handle, MPU_6500_I2C_ADDRESS, write_buffer, 2, nullptr, 0));
   //Register 55 – INT Pin / Bypass Enable Configuration
+  //Active high push-pull 50us pulse per sample, nothing to clear
   write_buffer[0] = 55;
-  write_buffer[1] = (1<<4) /*INT_ANYRD_2CLEAR*/;
-//  SEISMOMETER_ASSERT_CALL(2 == i2c_write_blocking(mpu_6500_context.i2c_handle->i2c_inst, MPU_6500_I2C_ADDRESS, write_buffer, 2, false));
+  write_buffer[1] = 0;
+  SEISMOMETER_ASSERT_CALL(seismometer_i2c_transfer_blocking(mpu_6500_context.i2c_handle, MPU_6500_I2C_ADDRESS, write_buffer, 2, nullptr, 0));
   //Register 56 – Interrupt Enable
   write_buffer[0] = 56;
   write_buffer[1] = (1<<0) /*RAW_RDY_EN*/;
-//  SEISMOMETER_ASSERT_CALL(2 == i2c_write_blocking(mpu_6500_context.i2c_handle->i2c_inst, MPU_6500_I2C_ADDRESS, write_buffer, 2, false));
+  SEISMOMETER_ASSERT_CALL(seismometer_i2c_transfer_blocking(mpu_6500_context.i2c_handle, MPU_6500_I2C_ADDRESS, write_buffer, 2, nullptr, 0));
+  //FIFO is enabled by mpu_6500_fifo_start() once the interrupt is serviced
+#endif
+}
+
+/* Accelerometer and temperature register read, queued at sensor priority */
+static const uint8_t mpu_6500_register_address = ACCEL_XOUT_H;
+static uint8_t       mpu_6500_register_buffer[8];
+static void          mpu_6500_register_read_complete(seismometer_i2c_transaction_s *transaction);
+static seismometer_i2c_transaction_s mpu_6500_register_transaction =
+{
+  .address      = MPU_6500_I2C_ADDRESS,
+  .write_buffer = &mpu_6500_register_address,
+  .write_length = 1,
+  .read_buffer  = mpu_6500_register_buffer,
+  .read_length  = sizeof(mpu_6500_register_buffer),
+  .priority     = SEISMOMETER_I2C_PRIORITY_SENSOR,
+  .callback     = mpu_6500_register_read_complete,
+  .user_data    = nullptr,
+};
 
-  seismometer_i2c_unlock(mpu_6500_context.i2c_handle);
+/* Updates the accelerometer and temperature data from a completed register read */
+static void __time_critical_func(mpu_6500_register_read_complete)(seismometer_i2c_transaction_s *transaction)
+{
+  SEISMOMETER_ASSERT(SEISMOMETER_I2C_STATUS_DONE == transaction->status);
+  const uint8_t *read_buffer = mpu_6500_register_buffer;
+  mpu_6500_context.last_accelerometer_data.x = (read_buffer[0] << 8) | read_buffer[1];
+  mpu_6500_context.last_accelerometer_data.y = (read_buffer[2] << 8) | read_buffer[3];
+  mpu_6500_context.last_accelerometer_data.z = (read_buffer[4] << 8) | read_buffer[5];
+  mpu_6500_context.last_temperature          = (read_buffer[6] << 8) | read_buffer[7];
+  mpu_6500_context.sample_time               = mpu_6500_context.read_time;
+  mpu_6500_context.sample_valid              = true;
 }
 
 void mpu_6500_calibrate()
 {
-  mpu_6500_read();
+  mpu_6500_context.read_time = get_absolute_time();
+  seismometer_i2c_submit(mpu_6500_context.i2c_handle, &mpu_6500_register_transaction);
+  SEISMOMETER_ASSERT_CALL(seismometer_i2c_wait(mpu_6500_context.i2c_handle, &mpu_6500_register_transaction));
 
   mpu_6500_context.accelerometer_offsets.x = -mpu_6500_context.last_accelerometer_data.x;
   mpu_6500_context.accelerometer_offsets.y = -mpu_6500_context.last_accelerometer_data.y;
   mpu_6500_context.accelerometer_offsets.z = ACCELEROMETER_RAW_1G(mpu_6500_context.acceleration_range)-mpu_6500_context.last_accelerometer_data.z;
 }
 
-void __time_critical_func(mpu_6500_read())
+absolute_time_t __time_critical_func(mpu_6500_read())
 {
-  uint8_t read_buffer[8];
-  uint8_t register_address;
+  absolute_time_t ret_val = get_absolute_time();
+#if !SEISMOMETER_MPU_6500_FIFO
+  /* Queue the next register read, this tick takes the one queued a tick earlier */
+  if((SEISMOMETER_I2C_STATUS_QUEUED != mpu_6500_register_transaction.status) &&
+     (SEISMOMETER_I2C_STATUS_ACTIVE != mpu_6500_register_transaction.status))
+  {
+    mpu_6500_context.read_time = ret_val;
+    seismometer_i2c_submit(mpu_6500_context.i2c_handle, &mpu_6500_register_transaction);
+  }
+#endif
+  /* Latest completed sample, no waiting on the bus */
+  if(mpu_6500_context.sample_valid)
+  {
+    ret_val = mpu_6500_context.sample_time;
+  }
+  return ret_val;
+}
 
-  register_address = ACCEL_XOUT_H;
-  seismometer_i2c_lock(mpu_6500_context.i2c_handle);
-  SEISMOMETER_ASSERT_CALL(1 == i2c_write_blocking(mpu_6500_context.i2c_handle->i2c_inst, MPU_6500_I2C_ADDRESS, &register_address, 1, true));
-  SEISMOMETER_ASSERT_CALL(8 == i2c_read_blocking (mpu_6500_context.i2c_handle->i2c_inst, MPU_6500_I2C_ADDRESS, read_buffer,       8, false));
-  seismometer_i2c_unlock(mpu_6500_context.i2c_handle);
-  mpu_6500_context.last_accelerometer_data.x = (read_buffer[0] << 8) | read_buffer[1];
-  mpu_6500_context.last_accelerometer_data.y = (read_buffer[2] << 8) | read_buffer[3];
-  mpu_6500_context.last_accelerometer_data.z = (read_buffer[4] << 8) | read_buffer[5];
-  mpu_6500_context.last_temperature          = (read_buffer[6] << 8) | read_buffer[7];
+#if SEISMOMETER_MPU_6500_FIFO
+void mpu_6500_fifo_start()
+{
+  uint8_t write_buffer[2];
+  //Register 106 – User Control
+  write_buffer[0] = USER_CTRL;
+  write_buffer[1] = (1<<6) /*FIFO_EN*/ | (1<<2) /*FIFO_RST*/;
+  SEISMOMETER_ASSERT_CALL(seismometer_i2c_transfer_blocking(mpu_6500_context.i2c_handle, MPU_6500_I2C_ADDRESS, write_buffer, 2, nullptr, 0));
+  mpu_6500_context.fifo_interrupt_count = 0;
+}
+
+static inline int16_t mpu_6500_saturate(filter_sample_t sample)
+{
+  return (int16_t)((sample > INT16_MAX) ? INT16_MAX : ((sample < INT16_MIN) ? INT16_MIN : sample));
+}
+
+/* A FIFO burst is a chain of sensor priority transactions, each queued by the callback of the one before:
+   FIFO count -> FIFO data (or FIFO reset after an overflow) -> temperature */
+static void mpu_6500_fifo_count_complete      (seismometer_i2c_transaction_s *transaction);
+static void mpu_6500_fifo_data_complete       (seismometer_i2c_transaction_s *transaction);
+static void mpu_6500_fifo_temperature_complete(seismometer_i2c_transaction_s *transaction);
+static const uint8_t mpu_6500_fifo_count_address       = FIFO_COUNTH;
+static const uint8_t mpu_6500_fifo_data_address        = FIFO_R_W;
+static const uint8_t mpu_6500_fifo_temperature_address = TEMP_OUT_H;
+static const uint8_t mpu_6500_fifo_reset_command[2]    = {USER_CTRL, (1<<6) /*FIFO_EN*/ | (1<<2) /*FIFO_RST*/};
+static uint8_t       mpu_6500_fifo_count_buffer[2];
+static uint8_t       mpu_6500_fifo_temperature_buffer[2];
+static seismometer_i2c_transaction_s mpu_6500_fifo_count_transaction =
+{
+  .address      = MPU_6500_I2C_ADDRESS,
+  .write_buffer = &mpu_6500_fifo_count_address,
+  .write_length = 1,
+  .read_buffer  = mpu_6500_fifo_count_buffer,
+  .read_length  = sizeof(mpu_6500_fifo_count_buffer),
+  .priority     = SEISMOMETER_I2C_PRIORITY_SENSOR,
+  .callback     = mpu_6500_fifo_count_complete,
+  .user_data    = nullptr,
+};
+/* FIFO_R_W does not auto-increment, every byte read pops the FIFO.  read_length is set from the FIFO count */
+static seismometer_i2c_transaction_s mpu_6500_fifo_data_transaction =
+{
+  .address      = MPU_6500_I2C_ADDRESS,
+  .write_buffer = &mpu_6500_fifo_data_address,
+  .write_length = 1,
+  .read_buffer  = mpu_6500_fifo_buffer,
+  .read_length  = 0,
+  .priority     = SEISMOMETER_I2C_PRIORITY_SENSOR,
+  .callback     = mpu_6500_fifo_data_complete,
+  .user_data    = nullptr,
+};
+static seismometer_i2c_transaction_s mpu_6500_fifo_reset_transaction =
+{
+  .address      = MPU_6500_I2C_ADDRESS,
+  .write_buffer = mpu_6500_fifo_reset_command,
+  .write_length = sizeof(mpu_6500_fifo_reset_command),
+  .read_buffer  = nullptr,
+  .read_length  = 0,
+  .priority     = SEISMOMETER_I2C_PRIORITY_SENSOR,
+  .callback     = nullptr,
+  .user_data    = nullptr,
+};
+static seismometer_i2c_transaction_s mpu_6500_fifo_temperature_transaction =
+{
+  .address      = MPU_6500_I2C_ADDRESS,
+  .write_buffer = &mpu_6500_fifo_temperature_address,
+  .write_length = 1,
+  .read_buffer  = mpu_6500_fifo_temperature_buffer,
+  .read_length  = sizeof(mpu_6500_fifo_temperature_buffer),
+  .priority     = SEISMOMETER_I2C_PRIORITY_SENSOR,
+  .callback     = mpu_6500_fifo_temperature_complete,
+  .user_data    = nullptr,
+};
+
+/* Queues the FIFO data read for the counted frames, or a FIFO reset after an overflow, then the temperature read */
+static void __time_critical_func(mpu_6500_fifo_count_complete)(seismometer_i2c_transaction_s *transaction)
+{
+  SEISMOMETER_ASSERT(SEISMOMETER_I2C_STATUS_DONE == transaction->status);
+  const size_t fifo_count = (((mpu_6500_fifo_count_buffer[0] & 0x1F) << 8) | mpu_6500_fifo_count_buffer[1]);
+  if(fifo_count >= MPU_6500_FIFO_OVERFLOW_COUNT)
+  {
+    seismometer_i2c_submit(mpu_6500_context.i2c_handle, &mpu_6500_fifo_reset_transaction);
+    mpu_6500_context.fifo_stats.overflow_count++;
+  }
+  else
+  {
+    const size_t fifo_frames = (fifo_count/MPU_6500_FIFO_FRAME_SIZE);
+    const size_t frames      = (fifo_frames < MPU_6500_FIFO_BURST_FRAMES_MAX) ? fifo_frames : MPU_6500_FIFO_BURST_FRAMES_MAX;
+    /* The oldest frames are read first, a capped read leaves the newest in the FIFO for the next burst */
+    mpu_6500_context.fifo_frames_left = (fifo_frames - frames);
+    if(frames > 0)
+    {
+      mpu_6500_fifo_data_transaction.read_length = (frames*MPU_6500_FIFO_FRAME_SIZE);
+      seismometer_i2c_submit(mpu_6500_context.i2c_handle, &mpu_6500_fifo_data_transaction);
+    }
+  }
+  seismometer_i2c_submit(mpu_6500_context.i2c_handle, &mpu_6500_fifo_temperature_transaction);
+}
+
+/* Decimates the frames read, read_time is the time of the interrupt for the newest frame in the FIFO, fifo_frames_left
+   frames after the last one read */
+static void __time_critical_func(mpu_6500_fifo_data_complete)(seismometer_i2c_transaction_s *transaction)
+{
+  SEISMOMETER_ASSERT(SEISMOMETER_I2C_STATUS_DONE == transaction->status);
+  const size_t frames = (transaction->read_length/MPU_6500_FIFO_FRAME_SIZE);
+  mpu_6500_context.fifo_stats.frame_count += frames;
+  for(size_t frame = 0; frame < frames; frame++)
+  {
+    const uint8_t *data = &mpu_6500_fifo_buffer[frame*MPU_6500_FIFO_FRAME_SIZE];
+    filter_sample_t output[3];
+    size_t output_count = 0;
+    for(size_t axis = 0; axis < 3; axis++)
+    {
+      output_count = mpu_6500_fifo_decimator[axis]->push_sample((int16_t)((data[2*axis] << 8) | data[(2*axis)+1]), &output[axis]);
+    }
+    if(output_count > 0)
+    {
+      mpu_6500_context.last_accelerometer_data.x = mpu_6500_saturate(output[0]);
+      mpu_6500_context.last_accelerometer_data.y = mpu_6500_saturate(output[1]);
+      mpu_6500_context.last_accelerometer_data.z = mpu_6500_saturate(output[2]);
+      /* Frames are a FIFO sample period apart, the filter output lags its newest input by the group delay */
+      mpu_6500_context.sample_time  = from_us_since_boot(to_us_since_boot(mpu_6500_context.read_time) -
+                                                         (((mpu_6500_context.fifo_frames_left+frames-1-frame)*mpu_6500_context.fifo_frame_period_us) +
+                                                          mpu_6500_context.fifo_filter_delay_us));
+      mpu_6500_context.sample_valid = true;
+    }
+  }
+}
+
+/* Last transaction of a burst */
+static void __time_critical_func(mpu_6500_fifo_temperature_complete)(seismometer_i2c_transaction_s *transaction)
+{
+  SEISMOMETER_ASSERT(SEISMOMETER_I2C_STATUS_DONE == transaction->status);
+  mpu_6500_context.last_temperature = (mpu_6500_fifo_temperature_buffer[0] << 8) | mpu_6500_fifo_temperature_buffer[1];
+  mpu_6500_context.fifo_stats.burst_count++;
+  mpu_6500_context.fifo_burst_active = false;
+}
+
+void __time_critical_func(mpu_6500_fifo_interrupt)(absolute_time_t time)
+{
+  mpu_6500_context.fifo_interrupt_count++;
+  /* A burst still waiting on the bus is left to finish, the next one reads the extra frames */
+  if((mpu_6500_context.fifo_interrupt_count >= mpu_6500_context.fifo_burst_frames) && !mpu_6500_context.fifo_burst_active)
+  {
+    mpu_6500_context.fifo_interrupt_count = 0;
+    mpu_6500_context.fifo_burst_active    = true;
+    mpu_6500_context.read_time            = time;
+    seismometer_i2c_submit(mpu_6500_context.i2c_handle, &mpu_6500_fifo_count_transaction);
+  }
+}
+#endif
+
+void mpu_6500_get_fifo_stats(mpu_6500_fifo_stats_s *stats)
+{
+  SEISMOMETER_ASSERT(stats != nullptr);
+  *stats = mpu_6500_context.fifo_stats;
 }
 
 void mpu_6500_accelerometer_data_raw(mpu_6500_accelerometer_data_s *accelerometer_data)
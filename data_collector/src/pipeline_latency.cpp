@@ -0,0 +1,179 @@
+#include <cassert>
+#include <cstring>
+
+#include <pico/time.h>
+
+#include "pipeline_latency.hpp"
+#include "seismometer_config.hpp"
+#include "seismometer_debug.hpp"
+#include "seismometer_utils.hpp"
+
+/* Fire times of the ticks which may still be in the sample ring, every tick commits at least 3 samples */
+#define PIPELINE_LATENCY_FIRE_TABLE_SIZE (SEISMOMETER_SAMPLE_QUEUE_SIZE/2)
+static_assert(0 == (PIPELINE_LATENCY_FIRE_TABLE_SIZE & (PIPELINE_LATENCY_FIRE_TABLE_SIZE-1)), "Fire table size must be a power of 2");
+static_assert((3*PIPELINE_LATENCY_FIRE_TABLE_SIZE) >= SEISMOMETER_SAMPLE_QUEUE_SIZE, "Fire table must cover every tick in the sample ring");
+
+typedef struct
+{
+  volatile bool reset_requested; /* Set by the reader, cleared by the writer */
+  uint32_t      count;
+  uint32_t      min_us;
+  uint32_t      max_us;
+  uint32_t      bins[SEISMOMETER_PIPELINE_LATENCY_BINS+1]; /* Last bin counts overflows */
+} pipeline_latency_histogram_s;
+
+typedef struct
+{
+  const char *name;
+  uint32_t    bin_width_us;
+} pipeline_latency_stage_s;
+
+/* Bin widths cover the expected range of each stage, interrupt stages in tens of us, core 0 in ms and the SD card in
+   seconds */
+static const pipeline_latency_stage_s stages[PIPELINE_LATENCY_STAGE_MAX] =
+{
+  {"timer",     2},     /* PIPELINE_LATENCY_TIMER     */
+  {"adc read",  2},     /* PIPELINE_LATENCY_ADC_READ  */
+  {"mpu read",  2},     /* PIPELINE_LATENCY_MPU_READ  */
+  {"enqueue",   4},     /* PIPELINE_LATENCY_ENQUEUE   */
+  {"dequeue",   500},   /* PIPELINE_LATENCY_DEQUEUE   */
+  {"handled",   500},   /* PIPELINE_LATENCY_HANDLED   */
+  {"sd commit", 50000}, /* PIPELINE_LATENCY_SD_COMMIT */
+};
+
+static pipeline_latency_histogram_s histograms[PIPELINE_LATENCY_STAGE_MAX] = {0};
+
+/* Sample timer schedule and fire times, written by the sampler (core 1) */
+static uint32_t       timer_base_us    = 0;
+static sample_index_t timer_base_index = 0;
+static uint32_t       timer_period_us  = 0;
+static uint32_t       fire_us_table[PIPELINE_LATENCY_FIRE_TABLE_SIZE] = {0};
+
+void pipeline_latency_timer_start(absolute_time_t fire_time, sample_index_t index, uint32_t period_us)
+{
+  timer_base_us    = (uint32_t) to_us_since_boot(fire_time);
+  timer_base_index = index;
+  timer_period_us  = period_us;
+}
+
+uint32_t __time_critical_func(pipeline_latency_timer_fire)(sample_index_t index)
+{
+  const uint32_t fire_us      = time_us_32();
+  const uint32_t scheduled_us = timer_base_us + ((index - timer_base_index) * timer_period_us);
+  const int32_t  jitter_us    = (int32_t)(fire_us - scheduled_us);
+  pipeline_latency_record(PIPELINE_LATENCY_TIMER, (jitter_us > 0) ? jitter_us : 0);
+  fire_us_table[index & (PIPELINE_LATENCY_FIRE_TABLE_SIZE-1)] = fire_us;
+  return fire_us;
+}
+
+uint32_t __time_critical_func(pipeline_latency_fire_us)(sample_index_t index)
+{
+  return fire_us_table[index & (PIPELINE_LATENCY_FIRE_TABLE_SIZE-1)];
+}
+
+void __time_critical_func(pipeline_latency_record)(pipeline_latency_stage_e stage, uint32_t latency_us)
+{
+  SEISMOMETER_ASSERT(stage < PIPELINE_LATENCY_STAGE_MAX);
+  pipeline_latency_histogram_s *histogram = &histograms[stage];
+
+  if(histogram->reset_requested)
+  {
+    histogram->count  = 0;
+    histogram->min_us = 0;
+    histogram->max_us = 0;
+    memset(histogram->bins, 0, sizeof(histogram->bins));
+    __dmb();
+    histogram->reset_requested = false;
+  }
+
+  if((0 == histogram->count) || (latency_us < histogram->min_us))
+  {
+    histogram->min_us = latency_us;
+  }
+  if(latency_us > histogram->max_us)
+  {
+    histogram->max_us = latency_us;
+  }
+  histogram->bins[SEISMOMETER_MIN((latency_us / stages[stage].bin_width_us), SEISMOMETER_PIPELINE_LATENCY_BINS)]++;
+  histogram->count++;
+}
+
+/* Returns the upper edge of the bin holding the 'percent'th percentile, histogram read while the writer may update it */
+static uint32_t pipeline_latency_percentile(pipeline_latency_stage_e stage, uint32_t count, uint32_t max_us, uint32_t percent)
+{
+  uint32_t ret_val    = max_us;
+  uint32_t rank       = SEISMOMETER_MAX(((count*percent)+99)/100, 1);
+  uint32_t cumulative = 0;
+  for(uint32_t bin = 0; bin < SEISMOMETER_PIPELINE_LATENCY_BINS; bin++)
+  {
+    cumulative += histograms[stage].bins[bin];
+    if(cumulative >= rank)
+    {
+      ret_val = SEISMOMETER_MIN(((bin+1)*stages[stage].bin_width_us), max_us);
+      break;
+    }
+  }
+  return ret_val;
+}
+
+void pipeline_latency_get_summary(pipeline_latency_stage_e stage, pipeline_latency_summary_s *summary, bool reset)
+{
+  SEISMOMETER_ASSERT(stage < PIPELINE_LATENCY_STAGE_MAX);
+  SEISMOMETER_ASSERT(summary != nullptr);
+  const pipeline_latency_histogram_s *histogram = &histograms[stage];
+
+  memset(summary, 0, sizeof(pipeline_latency_summary_s));
+  /* A reset not yet applied by the writer leaves nothing recorded since */
+  if(!histogram->reset_requested)
+  {
+    summary->count          = histogram->count;
+    summary->overflow_count = histogram->bins[SEISMOMETER_PIPELINE_LATENCY_BINS];
+    summary->min_us         = histogram->min_us;
+    summary->max_us         = histogram->max_us;
+    if(summary->count > 0)
+    {
+      summary->p50_us = pipeline_latency_percentile(stage, summary->count, summary->max_us, 50);
+      summary->p90_us = pipeline_latency_percentile(stage, summary->count, summary->max_us, 90);
+      summary->p99_us = pipeline_latency_percentile(stage, summary->count, summary->max_us, 99);
+    }
+  }
+
+  if(reset)
+  {
+    histograms[stage].reset_requested = true;
+  }
+}
+
+void pipeline_latency_log(bool bins, bool reset)
+{
+  for(unsigned int stage = 0; stage < PIPELINE_LATENCY_STAGE_MAX; stage++)
+  {
+    pipeline_latency_summary_s summary;
+    /* Bins are logged before the reset is requested */
+    pipeline_latency_get_summary((pipeline_latency_stage_e) stage, &summary, false);
+    SEISMOMETER_PRINTF(SEISMOMETER_LOG_INFO, "Latency %s n %lu min %lu p50 %lu p90 %lu p99 %lu max %lu over %lu us\n",
+      stages[stage].name, summary.count, summary.min_us, summary.p50_us, summary.p90_us, summary.p99_us, summary.max_us, summary.overflow_count);
+    if(bins && !histograms[stage].reset_requested)
+    {
+      for(uint32_t bin = 0; bin <= SEISMOMETER_PIPELINE_LATENCY_BINS; bin++)
+      {
+        const uint32_t bin_count = histograms[stage].bins[bin];
+        if(bin_count > 0)
+        {
+          if(SEISMOMETER_PIPELINE_LATENCY_BINS == bin)
+          {
+            SEISMOMETER_PRINTF(SEISMOMETER_LOG_INFO, "  >=%luus %lu\n", (bin*stages[stage].bin_width_us), bin_count);
+          }
+          else
+          {
+            SEISMOMETER_PRINTF(SEISMOMETER_LOG_INFO, "  %lu-%luus %lu\n", (bin*stages[stage].bin_width_us), ((bin+1)*stages[stage].bin_width_us), bin_count);
+          }
+        }
+      }
+    }
+    if(reset)
+    {
+      histograms[stage].reset_requested = true;
+    }
+  }
+}
\ No newline at end of file
@@ -5,6 +5,7 @@
 #include <hardware/rtc.h>
 #include <pico/sync.h>
 
+#include "clock_discipline.hpp"
 #include "rtc_ds3231.hpp"
 #include "seismometer_debug.hpp"
 #include "seismometer_utils.hpp"
@@ -42,9 +43,20 @@ typedef struct
   void                     *alarm1_user_data_ptr;
   rtc_ds3231_alarm_cb       alarm2_cb;
   void                     *alarm2_user_data_ptr;
-
+  rtc_ds3231_tick_cb        tick_cb;
+  void                     *tick_user_data_ptr;
+
+  /* Asynchronous register read of each tick, then the alarm flags are cleared */
+  seismometer_i2c_transaction_s read_transaction;
+  seismometer_i2c_transaction_s clear_flags_transaction;
+  absolute_time_t               read_reference;
+  uint8_t                       read_buffer[19];
+  uint8_t                       clear_flags_buffer[2];
 } rtc_ds3231_s;
 
+static const uint8_t rtc_ds3231_read_address = 0x00;
+static void rtc_ds3231_read_complete(seismometer_i2c_transaction_s *transaction);
+
 static rtc_ds3231_s context = 
 {
   .i2c_handle           = nullptr,
@@ -56,6 +68,35 @@ static rtc_ds3231_s context =
   .alarm1_user_data_ptr = nullptr,
   .alarm2_cb            = nullptr,
   .alarm2_user_data_ptr = nullptr,
+  .tick_cb              = nullptr,
+  .tick_user_data_ptr   = nullptr,
+
+  /* Read all 19 registers from register 0x00 */
+  .read_transaction =
+  {
+    .address      = RTC_DS3231_I2C_ADDRESS,
+    .write_buffer = &rtc_ds3231_read_address,
+    .write_length = 1,
+    .read_buffer  = context.read_buffer,
+    .read_length  = sizeof(context.read_buffer),
+    .priority     = SEISMOMETER_I2C_PRIORITY_TIMING,
+    .callback     = rtc_ds3231_read_complete,
+    .user_data    = nullptr,
+  },
+  .clear_flags_transaction =
+  {
+    .address      = RTC_DS3231_I2C_ADDRESS,
+    .write_buffer = context.clear_flags_buffer,
+    .write_length = sizeof(context.clear_flags_buffer),
+    .read_buffer  = nullptr,
+    .read_length  = 0,
+    .priority     = SEISMOMETER_I2C_PRIORITY_TIMING,
+    .callback     = nullptr,
+    .user_data    = nullptr,
+  },
+  .read_reference       = {0},
+  .read_buffer          = {0},
+  .clear_flags_buffer   = {0},
 };
 
 
@@ -71,37 +112,35 @@ void rtc_ds3231_init(seismometer_i2c_handle_s *i2c_handle)
   //Write buffer index 1 is write data
   uint8_t write_buffer[2];
 
-  seismometer_i2c_lock(context.i2c_handle);
-
   //Register 0x07 – Alarm 1 Second
   write_buffer[0] = 0x07;
   write_buffer[1] = 0x0 /* match when seconds is 00 */;
-  SEISMOMETER_ASSERT_CALL(2 == i2c_write_blocking(context.i2c_handle->i2c_inst, RTC_DS3231_I2C_ADDRESS, write_buffer, 2, false));
+  SEISMOMETER_ASSERT_CALL(seismometer_i2c_transfer_blocking(context.i2c_handle, RTC_DS3231_I2C_ADDRESS, write_buffer, 2, nullptr, 0));
   //Register 0x08 – Alarm 1 Minute
   write_buffer[0] = 0x08;
   write_buffer[1] = (1<<7) /* A1M2 - match any minute */;
-  SEISMOMETER_ASSERT_CALL(2 == i2c_write_blocking(context.i2c_handle->i2c_inst, RTC_DS3231_I2C_ADDRESS, write_buffer, 2, false));
+  SEISMOMETER_ASSERT_CALL(seismometer_i2c_transfer_blocking(context.i2c_handle, RTC_DS3231_I2C_ADDRESS, write_buffer, 2, nullptr, 0));
   //Register 0x09 – Alarm 1 Hour
   write_buffer[0] = 0x09;
   write_buffer[1] = (1<<7) /* A1M2 - match any hour */;
-  SEISMOMETER_ASSERT_CALL(2 == i2c_write_blocking(context.i2c_handle->i2c_inst, RTC_DS3231_I2C_ADDRESS, write_buffer, 2, false));
+  SEISMOMETER_ASSERT_CALL(seismometer_i2c_transfer_blocking(context.i2c_handle, RTC_DS3231_I2C_ADDRESS, write_buffer, 2, nullptr, 0));
   //Register 0x0a – Alarm 1 Day
   write_buffer[0] = 0x0a;
   write_buffer[1] = (1<<7) /* A1M2 - match any day */;
-  SEISMOMETER_ASSERT_CALL(2 == i2c_write_blocking(context.i2c_handle->i2c_inst, RTC_DS3231_I2C_ADDRESS, write_buffer, 2, false));
+  SEISMOMETER_ASSERT_CALL(seismometer_i2c_transfer_blocking(context.i2c_handle, RTC_DS3231_I2C_ADDRESS, write_buffer, 2, nullptr, 0));
 
   //Register 0x0b – Alarm 2 Minute
   write_buffer[0] = 0x0b;
   write_buffer[1] = 0x00 /* Match minute 00 */;
-  SEISMOMETER_ASSERT_CALL(2 == i2c_write_blocking(context.i2c_handle->i2c_inst, RTC_DS3231_I2C_ADDRESS, write_buffer, 2, false));
+  SEISMOMETER_ASSERT_CALL(seismometer_i2c_transfer_blocking(context.i2c_handle, RTC_DS3231_I2C_ADDRESS, write_buffer, 2, nullptr, 0));
   //Register 0x0c – Alarm 2 Hour
   write_buffer[0] = 0x0c;
   write_buffer[1] = (1<<7) /* Match any hour */;
-  SEISMOMETER_ASSERT_CALL(2 == i2c_write_blocking(context.i2c_handle->i2c_inst, RTC_DS3231_I2C_ADDRESS, write_buffer, 2, false));
+  SEISMOMETER_ASSERT_CALL(seismometer_i2c_transfer_blocking(context.i2c_handle, RTC_DS3231_I2C_ADDRESS, write_buffer, 2, nullptr, 0));
   //Register 0x0d – Alarm 2 Day
   write_buffer[0] = 0x0d;
   write_buffer[1] = (1<<7) /* Match any day */;
-  SEISMOMETER_ASSERT_CALL(2 == i2c_write_blocking(context.i2c_handle->i2c_inst, RTC_DS3231_I2C_ADDRESS, write_buffer, 2, false));
+  SEISMOMETER_ASSERT_CALL(seismometer_i2c_transfer_blocking(context.i2c_handle, RTC_DS3231_I2C_ADDRESS, write_buffer, 2, nullptr, 0));
 
 
   //Register 0x0E – Control Register
@@ -110,39 +149,43 @@ void rtc_ds3231_init(seismometer_i2c_handle_s *i2c_handle)
 //  write_buffer[1] = (1<<2) /*INTCN*/ | (1<<0) /*A1IE*/;
   /* Configure 1Hz square wave and register for Alarm 1*/
   write_buffer[1] = (1<<1) /*A2IE*/ | (1<<0) /*A1IE*/;
-  SEISMOMETER_ASSERT_CALL(2 == i2c_write_blocking(context.i2c_handle->i2c_inst, RTC_DS3231_I2C_ADDRESS, write_buffer, 2, false));
+  SEISMOMETER_ASSERT_CALL(seismometer_i2c_transfer_blocking(context.i2c_handle, RTC_DS3231_I2C_ADDRESS, write_buffer, 2, nullptr, 0));
   //Register 0x0F - Status/Control Register
   write_buffer[0] = 0x0F;
-  SEISMOMETER_ASSERT_CALL(1 == i2c_write_blocking(context.i2c_handle->i2c_inst, RTC_DS3231_I2C_ADDRESS, write_buffer, 1, false));
   /* Get current status register */
-  SEISMOMETER_ASSERT_CALL(1 == i2c_read_blocking(context.i2c_handle->i2c_inst, RTC_DS3231_I2C_ADDRESS, &write_buffer[1], 1, false));
+  SEISMOMETER_ASSERT_CALL(seismometer_i2c_transfer_blocking(context.i2c_handle, RTC_DS3231_I2C_ADDRESS, write_buffer, 1, &write_buffer[1], 1));
   SEISMOMETER_PRINTF(SEISMOMETER_LOG_INFO, "RTC status register 0x%x\n", write_buffer[1]);
   /* Leave current status unmodified, disable clock pin and clear alarm states */
   write_buffer[1] &= ~((1<<3) /* EN32kHz*/ | (1<<1) /* A2F*/ | (1<<0) /* A1F*/);
-  SEISMOMETER_ASSERT_CALL(2 == i2c_write_blocking(context.i2c_handle->i2c_inst, RTC_DS3231_I2C_ADDRESS, write_buffer, 2, false));
-
-  seismometer_i2c_unlock(context.i2c_handle);
+  SEISMOMETER_ASSERT_CALL(seismometer_i2c_transfer_blocking(context.i2c_handle, RTC_DS3231_I2C_ADDRESS, write_buffer, 2, nullptr, 0));
+}
 
+static void rtc_ds3231_data_to_time_s(const rtc_ds3231_data_s *data, seismometer_time_s *time)
+{
+  *time = {0};
+  time->tm_sec   = (data->seconds  % 60);  /* 0-59 */
+  time->tm_min   = (data->minutes  % 60);  /* 0-59 */
+  time->tm_hour  = (data->hours    % 24);  /* 0-24 */
+  time->tm_mday  = (data->date     % 32);  /* 1-31 */
+  if(time->tm_mday == 0)      { time->tm_mday++; }
+  time->tm_mon   = ((data->month-1)% 12);  /* 0-11 */
+  time->tm_year  = (data->year     % 100); /* 0-199 */
+  if(data->century==true) { time->tm_year += 100; }
+  time->tm_wday  = ((data->day-1)  % 7);   /* 0-6 */
+  time->tm_isdst = false;                  /* no DST */
 }
 
-void rtc_ds3231_read(absolute_time_t reference)
+/* Handles the register read queued by rtc_ds3231_read(), in the I2C engine interrupt */
+static void rtc_ds3231_read_complete(seismometer_i2c_transaction_s *transaction)
 {
-  seismometer_i2c_lock(context.i2c_handle);
+  SEISMOMETER_ASSERT(SEISMOMETER_I2C_STATUS_DONE == transaction->status);
+  const uint8_t         *read_buffer = context.read_buffer;
+  const absolute_time_t  reference   = context.read_reference;
 
-  /* Reset register address to 0x00 */
-  uint8_t write_buffer[2];
-  write_buffer[0]=0x00;
-  SEISMOMETER_ASSERT_CALL(1 == i2c_write_blocking(context.i2c_handle->i2c_inst, RTC_DS3231_I2C_ADDRESS, write_buffer, 1, true));
-  /* Read all 19 registers */
-  uint8_t read_buffer[19];
-  /* Get current status register */
-  SEISMOMETER_ASSERT_CALL(19 == i2c_read_blocking(context.i2c_handle->i2c_inst, RTC_DS3231_I2C_ADDRESS, read_buffer, 19, false));
   /* Reset alarm interrupt flags */
-  write_buffer[0] = 0x0F;
-  write_buffer[1] = read_buffer[0xF] & ~((1<<1) /* A2F*/ | (1<<0) /* A1F*/);
-  SEISMOMETER_ASSERT_CALL(2 == i2c_write_blocking(context.i2c_handle->i2c_inst, RTC_DS3231_I2C_ADDRESS, write_buffer, 2, false));
-
-  seismometer_i2c_unlock(context.i2c_handle);
+  context.clear_flags_buffer[0] = 0x0F;
+  context.clear_flags_buffer[1] = read_buffer[0xF] & ~((1<<1) /* A2F*/ | (1<<0) /* A1F*/);
+  seismometer_i2c_submit(context.i2c_handle, &context.clear_flags_transaction);
 
   /* Parse new data */
   rtc_ds3231_data_s new_data = {0};
@@ -190,6 +233,11 @@ void rtc_ds3231_read(absolute_time_t reference)
   context.reference_time = reference;
   critical_section_exit(&context.critical_section);
 
+  /* Epoch time is computed once per tick so per sample conversions avoid mktime */
+  seismometer_time_s new_time;
+  rtc_ds3231_data_to_time_s(&new_data, &new_time);
+  clock_discipline_tick(to_us_since_boot(reference), TIME_S_TO_MS((uint64_t)seismometer_time_s_to_time_t(&new_time)));
+
   /* Handle alarms */
   if(new_data.alarm1_triggered && (context.alarm1_cb != nullptr))
   {
@@ -199,6 +247,25 @@ void rtc_ds3231_read(absolute_time_t reference)
   {
     context.alarm2_cb(context.alarm2_user_data_ptr);
   }
+  if(context.tick_cb != nullptr)
+  {
+    context.tick_cb(reference, context.tick_user_data_ptr);
+  }
+}
+
+void rtc_ds3231_read(absolute_time_t reference)
+{
+  /* Ticks are a second apart, the previous read is long complete */
+  SEISMOMETER_ASSERT((SEISMOMETER_I2C_STATUS_QUEUED != context.read_transaction.status) &&
+                     (SEISMOMETER_I2C_STATUS_ACTIVE != context.read_transaction.status));
+  context.read_reference = reference;
+  seismometer_i2c_submit(context.i2c_handle, &context.read_transaction);
+}
+
+void rtc_ds3231_read_blocking(absolute_time_t reference)
+{
+  rtc_ds3231_read(reference);
+  SEISMOMETER_ASSERT_CALL(seismometer_i2c_wait(context.i2c_handle, &context.read_transaction));
 }
 
 void rtc_ds3231_set(const seismometer_time_t time)
@@ -208,18 +275,14 @@ void rtc_ds3231_set(const seismometer_time_t time)
 
   uint8_t write_buffer[8] = {0};
 
-
-  seismometer_i2c_lock(context.i2c_handle);
-
   /* Reset oscillator stopped status to indicate data is good */
   write_buffer[0] = 0x0F;
-  SEISMOMETER_ASSERT_CALL(1 == i2c_write_blocking(context.i2c_handle->i2c_inst, RTC_DS3231_I2C_ADDRESS, write_buffer, 1, false));
   /* Get current status register */
-  SEISMOMETER_ASSERT_CALL(1 == i2c_read_blocking(context.i2c_handle->i2c_inst, RTC_DS3231_I2C_ADDRESS, &write_buffer[1], 1, false));
+  SEISMOMETER_ASSERT_CALL(seismometer_i2c_transfer_blocking(context.i2c_handle, RTC_DS3231_I2C_ADDRESS, write_buffer, 1, &write_buffer[1], 1));
   SEISMOMETER_PRINTF(SEISMOMETER_LOG_INFO, "RTC status register 0x%x\n", write_buffer[1]);
   /* Clear Oscillator Stop Flag */
   write_buffer[1] &= ~((1<<7) /* OSF */);
-  SEISMOMETER_ASSERT_CALL(2 == i2c_write_blocking(context.i2c_handle->i2c_inst, RTC_DS3231_I2C_ADDRESS, write_buffer, 2, false));
+  SEISMOMETER_ASSERT_CALL(seismometer_i2c_transfer_blocking(context.i2c_handle, RTC_DS3231_I2C_ADDRESS, write_buffer, 2, nullptr, 0));
 
 
   write_buffer[0]=0x00; /* Reset register address to 0x00 */
@@ -233,9 +296,7 @@ void rtc_ds3231_set(const seismometer_time_t time)
   write_buffer[1+0x5]=(((time_s.tm_mon+1)%10)  & 0xF) | ((((time_s.tm_mon+1)/10)  & 0x1)<<4);
   if(time_s.tm_year>=100){ write_buffer[1+0x5] |= (1<<7); }
   write_buffer[1+0x6]=((time_s.tm_year%10) & 0xF) | ((((time_s.tm_year/10)%10) & 0xF)<<4);
-  SEISMOMETER_ASSERT_CALL(8 == i2c_write_blocking(context.i2c_handle->i2c_inst, RTC_DS3231_I2C_ADDRESS, write_buffer, 8, false));
-  seismometer_i2c_unlock(context.i2c_handle);
-
+  SEISMOMETER_ASSERT_CALL(seismometer_i2c_transfer_blocking(context.i2c_handle, RTC_DS3231_I2C_ADDRESS, write_buffer, 8, nullptr, 0));
 }
 
 absolute_time_t rtc_ds3231_get_time(seismometer_time_s *time)
@@ -247,17 +308,7 @@ absolute_time_t rtc_ds3231_get_time(seismometer_time_s *time)
   absolute_time_t   ret_val   = context.reference_time;
   critical_section_exit(&context.critical_section);
 
-  *time = {0};
-  time->tm_sec   = (data_copy.seconds  % 60);  /* 0-59 */
-  time->tm_min   = (data_copy.minutes  % 60);  /* 0-59 */
-  time->tm_hour  = (data_copy.hours    % 24);  /* 0-24 */
-  time->tm_mday  = (data_copy.date     % 32);  /* 1-31 */
-  if(time->tm_mday == 0)      { time->tm_mday++; }
-  time->tm_mon   = ((data_copy.month-1)% 12);  /* 0-11 */
-  time->tm_year  = (data_copy.year     % 100); /* 0-199 */
-  if(data_copy.century==true) { time->tm_year += 100; }
-  time->tm_wday  = ((data_copy.day-1)  % 7);   /* 0-6 */
-  time->tm_isdst = false;                     /* no DST */
+  rtc_ds3231_data_to_time_s(&data_copy, time);
 
   return ret_val;
 }
@@ -272,12 +323,13 @@ void rtc_ds3231_set_alarm2_cb(rtc_ds3231_alarm_cb cb, void* user_data_ptr)
   context.alarm2_cb            = cb;
   context.alarm2_user_data_ptr = user_data_ptr;
 }
-
-uint64_t rtc_ds3231_absolute_time_to_epoch_ms(absolute_time_t t)
+void rtc_ds3231_set_tick_cb(rtc_ds3231_tick_cb cb, void* user_data_ptr)
 {
-  seismometer_time_s time;
-  absolute_time_t    reference_time = rtc_ds3231_get_time(&time);
-  seismometer_time_t epoch = seismometer_time_s_to_time_t(&time);
+  context.tick_cb            = cb;
+  context.tick_user_data_ptr = user_data_ptr;
+}
 
-  return (TIME_S_TO_MS(epoch) + TIME_US_TO_MS(absolute_time_diff_us(reference_time, t)));
+uint64_t __time_critical_func(rtc_ds3231_absolute_time_to_epoch_ms)(absolute_time_t t)
+{
+  return clock_discipline_epoch_ms(to_us_since_boot(t));
 }
\ No newline at end of file
@@ -0,0 +1,857 @@
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+
+#include <f_util.h>
+#include <ff.h>
+#include <pico/time.h>
+#include <pico/util/queue.h>
+#ifdef ENABLE_ZLIB_DATA_FILE_COMPRESSION
+#include <zlib.h>
+#endif
+
+#include "pipeline_latency.hpp"
+#include "rtc_ds3231.hpp"
+#include "sample_file.hpp"
+#include "sample_rate.hpp"
+#include "sample_record.hpp"
+#include "sd_card_spi.hpp"
+#include "seismometer_config.hpp"
+#include "seismometer_debug.hpp"
+#include "seismometer_utils.hpp"
+
+#define SAMPLE_FILE_SECTOR_SIZE 512
+static_assert((SEISMOMETER_SAMPLE_FILE_BUFFER_SIZE > 0) && (0 == (SEISMOMETER_SAMPLE_FILE_BUFFER_SIZE % SAMPLE_FILE_SECTOR_SIZE)),
+              "Sample file staging buffer must be a whole number of sectors");
+static_assert(SEISMOMETER_SAMPLE_FILE_BUFFER_COUNT >= 3, "Sample file writer needs at least three staging buffers");
+static_assert(SEISMOMETER_SAMPLE_FILE_BUFFER_COUNT < UINT8_MAX, "Sample file staging buffer index must fit in a uint8_t");
+static_assert(SEISMOMETER_SAMPLE_FILE_EVENT_BUFFER_RESERVE < SEISMOMETER_SAMPLE_FILE_BUFFER_COUNT, "Event file needs staging buffers beyond the reserve");
+static_assert((sizeof(sample_record_sample_s) <= UINT8_MAX) && (sizeof(sample_record_steim1_block_s) <= UINT8_MAX),
+              "Sample record sizes must fit in the file header's uint8_t sample_record_size");
+
+/* Requests from the sample handler (core 0) to the sample file writer (core 1).  Data and file operations
+   share a single queue so they are applied to the file in the order they were requested */
+typedef enum
+{
+  SAMPLE_FILE_REQUEST_INVALID,
+  SAMPLE_FILE_REQUEST_WRITE,    /* Write 'length' bytes from staging buffer 'buffer' */
+  SAMPLE_FILE_REQUEST_TICK,     /* Mount and open as needed, flush and sync */
+  SAMPLE_FILE_REQUEST_CLOSE,    /* Flush and close */
+  SAMPLE_FILE_REQUEST_ROLLOVER, /* Close and reopen with new date-stamp */
+  SAMPLE_FILE_REQUEST_EVENT_OPEN,  /* Open a new time-stamped event file */
+  SAMPLE_FILE_REQUEST_EVENT_WRITE, /* Write 'length' bytes from staging buffer 'buffer' to the event file */
+  SAMPLE_FILE_REQUEST_EVENT_CLOSE, /* Close the event file */
+} sample_file_request_type_e;
+
+typedef struct
+{
+  sample_file_request_type_e type;
+  sample_file_format_e       format;
+  uint8_t                    buffer;
+  size_t                     length;
+  uint32_t                   staged_us; /* time_us_32() of the first byte staged in 'buffer' */
+} sample_file_request_s;
+
+/* Requests beyond one per staging buffer, covers ~16 seconds of RTC ticks while the writer is stalled */
+#define SAMPLE_FILE_REQUEST_QUEUE_SIZE (SEISMOMETER_SAMPLE_FILE_BUFFER_COUNT+16)
+
+static uint8_t staging_buffer[SEISMOMETER_SAMPLE_FILE_BUFFER_COUNT][SEISMOMETER_SAMPLE_FILE_BUFFER_SIZE];
+static queue_t free_buffer_queue = {0}; /* Indices of staging buffers returned by the writer */
+static queue_t request_queue     = {0};
+
+/* Sample handler (core 0) state */
+static sample_file_format_e sample_file_format = SEISMOMETER_SAMPLE_FILE_FORMAT_DEFAULT;
+static uint8_t              current_buffer        = 0;
+static size_t               current_buffer_length = 0;
+static uint32_t             current_buffer_staged_us = 0;
+/* The event file stream only holds a staging buffer while it has data staged */
+#define SAMPLE_FILE_NO_BUFFER UINT8_MAX
+static uint8_t              event_buffer          = SAMPLE_FILE_NO_BUFFER;
+static size_t               event_buffer_length   = 0;
+
+/* Statistics, each counter has a single writer so may be read from either core without locking */
+static volatile uint32_t bytes_submitted = 0; /* Written by core 0 */
+static volatile uint32_t bytes_dropped   = 0; /* Written by core 0 */
+static volatile uint32_t requests_dropped= 0; /* Written by core 0 */
+static volatile uint32_t bytes_committed = 0; /* Written by core 1 */
+static volatile uint32_t bytes_pending_max = 0;  /* Written by core 1 */
+static volatile uint32_t stall_us_last     = 0;  /* Written by core 1 */
+static volatile uint32_t stall_us_max      = 0;  /* Written by core 1 */
+static volatile uint32_t stall_count       = 0;  /* Written by core 1 */
+
+/* Sample file writer (core 1) state */
+/* Length of sample data filename not including null character i.e. 'seismometer_2023-03-06T12.dat\0' */
+#define SAMPLE_DATA_FILENAME_LENGTH 29
+static FIL     sample_data_file;
+static bool    sample_data_file_opened   = false;
+static bool    sample_data_file_unsynced          = false; /* Data was written since the last f_sync */
+#ifdef ENABLE_ZLIB_DATA_FILE_COMPRESSION
+static char    sample_file_filename[SAMPLE_DATA_FILENAME_LENGTH+COMPRESSED_FILE_FILENAME_EXTENSION_LENGTH+1] = {'\0'};
+#else
+static char    sample_file_filename[SAMPLE_DATA_FILENAME_LENGTH+1]  = {'\0'};
+#endif
+static const char *const sample_file_filename_format[SAMPLE_FILE_FORMAT_MAX] =
+{
+  "seismometer_%FT%H.dat", /* SAMPLE_FILE_FORMAT_ASCII  */
+  "seismometer_%FT%H.bin", /* SAMPLE_FILE_FORMAT_BINARY */
+  "seismometer_%FT%H.stm", /* SAMPLE_FILE_FORMAT_STEIM1 */
+  "seismometer_%FT%H.msd", /* SAMPLE_FILE_FORMAT_MINISEED */
+};
+/* Data is only written to FatFs in blocks which end on a sector boundary so FatFs can write whole sectors directly
+   to the card without its own read-modify-write.  Data short of the next sector boundary is carried over */
+static uint8_t sector_carry_buffer[SAMPLE_FILE_SECTOR_SIZE];
+static size_t  sector_carry_length = 0;
+static FSIZE_t sample_data_file_offset = 0;
+#ifdef ENABLE_ZLIB_DATA_FILE_COMPRESSION
+/* Sample data is deflated inline as it is written, each time the file is opened a new gzip member is appended so a
+   file reopened after a reboot is still a valid gzip file.  Flush points bound the data lost to a power failure */
+static z_stream deflate_stream;
+static bool     deflate_stream_active = false;
+static uint32_t deflate_flush_ticks   = 0;
+static uint8_t  deflate_buffer[SEISMOMETER_SAMPLE_FILE_DEFLATE_BUFFER_SIZE];
+#endif
+/* Length of event filename not including null character i.e. 'event_2023-03-06T123456.bin\0' */
+#define EVENT_FILENAME_LENGTH 27
+static FIL     event_file;
+static bool    event_file_opened   = false;
+static bool    event_file_unsynced = false; /* Data was written since the last f_sync */
+static char    event_file_filename[EVENT_FILENAME_LENGTH+1] = {'\0'};
+
+void sample_file_init()
+{
+  SEISMOMETER_PRINTF(SEISMOMETER_LOG_INFO, "Initializing sample file writer with %u %u byte staging buffers.\n", SEISMOMETER_SAMPLE_FILE_BUFFER_COUNT, SEISMOMETER_SAMPLE_FILE_BUFFER_SIZE);
+  queue_init(&free_buffer_queue, sizeof(uint8_t),               SEISMOMETER_SAMPLE_FILE_BUFFER_COUNT);
+  queue_init(&request_queue,     sizeof(sample_file_request_s), SAMPLE_FILE_REQUEST_QUEUE_SIZE);
+
+  /* Buffer 0 is the first buffer filled, the rest are free */
+  current_buffer        = 0;
+  current_buffer_length = 0;
+  for(uint8_t i = 1; i < SEISMOMETER_SAMPLE_FILE_BUFFER_COUNT; i++)
+  {
+    SEISMOMETER_ASSERT_CALL(queue_try_add(&free_buffer_queue, &i));
+  }
+}
+
+/************************************************************************************************************
+ * Sample handler (core 0)
+ ************************************************************************************************************/
+static bool sample_file_request(sample_file_request_type_e type)
+{
+  sample_file_request_s request =
+  {
+    .type      = type,
+    .format    = sample_file_format,
+    .buffer    = 0,
+    .length    = 0,
+    .staged_us = 0,
+  };
+  bool ret_val = queue_try_add(&request_queue, &request);
+  if(!ret_val)
+  {
+    requests_dropped++;
+  }
+  return ret_val;
+}
+
+/* Hands the current staging buffer to the writer and starts the next free buffer.
+   Returns false, keeping the current buffer, if no free buffer is available */
+static bool staging_buffer_submit()
+{
+  bool ret_val = true;
+
+  if(current_buffer_length > 0)
+  {
+    uint8_t next_buffer;
+    if(queue_try_remove(&free_buffer_queue, &next_buffer))
+    {
+      sample_file_request_s request =
+      {
+        .type      = SAMPLE_FILE_REQUEST_WRITE,
+        .format    = sample_file_format,
+        .buffer    = current_buffer,
+        .length    = current_buffer_length,
+        .staged_us = current_buffer_staged_us,
+      };
+      /* Request queue has room for every staging buffer so this can not fail */
+      SEISMOMETER_ASSERT_CALL(queue_try_add(&request_queue, &request));
+      bytes_submitted      += current_buffer_length;
+      current_buffer        = next_buffer;
+      current_buffer_length = 0;
+    }
+    else
+    {
+      ret_val = false;
+    }
+  }
+
+  return ret_val;
+}
+
+void sample_file_write(const void *data, size_t length)
+{
+  SEISMOMETER_ASSERT(data != nullptr);
+  SEISMOMETER_ASSERT(length <= SEISMOMETER_SAMPLE_FILE_BUFFER_SIZE);
+  const uint8_t *data_bytes = (const uint8_t *) data;
+
+  /* Drop data while there is no open file */
+  if(!error_state_check(ERROR_STATE_SD_SPI_0_SAMPLE_FILE_ERROR))
+  {
+    size_t space = (SEISMOMETER_SAMPLE_FILE_BUFFER_SIZE-current_buffer_length);
+
+    /* Records are dropped whole if the writer has fallen too far behind so the file stays parsable */
+    if((length >= space) && (0 == queue_get_level(&free_buffer_queue)))
+    {
+      bytes_dropped += length;
+    }
+    else
+    {
+      size_t copy_length = SEISMOMETER_MIN(length, space);
+      if(0 == current_buffer_length)
+      {
+        current_buffer_staged_us = time_us_32();
+      }
+      memcpy(&staging_buffer[current_buffer][current_buffer_length], data_bytes, copy_length);
+      current_buffer_length += copy_length;
+
+      if(SEISMOMETER_SAMPLE_FILE_BUFFER_SIZE == current_buffer_length)
+      {
+        SEISMOMETER_ASSERT_CALL(staging_buffer_submit());
+      }
+      if(copy_length < length)
+      {
+        current_buffer_staged_us = time_us_32();
+        memcpy(&staging_buffer[current_buffer][current_buffer_length], &data_bytes[copy_length], (length-copy_length));
+        current_buffer_length += (length-copy_length);
+      }
+    }
+  }
+}
+
+void sample_file_tick()
+{
+  #if (SAMPLE_FILE_TICK_FLUSH_NONE != SEISMOMETER_SAMPLE_FILE_TICK_FLUSH)
+  staging_buffer_submit();
+  #endif
+  sample_file_request(SAMPLE_FILE_REQUEST_TICK);
+}
+
+void sample_file_rollover()
+{
+  staging_buffer_submit();
+  if(!sample_file_request(SAMPLE_FILE_REQUEST_ROLLOVER))
+  {
+    SEISMOMETER_PRINTF(SEISMOMETER_LOG_ERROR, "Sample file writer busy, skipping rollover.\n");
+  }
+}
+
+/* Hands the event staging buffer to the writer, the next event data takes a new free buffer */
+static void event_buffer_submit()
+{
+  if((SAMPLE_FILE_NO_BUFFER != event_buffer) && (event_buffer_length > 0))
+  {
+    sample_file_request_s request =
+    {
+      .type      = SAMPLE_FILE_REQUEST_EVENT_WRITE,
+      .format    = sample_file_format,
+      .buffer    = event_buffer,
+      .length    = event_buffer_length,
+      .staged_us = 0,
+    };
+    /* Request queue has room for every staging buffer so this can not fail */
+    SEISMOMETER_ASSERT_CALL(queue_try_add(&request_queue, &request));
+    bytes_submitted     += event_buffer_length;
+    event_buffer         = SAMPLE_FILE_NO_BUFFER;
+    event_buffer_length  = 0;
+  }
+}
+
+/* Takes a free staging buffer for the event file, leaving SEISMOMETER_SAMPLE_FILE_EVENT_BUFFER_RESERVE for the sample data file */
+static bool event_buffer_take()
+{
+  bool ret_val = false;
+  uint8_t buffer;
+  if((queue_get_level(&free_buffer_queue) > SEISMOMETER_SAMPLE_FILE_EVENT_BUFFER_RESERVE) && queue_try_remove(&free_buffer_queue, &buffer))
+  {
+    event_buffer        = buffer;
+    event_buffer_length = 0;
+    ret_val             = true;
+  }
+  return ret_val;
+}
+
+void sample_file_event_open()
+{
+  /* Data staged for a previous event goes to its own file */
+  event_buffer_submit();
+  if(!sample_file_request(SAMPLE_FILE_REQUEST_EVENT_OPEN))
+  {
+    SEISMOMETER_PRINTF(SEISMOMETER_LOG_ERROR, "Sample file writer busy, not opening event file.\n");
+  }
+}
+
+void sample_file_event_write(const void *data, size_t length)
+{
+  SEISMOMETER_ASSERT(data != nullptr);
+  SEISMOMETER_ASSERT(length <= SEISMOMETER_SAMPLE_FILE_BUFFER_SIZE);
+  const uint8_t *data_bytes = (const uint8_t *) data;
+
+  if((SAMPLE_FILE_NO_BUFFER == event_buffer) && !event_buffer_take())
+  {
+    bytes_dropped += length;
+  }
+  else
+  {
+    /* Records are dropped whole, as for the sample data file */
+    size_t space = (SEISMOMETER_SAMPLE_FILE_BUFFER_SIZE-event_buffer_length);
+    if((length > space) && (queue_get_level(&free_buffer_queue) <= SEISMOMETER_SAMPLE_FILE_EVENT_BUFFER_RESERVE))
+    {
+      bytes_dropped += length;
+    }
+    else
+    {
+      size_t copy_length = SEISMOMETER_MIN(length, space);
+      memcpy(&staging_buffer[event_buffer][event_buffer_length], data_bytes, copy_length);
+      event_buffer_length += copy_length;
+
+      if(SEISMOMETER_SAMPLE_FILE_BUFFER_SIZE == event_buffer_length)
+      {
+        event_buffer_submit();
+        if(copy_length < length)
+        {
+          SEISMOMETER_ASSERT_CALL(event_buffer_take());
+        }
+      }
+      if(copy_length < length)
+      {
+        memcpy(&staging_buffer[event_buffer][event_buffer_length], &data_bytes[copy_length], (length-copy_length));
+        event_buffer_length += (length-copy_length);
+      }
+    }
+  }
+}
+
+void sample_file_event_close()
+{
+  event_buffer_submit();
+  if(!sample_file_request(SAMPLE_FILE_REQUEST_EVENT_CLOSE))
+  {
+    SEISMOMETER_PRINTF(SEISMOMETER_LOG_ERROR, "Sample file writer busy, event file left open until the next event.\n");
+  }
+}
+
+sample_file_format_e sample_file_get_format()
+{
+  return sample_file_format;
+}
+
+void sample_file_set_format(sample_file_format_e format)
+{
+  SEISMOMETER_ASSERT(format < SAMPLE_FILE_FORMAT_MAX);
+
+  if(format != sample_file_format)
+  {
+    /* Data staged in the old format goes to the old file */
+    staging_buffer_submit();
+    if(!sample_file_request(SAMPLE_FILE_REQUEST_CLOSE))
+    {
+      SEISMOMETER_PRINTF(SEISMOMETER_LOG_ERROR, "Sample file writer busy, not changing format.\n");
+    }
+    else
+    {
+      sample_file_format = format;
+    }
+  }
+}
+
+void sample_file_get_stats(sample_file_stats_s *stats)
+{
+  SEISMOMETER_ASSERT(stats != nullptr);
+  /* Read committed bytes first so pending is never underestimated as negative */
+  uint32_t committed = bytes_committed;
+  stats->bytes_pending     = ((bytes_submitted-committed) + current_buffer_length + event_buffer_length);
+  stats->bytes_pending_max = bytes_pending_max;
+  stats->bytes_dropped     = bytes_dropped;
+  stats->requests_dropped  = requests_dropped;
+  stats->stall_us_last     = stall_us_last;
+  stats->stall_us_max      = stall_us_max;
+  stats->stall_count       = stall_count;
+}
+
+/************************************************************************************************************
+ * Sample file writer (core 1)
+ ************************************************************************************************************/
+static void sample_file_close();
+static void event_file_close();
+
+static void sample_file_stall_update(uint32_t start_us)
+{
+  uint32_t duration_us = (time_us_32()-start_us);
+  stall_us_last = duration_us;
+  if(duration_us > stall_us_max)
+  {
+    stall_us_max = duration_us;
+  }
+  if(duration_us >= SEISMOMETER_SAMPLE_FILE_STALL_THRESHOLD_US)
+  {
+    stall_count++;
+  }
+}
+
+/* Writes 'length' bytes to the sample data file */
+static void sample_file_commit(const uint8_t *data, size_t length)
+{
+  if((length > 0) && !error_state_check(ERROR_STATE_SD_SPI_0_SAMPLE_FILE_ERROR))
+  {
+    UINT bytes_written = 0;
+    uint32_t start_us = time_us_32();
+    FRESULT fr = f_write(&sample_data_file, data, length, &bytes_written);
+    sample_file_stall_update(start_us);
+    if((FR_OK != fr) || (length != bytes_written))
+    {
+      SEISMOMETER_PRINTF(SEISMOMETER_LOG_ERROR, "Error (%u) writing sample data file (%u/%u bytes written) - %s.\n", fr, bytes_written, length, FRESULT_str(fr));
+      /* Mark file in error before closing so carried data is discarded instead of flushed */
+      error_state_update(ERROR_STATE_SD_SPI_0_SAMPLE_FILE_ERROR, true);
+      sample_file_close();
+    }
+    else
+    {
+      sample_data_file_offset  += length;
+      sample_data_file_unsynced = true;
+    }
+  }
+}
+
+/* Writes whole sectors of 'data' and carries the remainder over to the next write */
+static void sample_file_write_sectors(const uint8_t *data, size_t length)
+{
+  while(length > 0)
+  {
+    size_t sector_offset = ((sample_data_file_offset + sector_carry_length) % SAMPLE_FILE_SECTOR_SIZE);
+
+    if((sector_carry_length > 0) || (sector_offset != 0))
+    {
+      /* Fill carry buffer up to the next sector boundary */
+      size_t copy_length = SEISMOMETER_MIN(length, (SAMPLE_FILE_SECTOR_SIZE-sector_offset));
+      memcpy(&sector_carry_buffer[sector_carry_length], data, copy_length);
+      sector_carry_length += copy_length;
+      data                += copy_length;
+      length              -= copy_length;
+
+      if(0 == ((sample_data_file_offset + sector_carry_length) % SAMPLE_FILE_SECTOR_SIZE))
+      {
+        sample_file_commit(sector_carry_buffer, sector_carry_length);
+        sector_carry_length = 0;
+      }
+    }
+    else
+    {
+      size_t sector_length = (length & ~((size_t)SAMPLE_FILE_SECTOR_SIZE-1));
+      sample_file_commit(data, sector_length);
+      memcpy(sector_carry_buffer, &data[sector_length], (length-sector_length));
+      sector_carry_length = (length-sector_length);
+      length = 0;
+    }
+  }
+}
+
+static void sample_file_flush_carry()
+{
+  size_t length = sector_carry_length;
+  sector_carry_length = 0;
+  sample_file_commit(sector_carry_buffer, length);
+}
+
+#ifdef ENABLE_ZLIB_DATA_FILE_COMPRESSION
+/* Runs deflate over 'length' bytes of 'data' with 'flush', writing all output produced */
+static void sample_file_deflate(const uint8_t *data, size_t length, int flush)
+{
+  SEISMOMETER_ASSERT(deflate_stream_active);
+
+  deflate_stream.next_in  = (Bytef*) data;
+  deflate_stream.avail_in = length;
+  do
+  {
+    deflate_stream.next_out  = deflate_buffer;
+    deflate_stream.avail_out = sizeof(deflate_buffer);
+
+    int ret = deflate(&deflate_stream, flush);
+    SEISMOMETER_ASSERT(ret != Z_STREAM_ERROR);  /* state not clobbered */
+
+    sample_file_write_sectors(deflate_buffer, (sizeof(deflate_buffer)-deflate_stream.avail_out));
+    /* A write error closes the file and ends the stream */
+  } while(deflate_stream_active && (0 == deflate_stream.avail_out));
+  SEISMOMETER_ASSERT(!deflate_stream_active || (0 == deflate_stream.avail_in));
+}
+#endif
+
+/* Writes 'length' bytes of sample data, deflating it first if compression is enabled */
+static void sample_file_write_data(const uint8_t *data, size_t length)
+{
+  #ifdef ENABLE_ZLIB_DATA_FILE_COMPRESSION
+  if(deflate_stream_active)
+  {
+    sample_file_deflate(data, length, Z_NO_FLUSH);
+  }
+  #else
+  sample_file_write_sectors(data, length);
+  #endif
+}
+
+static void sample_file_sync()
+{
+  #ifdef ENABLE_ZLIB_DATA_FILE_COMPRESSION
+  deflate_flush_ticks++;
+  if(deflate_stream_active && (deflate_flush_ticks >= SEISMOMETER_SAMPLE_FILE_DEFLATE_FLUSH_TICKS))
+  {
+    deflate_flush_ticks = 0;
+    sample_file_deflate(nullptr, 0, Z_SYNC_FLUSH);
+  }
+  #endif
+  #if (SAMPLE_FILE_TICK_FLUSH_ALL == SEISMOMETER_SAMPLE_FILE_TICK_FLUSH)
+  sample_file_flush_carry();
+  #endif
+  if(!error_state_check(ERROR_STATE_SD_SPI_0_SAMPLE_FILE_ERROR) && sample_data_file_unsynced)
+  {
+    uint32_t start_us = time_us_32();
+    FRESULT fr = f_sync(&sample_data_file);
+    sample_file_stall_update(start_us);
+    if(FR_OK == fr)
+    {
+      sample_data_file_unsynced = false;
+    }
+    else
+    {
+      SEISMOMETER_PRINTF(SEISMOMETER_LOG_ERROR, "Error (%u) syncing sample data file - %s.\n", fr, FRESULT_str(fr));
+      sample_file_close();
+    }
+  }
+}
+
+static void sample_file_open(sample_file_format_e format)
+{
+  /*SAMPLE_DATA_FILENAME_LENGTH+1 for NULL character*/
+  seismometer_time_s time_s;
+  absolute_time_t reference_time = rtc_ds3231_get_time(&time_s);
+  SEISMOMETER_ASSERT(format < SAMPLE_FILE_FORMAT_MAX);
+  SEISMOMETER_ASSERT_CALL(SAMPLE_DATA_FILENAME_LENGTH == strftime(sample_file_filename, sizeof(sample_file_filename), sample_file_filename_format[format], &time_s));
+  #ifdef ENABLE_ZLIB_DATA_FILE_COMPRESSION
+  char base_filename[SAMPLE_DATA_FILENAME_LENGTH+1];
+  memcpy(base_filename, sample_file_filename, sizeof(base_filename));
+  SEISMOMETER_ASSERT_CALL(snprintf(sample_file_filename, sizeof(sample_file_filename), COMPRESSED_FILE_FILENAME_FORMAT, base_filename) > COMPRESSED_FILE_FILENAME_EXTENSION_LENGTH);
+  #endif
+
+  error_state_update(ERROR_STATE_SD_SPI_0_SAMPLE_FILE_ERROR, true);
+
+  FRESULT fr = f_open(&sample_data_file, sample_file_filename, FA_OPEN_APPEND | FA_WRITE);
+  if (FR_OK == fr)
+  {
+    sample_data_file_opened = true;
+    error_state_update(ERROR_STATE_SD_SPI_0_SAMPLE_FILE_ERROR, false);
+    SEISMOMETER_PRINTF(SEISMOMETER_LOG_INFO, "Opened sample data file '%s'.\n", sample_file_filename);
+
+    /* Appending, data starts at the current end of file */
+    sample_data_file_offset   = f_size(&sample_data_file);
+    sample_data_file_unsynced = false;
+    sector_carry_length       = 0;
+
+    #ifdef ENABLE_ZLIB_DATA_FILE_COMPRESSION
+    memset(&deflate_stream, 0, sizeof(deflate_stream));
+    deflate_stream.zalloc = Z_NULL;
+    deflate_stream.zfree  = Z_NULL;
+    deflate_stream.opaque = Z_NULL;
+    /* +16 for a gzip wrapper in place of the zlib wrapper */
+    int ret = deflateInit2(&deflate_stream, SEISMOMETER_ZLIB_COMPRESSION_LEVEL, Z_DEFLATED, (SEISMOMETER_ZLIB_DEFLATE_WINDOW_BITS+16), SEISMOMETER_ZLIB_DEFLATE_MEM_LEVEL, Z_DEFAULT_STRATEGY);
+    if(Z_OK != ret)
+    {
+      SEISMOMETER_PRINTF(SEISMOMETER_LOG_ERROR, "Error (%d) initializing deflate stream.\n", ret);
+      sample_file_close();
+      return;
+    }
+    deflate_stream_active = true;
+    deflate_flush_ticks   = 0;
+    #endif
+
+    switch(format)
+    {
+      case SAMPLE_FILE_FORMAT_ASCII:
+      {
+        char buffer[64] = {'\0'};
+        size_t length = strftime(buffer, sizeof(buffer), "\nI|Opened at %FT%T.", &time_s);
+        SEISMOMETER_ASSERT(length > 0);
+        sample_file_write_data((uint8_t*)buffer, length);
+        break;
+      }
+      case SAMPLE_FILE_FORMAT_BINARY:
+      case SAMPLE_FILE_FORMAT_STEIM1:
+      {
+        sample_record_file_header_s header =
+        {
+          .type               = SAMPLE_RECORD_TYPE_FILE_HEADER,
+          .magic              = {0},
+          .version            = SAMPLE_RECORD_VERSION_CURRENT,
+          .header_size        = sizeof(sample_record_file_header_s),
+          .sample_record_size = (uint8_t)((SAMPLE_FILE_FORMAT_STEIM1 == format) ? sizeof(sample_record_steim1_block_s) : sizeof(sample_record_sample_s)),
+          .sample_rate        = (uint16_t) sample_rate_hz(),
+          .open_time          = rtc_ds3231_absolute_time_to_epoch_ms(reference_time),
+        };
+        memcpy(header.magic, SAMPLE_RECORD_MAGIC, SAMPLE_RECORD_MAGIC_LENGTH);
+        sample_file_write_data((uint8_t*)&header, sizeof(header));
+        break;
+      }
+      case SAMPLE_FILE_FORMAT_MINISEED:
+      {
+        /* miniSEED files are only data records */
+        break;
+      }
+      default:
+      {
+        SEISMOMETER_ASSERT(0);
+        break;
+      }
+    }
+  }
+  else
+  {
+    SEISMOMETER_PRINTF(SEISMOMETER_LOG_ERROR, "Error (%u) opening sample data file '%s' - %s.\n", fr, sample_file_filename, FRESULT_str(fr));
+    event_file_close();
+    sd_card_spi_unmount(0);
+  }
+}
+static void sample_file_close()
+{
+  #ifdef ENABLE_ZLIB_DATA_FILE_COMPRESSION
+  if(deflate_stream_active)
+  {
+    /* Finish the gzip member, skipped if the file is in error since nothing more can be written */
+    if(!error_state_check(ERROR_STATE_SD_SPI_0_SAMPLE_FILE_ERROR))
+    {
+      sample_file_deflate(nullptr, 0, Z_FINISH);
+    }
+    deflate_stream_active = false;
+    deflateEnd(&deflate_stream);
+  }
+  #endif
+  /* Flush everything, including a trailing partial sector */
+  sample_file_flush_carry();
+
+  error_state_update(ERROR_STATE_SD_SPI_0_SAMPLE_FILE_ERROR, true);
+
+  if(sample_data_file_opened)
+  {
+    sample_data_file_opened = false;
+    FRESULT fr = f_close(&sample_data_file);
+    if (FR_OK == fr)
+    {
+      puts("Closed sample data file.");
+    }
+    else
+    {
+      SEISMOMETER_PRINTF(SEISMOMETER_LOG_ERROR, "Error (%u) closing sample data file - %s.\n", fr, FRESULT_str(fr));
+    }
+  }
+}
+
+static void event_file_close()
+{
+  if(event_file_opened)
+  {
+    event_file_opened = false;
+    FRESULT fr = f_close(&event_file);
+    if (FR_OK == fr)
+    {
+      SEISMOMETER_PRINTF(SEISMOMETER_LOG_INFO, "Closed event file '%s'.\n", event_file_filename);
+    }
+    else
+    {
+      SEISMOMETER_PRINTF(SEISMOMETER_LOG_ERROR, "Error (%u) closing event file - %s.\n", fr, FRESULT_str(fr));
+    }
+  }
+}
+
+/* Writes 'length' bytes to the event file, the event file is small so is written uncompressed without sector alignment */
+static void event_file_commit(const uint8_t *data, size_t length)
+{
+  if((length > 0) && event_file_opened)
+  {
+    UINT bytes_written = 0;
+    uint32_t start_us = time_us_32();
+    FRESULT fr = f_write(&event_file, data, length, &bytes_written);
+    sample_file_stall_update(start_us);
+    if((FR_OK != fr) || (length != bytes_written))
+    {
+      SEISMOMETER_PRINTF(SEISMOMETER_LOG_ERROR, "Error (%u) writing event file (%u/%u bytes written) - %s.\n", fr, bytes_written, length, FRESULT_str(fr));
+      event_file_close();
+    }
+    else
+    {
+      event_file_unsynced = true;
+    }
+  }
+}
+
+static void event_file_open()
+{
+  event_file_close();
+
+  if(error_state_check(ERROR_STATE_SD_SPI_0_NOT_MOUNTED))
+  {
+    SEISMOMETER_PRINTF(SEISMOMETER_LOG_ERROR, "SD card not mounted, event not saved.\n");
+  }
+  else
+  {
+    seismometer_time_s time_s;
+    absolute_time_t reference_time = rtc_ds3231_get_time(&time_s);
+    SEISMOMETER_ASSERT_CALL(EVENT_FILENAME_LENGTH == strftime(event_file_filename, sizeof(event_file_filename), "event_%FT%H%M%S.bin", &time_s));
+
+    FRESULT fr = f_open(&event_file, event_file_filename, FA_OPEN_APPEND | FA_WRITE);
+    if (FR_OK == fr)
+    {
+      event_file_opened   = true;
+      event_file_unsynced = false;
+      SEISMOMETER_PRINTF(SEISMOMETER_LOG_INFO, "Opened event file '%s'.\n", event_file_filename);
+
+      sample_record_file_header_s header =
+      {
+        .type               = SAMPLE_RECORD_TYPE_FILE_HEADER,
+        .magic              = {0},
+        .version            = SAMPLE_RECORD_VERSION_CURRENT,
+        .header_size        = sizeof(sample_record_file_header_s),
+        .sample_record_size = sizeof(sample_record_sample_s),
+        .sample_rate        = (uint16_t) sample_rate_hz(),
+        .open_time          = rtc_ds3231_absolute_time_to_epoch_ms(reference_time),
+      };
+      memcpy(header.magic, SAMPLE_RECORD_MAGIC, SAMPLE_RECORD_MAGIC_LENGTH);
+      event_file_commit((uint8_t*)&header, sizeof(header));
+    }
+    else
+    {
+      SEISMOMETER_PRINTF(SEISMOMETER_LOG_ERROR, "Error (%u) opening event file '%s' - %s.\n", fr, event_file_filename, FRESULT_str(fr));
+    }
+  }
+}
+
+static void event_file_sync()
+{
+  if(event_file_opened && event_file_unsynced)
+  {
+    uint32_t start_us = time_us_32();
+    FRESULT fr = f_sync(&event_file);
+    sample_file_stall_update(start_us);
+    if(FR_OK == fr)
+    {
+      event_file_unsynced = false;
+    }
+    else
+    {
+      SEISMOMETER_PRINTF(SEISMOMETER_LOG_ERROR, "Error (%u) syncing event file - %s.\n", fr, FRESULT_str(fr));
+      event_file_close();
+    }
+  }
+}
+
+static void sample_file_handle_tick(sample_file_format_e format)
+{
+  if(error_state_check(ERROR_STATE_SD_SPI_0_NOT_MOUNTED))
+  {
+    sd_card_spi_mount(0);
+  }
+  if(!error_state_check(ERROR_STATE_SD_SPI_0_NOT_MOUNTED))
+  {
+    if(error_state_check(ERROR_STATE_SD_SPI_0_SAMPLE_FILE_ERROR))
+    {
+      sample_file_open(format);
+      if(error_state_check(ERROR_STATE_SD_SPI_0_SAMPLE_FILE_ERROR))
+      {
+        sample_file_close();
+        event_file_close();
+        sd_card_spi_unmount(0);
+      }
+    }
+    else
+    {
+      sample_file_sync();
+    }
+    event_file_sync();
+  }
+}
+
+void sample_file_writer_main()
+{
+  SEISMOMETER_PRINTF(SEISMOMETER_LOG_INFO, "Starting sample file writer.\n");
+
+  while(1)
+  {
+    sample_file_request_s request;
+    queue_remove_blocking(&request_queue, &request);
+
+    switch(request.type)
+    {
+      case SAMPLE_FILE_REQUEST_WRITE:
+      {
+        SEISMOMETER_ASSERT(request.buffer < SEISMOMETER_SAMPLE_FILE_BUFFER_COUNT);
+        SEISMOMETER_ASSERT(request.length <= SEISMOMETER_SAMPLE_FILE_BUFFER_SIZE);
+
+        uint32_t bytes_pending = (bytes_submitted-bytes_committed);
+        if(bytes_pending > bytes_pending_max)
+        {
+          bytes_pending_max = bytes_pending;
+        }
+
+        if(!error_state_check(ERROR_STATE_SD_SPI_0_SAMPLE_FILE_ERROR))
+        {
+          sample_file_write_data(staging_buffer[request.buffer], request.length);
+          pipeline_latency_record(PIPELINE_LATENCY_SD_COMMIT, (time_us_32()-request.staged_us));
+        }
+        bytes_committed += request.length;
+        SEISMOMETER_ASSERT_CALL(queue_try_add(&free_buffer_queue, &request.buffer));
+        break;
+      }
+      case SAMPLE_FILE_REQUEST_TICK:
+      {
+        sample_file_handle_tick(request.format);
+        break;
+      }
+      case SAMPLE_FILE_REQUEST_CLOSE:
+      {
+        if(!error_state_check(ERROR_STATE_SD_SPI_0_SAMPLE_FILE_ERROR))
+        {
+          sample_file_close();
+        }
+        break;
+      }
+      case SAMPLE_FILE_REQUEST_ROLLOVER:
+      {
+        /* Close current file and reopen with new date-stamp */
+        sample_file_close();
+        sample_file_open(request.format);
+        break;
+      }
+      case SAMPLE_FILE_REQUEST_EVENT_OPEN:
+      {
+        event_file_open();
+        break;
+      }
+      case SAMPLE_FILE_REQUEST_EVENT_WRITE:
+      {
+        SEISMOMETER_ASSERT(request.buffer < SEISMOMETER_SAMPLE_FILE_BUFFER_COUNT);
+        SEISMOMETER_ASSERT(request.length <= SEISMOMETER_SAMPLE_FILE_BUFFER_SIZE);
+
+        event_file_commit(staging_buffer[request.buffer], request.length);
+        bytes_committed += request.length;
+        SEISMOMETER_ASSERT_CALL(queue_try_add(&free_buffer_queue, &request.buffer));
+        break;
+      }
+      case SAMPLE_FILE_REQUEST_EVENT_CLOSE:
+      {
+        event_file_close();
+        break;
+      }
+      default:
+      {
+        SEISMOMETER_PRINTF(SEISMOMETER_LOG_ERROR, "Unexpected sample file request %u\n", request.type);
+        SEISMOMETER_ASSERT(0);
+        break;
+      }
+    }
+  }
+}
\ No newline at end of file
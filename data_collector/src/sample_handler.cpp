@@ -2,112 +2,417 @@
 #include <cmath>
 #include <cstdio>
 #include <cstring>
+#include <new>
 
-#include <f_util.h>
-#include <ff.h>
 #include <hardware/gpio.h>
 #include <pico/time.h>
 #include <pico/stdio.h>
 
+#include "adc_manager.hpp"
+#include "biquad_filter.hpp"
+#include "clock_discipline.hpp"
+#include "event_capture.hpp"
+#include "fft_q15.hpp"
 #include "filter_coefficients.hpp"
-#include "fir_filter.hpp"
+#include "fir_filter_bank.hpp"
+#include "fir_polyphase.hpp"
+#include "goertzel_bank.hpp"
+#include "median_filter.hpp"
+#include "miniseed.hpp"
+#include "mpu-6500.hpp"
+#include "pipeline_latency.hpp"
 #include "rtc_ds3231.hpp"
+#include "sample_file.hpp"
 #include "sample_handler.hpp"
-#include "sd_card_spi.hpp"
+#include "sample_rate.hpp"
+#include "sample_record.hpp"
+#include "sampler.hpp"
+#include "seismometer_config.hpp"
 #include "seismometer_debug.hpp"
 #include "seismometer_eeprom.hpp"
+#include "seismometer_i2c.hpp"
 #include "seismometer_utils.hpp"
+#include "spectrum.hpp"
+#include "steim1_encoder.hpp"
 
-/* Length of sample data filename not including null character i.e. 'seismometer_2023-03-06.dat\0' */
-#define SAMPLE_DATA_FILENAME_LENGTH 29
-FIL sample_data_file;
-bool sample_data_file_previously_opened = false;
-char sample_file_filename[SAMPLE_DATA_FILENAME_LENGTH+1]  = {'\0'};
-void sample_file_open()
+sample_log_key_mask_t sample_key_mask_stdio = 0x00;
+sample_log_key_mask_t sample_key_mask_sd    = ((1<<SAMPLE_LOG_MAX_KEY)-1);
+
+/* SEED location and channel codes of each key for SAMPLE_FILE_FORMAT_MINISEED at 100Hz.  Band code 'H' (100Hz),
+   instrument 'N' accelerometer, 'H' pendulum seismometer, 'K' temperature.  Raw data is location 00, filtered data 01,
+   the 10x pendulum gain is location 10.  Decimated pendulum channels use band codes 'B' (20Hz, 10Hz at location 02)
+   and 'L' (1Hz) */
+static const miniseed_nslc_s miniseed_nslc_100hz[SAMPLE_LOG_MAX_KEY] =
+{
+  {SEISMOMETER_MINISEED_NETWORK, SEISMOMETER_MINISEED_STATION, "",   ""   }, /* SAMPLE_LOG_INVALID           */
+  {SEISMOMETER_MINISEED_NETWORK, SEISMOMETER_MINISEED_STATION, "00", "HN1"}, /* SAMPLE_LOG_ACCEL_X           */
+  {SEISMOMETER_MINISEED_NETWORK, SEISMOMETER_MINISEED_STATION, "00", "HN2"}, /* SAMPLE_LOG_ACCEL_Y           */
+  {SEISMOMETER_MINISEED_NETWORK, SEISMOMETER_MINISEED_STATION, "00", "HNZ"}, /* SAMPLE_LOG_ACCEL_Z           */
+  {SEISMOMETER_MINISEED_NETWORK, SEISMOMETER_MINISEED_STATION, "00", "HNM"}, /* SAMPLE_LOG_ACCEL_M           */
+  {SEISMOMETER_MINISEED_NETWORK, SEISMOMETER_MINISEED_STATION, "01", "HN1"}, /* SAMPLE_LOG_ACCEL_X_FILTERED  */
+  {SEISMOMETER_MINISEED_NETWORK, SEISMOMETER_MINISEED_STATION, "01", "HN2"}, /* SAMPLE_LOG_ACCEL_Y_FILTERED  */
+  {SEISMOMETER_MINISEED_NETWORK, SEISMOMETER_MINISEED_STATION, "01", "HNZ"}, /* SAMPLE_LOG_ACCEL_Z_FILTERED  */
+  {SEISMOMETER_MINISEED_NETWORK, SEISMOMETER_MINISEED_STATION, "01", "HNM"}, /* SAMPLE_LOG_ACCEL_M_FILTERED  */
+  {SEISMOMETER_MINISEED_NETWORK, SEISMOMETER_MINISEED_STATION, "00", "HKO"}, /* SAMPLE_LOG_ACCEL_TEMP        */
+  {SEISMOMETER_MINISEED_NETWORK, SEISMOMETER_MINISEED_STATION, "10", "HHZ"}, /* SAMPLE_LOG_PENDULUM_10X      */
+  {SEISMOMETER_MINISEED_NETWORK, SEISMOMETER_MINISEED_STATION, "00", "HHZ"}, /* SAMPLE_LOG_PENDULUM_100X     */
+  {SEISMOMETER_MINISEED_NETWORK, SEISMOMETER_MINISEED_STATION, "01", "HHZ"}, /* SAMPLE_LOG_PENDULUM_FILTERED */
+  {SEISMOMETER_MINISEED_NETWORK, SEISMOMETER_MINISEED_STATION, "01", "BHZ"}, /* SAMPLE_LOG_PENDULUM_20HZ     */
+  {SEISMOMETER_MINISEED_NETWORK, SEISMOMETER_MINISEED_STATION, "02", "BHZ"}, /* SAMPLE_LOG_PENDULUM_10HZ     */
+  {SEISMOMETER_MINISEED_NETWORK, SEISMOMETER_MINISEED_STATION, "01", "LHZ"}, /* SAMPLE_LOG_PENDULUM_1HZ      */
+};
+/* Sample rate of 'key' in Hz, the decimated pendulum channels keep their rates at every primary sample rate */
+static uint16_t sample_log_key_rate(sample_log_key_e key)
+{
+  uint16_t ret_val = (uint16_t)sample_rate_hz();
+  switch(key)
+  {
+    case SAMPLE_LOG_INVALID:
+    {
+      ret_val = 0;
+      break;
+    }
+    case SAMPLE_LOG_PENDULUM_20HZ:
+    {
+      ret_val = 20;
+      break;
+    }
+    case SAMPLE_LOG_PENDULUM_10HZ:
+    {
+      ret_val = 10;
+      break;
+    }
+    case SAMPLE_LOG_PENDULUM_1HZ:
+    {
+      ret_val = 1;
+      break;
+    }
+    default:
+    {
+      break;
+    }
+  }
+  return ret_val;
+}
+
+/* miniseed_nslc_100hz with the SEED band code of the primary sample rate on the keys at that rate, set at init */
+static miniseed_nslc_s miniseed_nslc[SAMPLE_LOG_MAX_KEY];
+static char            miniseed_channel[SAMPLE_LOG_MAX_KEY][4];
+
+/* Band code 'B' below 80Hz, 'H' below 250Hz and 'C' above.  At 'B' the 20Hz pendulum channel moves to location 03 as
+   it would share the codes of the filtered pendulum channel */
+static void miniseed_nslc_init()
+{
+  const uint32_t rate_hz   = sample_rate_hz();
+  const char     band_code = (rate_hz < 80) ? 'B' : ((rate_hz < 250) ? 'H' : 'C');
+  for(unsigned int key = 0; key < SAMPLE_LOG_MAX_KEY; key++)
+  {
+    miniseed_nslc[key] = miniseed_nslc_100hz[key];
+    if((SAMPLE_LOG_INVALID != key) && (sample_log_key_rate((sample_log_key_e)key) == rate_hz))
+    {
+      strncpy(miniseed_channel[key], miniseed_nslc_100hz[key].channel, (sizeof(miniseed_channel[key])-1));
+      miniseed_channel[key][0]   = band_code;
+      miniseed_nslc[key].channel = miniseed_channel[key];
+    }
+  }
+  if('B' == band_code)
+  {
+    miniseed_nslc[SAMPLE_LOG_PENDULUM_20HZ].location = "03";
+  }
+}
+static uint32_t miniseed_sequence_number = 1;
+static uint8_t  miniseed_record_buffer[MINISEED_RECORD_SIZE];
+static_assert(STEIM1_BLOCK_FRAMES_DEFAULT == MINISEED_RECORD_FRAMES, "Steim1 blocks must fill a miniSEED record");
+
+/* SAMPLE_FILE_FORMAT_STEIM1 and SAMPLE_FILE_FORMAT_MINISEED encoder state per key.  A block holds consecutive sample indices, a gap in the indices
+   completes the block */
+typedef struct
 {
-  /*SAMPLE_DATA_FILENAME_LENGTH+1 for NULL character*/
-  seismometer_time_s time_s;
-  rtc_ds3231_get_time(&time_s);
-  SEISMOMETER_ASSERT_CALL(SAMPLE_DATA_FILENAME_LENGTH == strftime(sample_file_filename, sizeof(sample_file_filename), "seismometer_%FT%H.dat", &time_s));
+  bool           active;                /* Samples pushed since the last flush */
+  sample_index_t block_index;           /* Index of the first sample of the current block */
+  sample_index_t next_index;            /* Index expected for the next sample */
+} steim1_key_state_s;
+static steim1_encoder_c   steim1_encoders [SAMPLE_LOG_MAX_KEY];
+static steim1_key_state_s steim1_key_state[SAMPLE_LOG_MAX_KEY] = {0};
+static uint8_t            steim1_record_buffer[sizeof(sample_record_steim1_block_s)+(STEIM1_BLOCK_FRAMES_DEFAULT*STEIM1_FRAME_SIZE)];
+
+/* Writes the completed block of 'key' as a single miniSEED record */
+static void miniseed_write_block(sample_log_key_e key)
+{
+  miniseed_build_record(miniseed_record_buffer, &miniseed_nslc[key], miniseed_sequence_number,
+                        steim1_encoders[key].get_block_time(), sample_log_key_rate(key), &steim1_encoders[key]);
+  sample_file_write(miniseed_record_buffer, sizeof(miniseed_record_buffer));
+
+  miniseed_sequence_number = (miniseed_sequence_number < MINISEED_SEQUENCE_NUMBER_MAX) ? (miniseed_sequence_number+1) : 1;
+}
 
-  error_state_update(ERROR_STATE_SD_SPI_0_SAMPLE_FILE_ERROR, true);
+/* Writes the completed block of 'key' as a single record so the sample file drops or keeps it whole */
+static void steim1_record_write_block(sample_log_key_e key)
+{
+  const steim1_encoder_c *encoder = &steim1_encoders[key];
+  const size_t frames_size = (encoder->get_block_frame_count()*STEIM1_FRAME_SIZE);
+  SEISMOMETER_ASSERT((sizeof(sample_record_steim1_block_s)+frames_size) <= sizeof(steim1_record_buffer));
 
-  FRESULT fr = f_open(&sample_data_file, sample_file_filename, FA_OPEN_APPEND | FA_WRITE);
-  sample_data_file_previously_opened = true;
-  if (FR_OK == fr)
+  const sample_record_steim1_block_s record =
   {
-    error_state_update(ERROR_STATE_SD_SPI_0_SAMPLE_FILE_ERROR, false);
-    SEISMOMETER_PRINTF(SEISMOMETER_LOG_INFO, "Opened sample data file '%s'.\n", sample_file_filename);
+    .type         = SAMPLE_RECORD_TYPE_STEIM1_BLOCK,
+    .key          = (uint8_t)key,
+    .frame_count  = (uint8_t)encoder->get_block_frame_count(),
+    .sample_rate  = sample_log_key_rate(key),
+    .sample_count = encoder->get_block_sample_count(),
+    .index        = (uint32_t)steim1_key_state[key].block_index,
+    .timestamp    = encoder->get_block_time(),
+  };
+  memcpy(steim1_record_buffer, &record, sizeof(record));
+  memcpy(&steim1_record_buffer[sizeof(record)], encoder->get_block(), frames_size);
+  sample_file_write(steim1_record_buffer, (sizeof(record)+frames_size));
+}
 
-    char buffer[64] = {'\0'};
-    SEISMOMETER_ASSERT_CALL( sizeof(buffer) > strftime(buffer, sizeof(buffer), "I|Opened at %FT%T.", &time_s));
-    
-    if(f_putc('\n', &sample_data_file) < 0)
+static void steim1_write_block(sample_log_key_e key)
+{
+  switch(sample_file_get_format())
+  {
+    case SAMPLE_FILE_FORMAT_STEIM1:
     {
-      error_state_update(ERROR_STATE_SD_SPI_0_SAMPLE_FILE_ERROR, true);
+      steim1_record_write_block(key);
+      break;
     }
-    if(!error_state_check(ERROR_STATE_SD_SPI_0_SAMPLE_FILE_ERROR))
+    case SAMPLE_FILE_FORMAT_MINISEED:
     {
-      if(f_puts(buffer, &sample_data_file) < 0)
-      {
-        error_state_update(ERROR_STATE_SD_SPI_0_SAMPLE_FILE_ERROR, true);
-      }
+      miniseed_write_block(key);
+      break;
+    }
+    default:
+    {
+      SEISMOMETER_ASSERT(0);
+      break;
     }
   }
-  else
+
+  steim1_key_state[key].block_index += steim1_encoders[key].get_block_sample_count();
+}
+
+static void steim1_flush(sample_log_key_e key)
+{
+  if(steim1_key_state[key].active)
   {
-    SEISMOMETER_PRINTF(SEISMOMETER_LOG_ERROR, "Error (%u) opening sample data file '%s' - %s.\n", fr, sample_file_filename, FRESULT_str(fr));
-    sd_card_spi_unmount(0);
+    while(steim1_encoders[key].flush())
+    {
+      steim1_write_block(key);
+    }
+    steim1_encoders[key].reset();
+    steim1_key_state[key].active = false;
   }
 }
-void sample_file_close()
+
+/* Completes all partial Steim1 blocks, must be called before the sample file is closed or changes format */
+static void steim1_flush_all()
 {
-  error_state_update(ERROR_STATE_SD_SPI_0_SAMPLE_FILE_ERROR, true);
+  for(unsigned int key = 0; key < SAMPLE_LOG_MAX_KEY; key++)
+  {
+    steim1_flush((sample_log_key_e)key);
+  }
+}
 
-  if(sample_data_file_previously_opened)
+static inline void steim1_log_sample(sample_log_key_e key, sample_index_t index, uint64_t timestamp, int32_t data)
+{
+  steim1_key_state_s *state = &steim1_key_state[key];
+  if(state->active && (index != state->next_index))
+  {
+    steim1_flush(key);
+  }
+  if(!state->active)
+  {
+    state->active      = true;
+    state->block_index = index;
+  }
+  state->next_index = (index+1);
+
+  if(steim1_encoders[key].push_sample(data, timestamp))
+  {
+    steim1_write_block(key);
+  }
+}
+/* Sample frames group the samples of every key taken at one index and time into a single 'F' line or
+   SAMPLE_RECORD_TYPE_FRAME record.  Samples logged between sample_frame_begin() and sample_frame_end() are added to the
+   frame instead of being logged individually */
+typedef struct
+{
+  bool                  open;
+  sample_index_t        index;
+  uint64_t              timestamp;
+  sample_log_key_mask_t key_mask_stdio;
+  sample_log_key_mask_t key_mask_sd;
+  int32_t               data[SAMPLE_LOG_MAX_KEY];
+} sample_frame_s;
+static bool           sample_frames_enabled = SEISMOMETER_SAMPLE_FRAMES_DEFAULT;
+static sample_frame_s sample_frame          = {0};
+
+/* "\nF|<key mask>|<index>|<timestamp>" then "|<data>" per key */
+#define SAMPLE_FRAME_ASCII_LENGTH_MAX (1+2+4+1+8+1+16+(SAMPLE_LOG_MAX_KEY*(1+8)))
+static char    sample_frame_ascii_buffer [SAMPLE_FRAME_ASCII_LENGTH_MAX+1];
+static uint8_t sample_frame_binary_buffer[sizeof(sample_record_frame_s)+(SAMPLE_LOG_MAX_KEY*sizeof(int32_t))];
+
+/* Formats the frame keys in 'key_mask' with a leading newline, returns the length */
+static size_t sample_frame_format_ascii(sample_log_key_mask_t key_mask)
+{
+  int length = snprintf(sample_frame_ascii_buffer, sizeof(sample_frame_ascii_buffer), "\nF|%04X|%08X|%016llX", (uint16_t)key_mask, (uint32_t)sample_frame.index, sample_frame.timestamp);
+  for(unsigned int key = 0; key < SAMPLE_LOG_MAX_KEY; key++)
   {
-    FRESULT fr = f_close(&sample_data_file);
-    if (FR_OK == fr)
+    if(0 != ((1<<key) & key_mask))
     {
-      puts("Closed sample data file.");
+      length += snprintf(&sample_frame_ascii_buffer[length], (sizeof(sample_frame_ascii_buffer)-length), "|%X", (uint32_t)sample_frame.data[key]);
     }
-    else
+  }
+  SEISMOMETER_ASSERT((length > 0) && (length < (int)sizeof(sample_frame_ascii_buffer)));
+  return length;
+}
+
+static size_t sample_frame_format_binary(sample_log_key_mask_t key_mask)
+{
+  const sample_record_frame_s record =
+  {
+    .type      = SAMPLE_RECORD_TYPE_FRAME,
+    .key_mask  = (uint16_t)key_mask,
+    .index     = (uint32_t)sample_frame.index,
+    .timestamp = sample_frame.timestamp,
+  };
+  memcpy(sample_frame_binary_buffer, &record, sizeof(record));
+  size_t length = sizeof(record);
+  for(unsigned int key = 0; key < SAMPLE_LOG_MAX_KEY; key++)
+  {
+    if(0 != ((1<<key) & key_mask))
     {
-      SEISMOMETER_PRINTF(SEISMOMETER_LOG_ERROR, "Error (%u) closing sample data file - %s.\n", fr, FRESULT_str(fr));
+      memcpy(&sample_frame_binary_buffer[length], &sample_frame.data[key], sizeof(int32_t));
+      length += sizeof(int32_t);
+    }
+  }
+  return length;
+}
+
+static inline void sample_frame_begin(sample_index_t index, uint64_t timestamp)
+{
+  SEISMOMETER_ASSERT(!sample_frame.open);
+  if(sample_frames_enabled)
+  {
+    sample_frame.open           = true;
+    sample_frame.index          = index;
+    sample_frame.timestamp      = timestamp;
+    sample_frame.key_mask_stdio = 0;
+    sample_frame.key_mask_sd    = 0;
+  }
+}
+
+static inline void sample_frame_end()
+{
+  if(sample_frame.open)
+  {
+    sample_frame.open = false;
+
+    if(0 != sample_frame.key_mask_stdio)
+    {
+      sample_frame_format_ascii(sample_frame.key_mask_stdio);
+      /* Skip leading newline */
+      printf("%s\n", &sample_frame_ascii_buffer[1]);
+    }
+
+    if(0 != sample_frame.key_mask_sd)
+    {
+      switch(sample_file_get_format())
+      {
+        case SAMPLE_FILE_FORMAT_ASCII:
+        {
+          size_t length = sample_frame_format_ascii(sample_frame.key_mask_sd);
+          sample_file_write(sample_frame_ascii_buffer, length);
+          break;
+        }
+        case SAMPLE_FILE_FORMAT_BINARY:
+        {
+          size_t length = sample_frame_format_binary(sample_frame.key_mask_sd);
+          sample_file_write(sample_frame_binary_buffer, length);
+          break;
+        }
+        default:
+        {
+          SEISMOMETER_ASSERT(0);
+          break;
+        }
+      }
     }
   }
 }
 
-sample_log_key_mask_t sample_key_mask_stdio = 0x00;
-sample_log_key_mask_t sample_key_mask_sd    = ((1<<SAMPLE_LOG_MAX_KEY)-1);
 static inline void log_sample(sample_log_key_e key, sample_index_t index, uint64_t timestamp, int64_t data)
 {
   SEISMOMETER_ASSERT(key < SAMPLE_LOG_MAX_KEY);
-  if(0 != ((1<<key) & (sample_key_mask_stdio | sample_key_mask_sd)))
+  if(sample_frame.open)
   {
-    char buffer[48];
-    snprintf(buffer, sizeof(buffer), "S|%02X|%08X|%016llX|%016llX", (uint8_t)key, (uint32_t)index, timestamp, data);
+    SEISMOMETER_ASSERT((index == sample_frame.index) && (timestamp == sample_frame.timestamp));
+    sample_frame.data[key] = (int32_t)data;
+  }
 
-    if(0 != ((1<<key) & sample_key_mask_stdio))
+  if(0 != ((1<<key) & sample_key_mask_stdio))
+  {
+    if(sample_frame.open)
     {
-      puts(buffer);
+      sample_frame.key_mask_stdio |= (1<<key);
     }
+    else
+    {
+      printf("S|%02X|%08X|%016llX|%016llX\n", (uint8_t)key, (uint32_t)index, timestamp, data);
+    }
+  }
 
-    if(0 != ((1<<key) & sample_key_mask_sd))
+  if(0 != ((1<<key) & sample_key_mask_sd))
+  {
+    switch(sample_file_get_format())
     {
-      if(!error_state_check(ERROR_STATE_SD_SPI_0_SAMPLE_FILE_ERROR))
+      case SAMPLE_FILE_FORMAT_ASCII:
       {
-        if(f_putc('\n', &sample_data_file) < 0)
+        if(sample_frame.open)
+        {
+          sample_frame.key_mask_sd |= (1<<key);
+        }
+        else
         {
-          sample_file_close();
+          char buffer[49];
+          int length = snprintf(buffer, sizeof(buffer), "\nS|%02X|%08X|%016llX|%016llX", (uint8_t)key, (uint32_t)index, timestamp, data);
+          SEISMOMETER_ASSERT((length > 0) && (length < (int)sizeof(buffer)));
+          sample_file_write(buffer, length);
         }
+        break;
       }
-      if(!error_state_check(ERROR_STATE_SD_SPI_0_SAMPLE_FILE_ERROR))
+      case SAMPLE_FILE_FORMAT_BINARY:
       {
-        if(f_puts(buffer, &sample_data_file) < 0)
+        if(sample_frame.open)
         {
-          sample_file_close();
+          sample_frame.key_mask_sd |= (1<<key);
         }
+        else
+        {
+          const sample_record_sample_s record =
+          {
+            .type      = SAMPLE_RECORD_TYPE_SAMPLE,
+            .key       = (uint8_t)key,
+            .index     = (uint32_t)index,
+            .timestamp = timestamp,
+            .data      = (int32_t)data,
+          };
+          sample_file_write(&record, sizeof(record));
+        }
+        break;
+      }
+      case SAMPLE_FILE_FORMAT_STEIM1:
+      case SAMPLE_FILE_FORMAT_MINISEED:
+      {
+        /* Per key formats, frames do not apply */
+        steim1_log_sample(key, index, timestamp, (int32_t)data);
+        break;
+      }
+      default:
+      {
+        SEISMOMETER_ASSERT(0);
+        break;
       }
     }
   }
@@ -133,42 +438,547 @@ void set_sample_handler_epoch(absolute_time_t time)
   return (((uint64_t)sample_count*1000*1000)/delta);
 }
 
-static const fir_filter_config_s acceleration_fir_filter_config
+/* Welch PSD spectra of the raw acceleration and 100x pendulum channels, see spectrum.hpp.  Segments are collected as
+   samples are handled and transformed after each batch by spectrum_process_all(), only for keys in a spectrum mask */
+typedef enum
+{
+  SPECTRUM_ACCEL_X,
+  SPECTRUM_ACCEL_Y,
+  SPECTRUM_ACCEL_Z,
+  SPECTRUM_PENDULUM_100X,
+  SPECTRUM_MAX,
+} spectrum_e;
+static const sample_log_key_e spectrum_key[SPECTRUM_MAX] =
 {
-  .moving_average_order = 512,
-  .gain_numerator   = FIR_HAMMING_LPF_100HZ_FS_10HZ_CUTOFF_GAIN_NUM,
-  .gain_denominator = FIR_HAMMING_LPF_100HZ_FS_10HZ_CUTOFF_GAIN_DEN,
+  SAMPLE_LOG_ACCEL_X,       /* SPECTRUM_ACCEL_X       */
+  SAMPLE_LOG_ACCEL_Y,       /* SPECTRUM_ACCEL_Y       */
+  SAMPLE_LOG_ACCEL_Z,       /* SPECTRUM_ACCEL_Z       */
+  SAMPLE_LOG_PENDULUM_100X, /* SPECTRUM_PENDULUM_100X */
 };
+#define SPECTRUM_KEY_MASK ((1<<SAMPLE_LOG_ACCEL_X) | (1<<SAMPLE_LOG_ACCEL_Y) | (1<<SAMPLE_LOG_ACCEL_Z) | (1<<SAMPLE_LOG_PENDULUM_100X))
+sample_log_key_mask_t spectrum_key_mask_stdio = 0x00;
+sample_log_key_mask_t spectrum_key_mask_sd    = SPECTRUM_KEY_MASK;
+static bool           spectrum_bands_enabled  = SEISMOMETER_SPECTRUM_BANDS_DEFAULT;
+
+static fft_q15_c  spectrum_fft(SEISMOMETER_SPECTRUM_FFT_LENGTH);
+/* Created for the sample rate at init */
+static spectrum_c *spectrum[SPECTRUM_MAX] = {nullptr};
+/* Timestamp of the last sample pushed to each spectrum */
+static uint64_t   spectrum_timestamp[SPECTRUM_MAX] = {0};
+
+/* Lower edges of the octave bands logged with SPECTRUMBANDS1, the last band ends at the Nyquist frequency */
+static const float spectrum_band_edge_hz[] = {0.5f, 1.0f, 2.0f, 4.0f, 8.0f, 16.0f, 32.0f, 64.0f, 128.0f};
+#define SPECTRUM_BAND_COUNT_MAX ((SEISMOMETER_SPECTRUM_FFT_LENGTH/2)+1)
 
-static fir_filter_c acceleration_filter_x(FIR_HAMMING_LPF_100HZ_FS_10HZ_CUTOFF_ORDER, fir_hamming_lpf_100hz_fs_10hz_cutoff, &acceleration_fir_filter_config);
-static fir_filter_c acceleration_filter_y(FIR_HAMMING_LPF_100HZ_FS_10HZ_CUTOFF_ORDER, fir_hamming_lpf_100hz_fs_10hz_cutoff, &acceleration_fir_filter_config);
-static fir_filter_c acceleration_filter_z(FIR_HAMMING_LPF_100HZ_FS_10HZ_CUTOFF_ORDER, fir_hamming_lpf_100hz_fs_10hz_cutoff, &acceleration_fir_filter_config);
-static fir_filter_c acceleration_filter_m(FIR_HAMMING_LPF_100HZ_FS_10HZ_CUTOFF_ORDER, fir_hamming_lpf_100hz_fs_10hz_cutoff, &acceleration_fir_filter_config);
+/* "\nP|<key>|<timestamp>|<segment count>|<fft length>" then "|<first bin>:<psd cdB>" per band */
+#define SPECTRUM_ASCII_LENGTH_MAX (1+2+2+1+16+1+4+1+4+(SPECTRUM_BAND_COUNT_MAX*(1+4+1+6)))
+static char    spectrum_ascii_buffer [SPECTRUM_ASCII_LENGTH_MAX+1];
+static uint8_t spectrum_binary_buffer[sizeof(sample_record_spectrum_s)+(SPECTRUM_BAND_COUNT_MAX*sizeof(sample_record_spectrum_band_s))];
+static_assert(sizeof(spectrum_ascii_buffer) <= SEISMOMETER_SAMPLE_FILE_BUFFER_SIZE, "Spectrum records must fit a sample file buffer");
 
-static void acceleration_sample_handler(const seismometer_sample_s *sample)
+static inline bool spectrum_enabled(spectrum_e channel)
 {
-  SEISMOMETER_ASSERT(sample != nullptr);
-  SEISMOMETER_ASSERT(SEISMOMETER_SAMPLE_TYPE_ACCELERATION == sample->type);
+  return (0 != ((1<<spectrum_key[channel]) & (spectrum_key_mask_sd | spectrum_key_mask_stdio)));
+}
 
-  static absolute_time_t last_sample_time = {0};
-  mm_ps2_t acceleration_magnitude = sqrt( (sample->acceleration.x*sample->acceleration.x) + 
-                                          (sample->acceleration.y*sample->acceleration.y) + 
-                                          (sample->acceleration.z*sample->acceleration.z) );
+static inline void spectrum_push(spectrum_e channel, int32_t sample, uint64_t timestamp)
+{
+  if(spectrum_enabled(channel))
+  {
+    spectrum[channel]->push_sample(sample);
+    spectrum_timestamp[channel] = timestamp;
+  }
+}
+
+/* Power (or PSD) in centi-dB relative to 1 (sample unit)^2, saturated to int16_t */
+static int16_t power_to_cdb(float power)
+{
+  int16_t ret_val = INT16_MIN;
+  if(power > 0)
+  {
+    ret_val = (int16_t)SEISMOMETER_MAX(SEISMOMETER_MIN(lroundf(1000*log10f(power)), INT16_MAX), INT16_MIN);
+  }
+  return ret_val;
+}
+
+/* Fills 'band' with the octave bands (or every bin) of the last spectrum of 'channel', returns the band count */
+static size_t spectrum_get_bands(spectrum_e channel, sample_record_spectrum_band_s *band)
+{
+  const spectrum_c *s = spectrum[channel];
+  const size_t bin_count = s->get_bin_count();
+  size_t band_count = 0;
+  if(spectrum_bands_enabled)
+  {
+    for(size_t i = 0; i < (sizeof(spectrum_band_edge_hz)/sizeof(spectrum_band_edge_hz[0])); i++)
+    {
+      const size_t first_bin = lroundf((spectrum_band_edge_hz[i]*SEISMOMETER_SPECTRUM_FFT_LENGTH)/sample_rate_hz());
+      if((first_bin < bin_count) && ((0 == band_count) || (first_bin > band[band_count-1].first_bin)))
+      {
+        band[band_count++].first_bin = (uint16_t)first_bin;
+      }
+    }
+  }
+  else
+  {
+    for(size_t bin = 0; bin < bin_count; bin++)
+    {
+      band[band_count++].first_bin = (uint16_t)bin;
+    }
+  }
+
+  for(size_t i = 0; i < band_count; i++)
+  {
+    const size_t end_bin = (((i+1) < band_count) ? band[i+1].first_bin : bin_count);
+    band[i].psd_cdb = power_to_cdb(s->get_band_psd(band[i].first_bin, end_bin));
+  }
+  return band_count;
+}
+
+/* Formats the spectrum record with a leading newline, returns the length */
+static size_t spectrum_format_ascii(sample_log_key_e key, uint64_t timestamp, const sample_record_spectrum_band_s *band, size_t band_count)
+{
+  int length = snprintf(spectrum_ascii_buffer, sizeof(spectrum_ascii_buffer), "\nP|%02X|%016llX|%04X|%04X", (uint8_t)key, timestamp,
+                        (uint16_t)SEISMOMETER_SPECTRUM_SEGMENTS, (uint16_t)SEISMOMETER_SPECTRUM_FFT_LENGTH);
+  for(size_t i = 0; i < band_count; i++)
+  {
+    length += snprintf(&spectrum_ascii_buffer[length], (sizeof(spectrum_ascii_buffer)-length), "|%X:%d", band[i].first_bin, band[i].psd_cdb);
+  }
+  SEISMOMETER_ASSERT((length > 0) && (length < (int)sizeof(spectrum_ascii_buffer)));
+  return length;
+}
+
+static size_t spectrum_format_binary(sample_log_key_e key, uint64_t timestamp, const sample_record_spectrum_band_s *band, size_t band_count)
+{
+  const sample_record_spectrum_s record =
+  {
+    .type          = SAMPLE_RECORD_TYPE_SPECTRUM,
+    .key           = (uint8_t)key,
+    .band_count    = (uint16_t)band_count,
+    .segment_count = (uint16_t)SEISMOMETER_SPECTRUM_SEGMENTS,
+    .fft_length    = (uint16_t)SEISMOMETER_SPECTRUM_FFT_LENGTH,
+    .timestamp     = timestamp,
+  };
+  memcpy(spectrum_binary_buffer, &record, sizeof(record));
+  memcpy(&spectrum_binary_buffer[sizeof(record)], band, band_count*sizeof(sample_record_spectrum_band_s));
+  return (sizeof(record)+(band_count*sizeof(sample_record_spectrum_band_s)));
+}
+
+static void log_spectrum(spectrum_e channel)
+{
+  const sample_log_key_e key       = spectrum_key[channel];
+  const uint64_t         timestamp = spectrum_timestamp[channel];
+  sample_record_spectrum_band_s band[SPECTRUM_BAND_COUNT_MAX];
+  const size_t band_count = spectrum_get_bands(channel, band);
 
-  acceleration_filter_x.push_sample(sample->acceleration.x);
-  acceleration_filter_y.push_sample(sample->acceleration.y);
-  acceleration_filter_z.push_sample(sample->acceleration.z);
-  acceleration_filter_m.push_sample(acceleration_magnitude);
+  if(0 != ((1<<key) & spectrum_key_mask_stdio))
+  {
+    spectrum_format_ascii(key, timestamp, band, band_count);
+    /* Skip leading newline */
+    printf("%s\n", &spectrum_ascii_buffer[1]);
+  }
+
+  if(0 != ((1<<key) & spectrum_key_mask_sd))
+  {
+    switch(sample_file_get_format())
+    {
+      case SAMPLE_FILE_FORMAT_ASCII:
+      {
+        size_t length = spectrum_format_ascii(key, timestamp, band, band_count);
+        sample_file_write(spectrum_ascii_buffer, length);
+        break;
+      }
+      case SAMPLE_FILE_FORMAT_BINARY:
+      case SAMPLE_FILE_FORMAT_STEIM1:
+      {
+        size_t length = spectrum_format_binary(key, timestamp, band, band_count);
+        sample_file_write(spectrum_binary_buffer, length);
+        break;
+      }
+      case SAMPLE_FILE_FORMAT_MINISEED:
+      {
+        /* miniSEED files only hold data records */
+        break;
+      }
+      default:
+      {
+        SEISMOMETER_ASSERT(0);
+        break;
+      }
+    }
+  }
+}
+
+/* Transforms the completed segments and logs completed spectra */
+static void spectrum_process_all()
+{
+  for(unsigned int channel = 0; channel < SPECTRUM_MAX; channel++)
+  {
+    if(spectrum_enabled((spectrum_e)channel) && spectrum[channel]->process())
+    {
+      log_spectrum((spectrum_e)channel);
+    }
+  }
+}
+
+/* Goertzel band energy of the filtered acceleration and pendulum channels, see goertzel_bank.hpp.  Each filter bank
+   channel has its own key, records are logged once per second for keys in a Goertzel mask */
+#define GOERTZEL_KEY_MASK ((1<<SAMPLE_LOG_ACCEL_X_FILTERED) | (1<<SAMPLE_LOG_ACCEL_Y_FILTERED) | (1<<SAMPLE_LOG_ACCEL_Z_FILTERED) | \
+                           (1<<SAMPLE_LOG_ACCEL_M_FILTERED) | (1<<SAMPLE_LOG_PENDULUM_FILTERED))
+sample_log_key_mask_t goertzel_key_mask_stdio = 0x00;
+sample_log_key_mask_t goertzel_key_mask_sd    = GOERTZEL_KEY_MASK;
+
+static const float goertzel_frequency_hz[] = SEISMOMETER_GOERTZEL_FREQUENCIES_HZ;
+#define GOERTZEL_BIN_COUNT (sizeof(goertzel_frequency_hz)/sizeof(goertzel_frequency_hz[0]))
+static_assert(GOERTZEL_BIN_COUNT <= UINT8_MAX, "Goertzel records hold up to 255 bins");
+
+/* "\nG|<key>|<timestamp>|<block length>" then "|<frequency mHz>:<power cdB>" per bin */
+#define GOERTZEL_ASCII_LENGTH_MAX (1+2+2+1+16+1+4+(GOERTZEL_BIN_COUNT*(1+8+1+6)))
+static char    goertzel_ascii_buffer [GOERTZEL_ASCII_LENGTH_MAX+1];
+static uint8_t goertzel_binary_buffer[sizeof(sample_record_goertzel_s)+(GOERTZEL_BIN_COUNT*sizeof(sample_record_goertzel_bin_s))];
+
+static inline bool goertzel_enabled(sample_log_key_mask_t key_mask)
+{
+  return (0 != (key_mask & (goertzel_key_mask_sd | goertzel_key_mask_stdio)));
+}
+
+/* Formats the Goertzel record with a leading newline, returns the length */
+static size_t goertzel_format_ascii(sample_log_key_e key, uint64_t timestamp, size_t block_length, const sample_record_goertzel_bin_s *bin)
+{
+  int length = snprintf(goertzel_ascii_buffer, sizeof(goertzel_ascii_buffer), "\nG|%02X|%016llX|%04X", (uint8_t)key, timestamp, (uint16_t)block_length);
+  for(size_t i = 0; i < GOERTZEL_BIN_COUNT; i++)
+  {
+    length += snprintf(&goertzel_ascii_buffer[length], (sizeof(goertzel_ascii_buffer)-length), "|%lX:%d", bin[i].frequency_mhz, bin[i].power_cdb);
+  }
+  SEISMOMETER_ASSERT((length > 0) && (length < (int)sizeof(goertzel_ascii_buffer)));
+  return length;
+}
+
+static size_t goertzel_format_binary(sample_log_key_e key, uint64_t timestamp, size_t block_length, const sample_record_goertzel_bin_s *bin)
+{
+  const sample_record_goertzel_s record =
+  {
+    .type         = SAMPLE_RECORD_TYPE_GOERTZEL,
+    .key          = (uint8_t)key,
+    .bin_count    = (uint8_t)GOERTZEL_BIN_COUNT,
+    .block_length = (uint16_t)block_length,
+    .timestamp    = timestamp,
+  };
+  memcpy(goertzel_binary_buffer, &record, sizeof(record));
+  memcpy(&goertzel_binary_buffer[sizeof(record)], bin, GOERTZEL_BIN_COUNT*sizeof(sample_record_goertzel_bin_s));
+  return (sizeof(record)+(GOERTZEL_BIN_COUNT*sizeof(sample_record_goertzel_bin_s)));
+}
+
+/* Logs the last block of 'channel' of 'bank' as 'key' */
+static void log_goertzel(sample_log_key_e key, uint64_t timestamp, const goertzel_bank_c *bank, size_t channel)
+{
+  sample_record_goertzel_bin_s bin[GOERTZEL_BIN_COUNT];
+  for(size_t i = 0; i < GOERTZEL_BIN_COUNT; i++)
+  {
+    bin[i].frequency_mhz = (uint32_t)lroundf(goertzel_frequency_hz[i]*1000);
+    bin[i].power_cdb     = power_to_cdb(bank->get_power(channel, i));
+  }
+
+  if(0 != ((1<<key) & goertzel_key_mask_stdio))
+  {
+    goertzel_format_ascii(key, timestamp, bank->get_block_length(), bin);
+    /* Skip leading newline */
+    printf("%s\n", &goertzel_ascii_buffer[1]);
+  }
+
+  if(0 != ((1<<key) & goertzel_key_mask_sd))
+  {
+    switch(sample_file_get_format())
+    {
+      case SAMPLE_FILE_FORMAT_ASCII:
+      {
+        size_t length = goertzel_format_ascii(key, timestamp, bank->get_block_length(), bin);
+        sample_file_write(goertzel_ascii_buffer, length);
+        break;
+      }
+      case SAMPLE_FILE_FORMAT_BINARY:
+      case SAMPLE_FILE_FORMAT_STEIM1:
+      {
+        size_t length = goertzel_format_binary(key, timestamp, bank->get_block_length(), bin);
+        sample_file_write(goertzel_binary_buffer, length);
+        break;
+      }
+      case SAMPLE_FILE_FORMAT_MINISEED:
+      {
+        /* miniSEED files only hold data records */
+        break;
+      }
+      default:
+      {
+        SEISMOMETER_ASSERT(0);
+        break;
+      }
+    }
+  }
+}
+
+/* 10Hz low pass with the DC offset removed, see SEISMOMETER_FILTER_DC_BLOCKER_SHIFT */
+#define SAMPLE_FILTER_MOVING_AVERAGE_ORDER ((0 == SEISMOMETER_FILTER_DC_BLOCKER_SHIFT) ? 512 : 0)
+template <size_t CHANNELS, filter_order_t ORDER, const filter_coefficient_t *COEFFICIENT, filter_sample_t GAIN_NUMERATOR, filter_sample_t GAIN_DENOMINATOR>
+using sample_filter_rate_bank_c = fir_filter_bank_c<CHANNELS, ORDER, COEFFICIENT, GAIN_NUMERATOR, GAIN_DENOMINATOR,
+                                                    SAMPLE_FILTER_MOVING_AVERAGE_ORDER, SEISMOMETER_FILTER_DC_BLOCKER_SHIFT>;
+
+/* Filter bank of the coefficient set of the sample rate, selected by init().  The coefficients of each rate are
+   compile time constants, so each rate has its own fir_filter_bank_c and they share storage as only one is used */
+template <size_t CHANNELS>
+class sample_filter_bank_c
+{
+  private:
+    using bank_50hz_c  = sample_filter_rate_bank_c<CHANNELS, FIR_HAMMING_LPF_50HZ_FS_10HZ_CUTOFF_ORDER,  fir_hamming_lpf_50hz_fs_10hz_cutoff,
+                                                   FIR_HAMMING_LPF_50HZ_FS_10HZ_CUTOFF_GAIN_NUM,  FIR_HAMMING_LPF_50HZ_FS_10HZ_CUTOFF_GAIN_DEN>;
+    using bank_100hz_c = sample_filter_rate_bank_c<CHANNELS, FIR_HAMMING_LPF_100HZ_FS_10HZ_CUTOFF_ORDER, fir_hamming_lpf_100hz_fs_10hz_cutoff,
+                                                   FIR_HAMMING_LPF_100HZ_FS_10HZ_CUTOFF_GAIN_NUM, FIR_HAMMING_LPF_100HZ_FS_10HZ_CUTOFF_GAIN_DEN>;
+    using bank_200hz_c = sample_filter_rate_bank_c<CHANNELS, FIR_HAMMING_LPF_200HZ_FS_10HZ_CUTOFF_ORDER, fir_hamming_lpf_200hz_fs_10hz_cutoff,
+                                                   FIR_HAMMING_LPF_200HZ_FS_10HZ_CUTOFF_GAIN_NUM, FIR_HAMMING_LPF_200HZ_FS_10HZ_CUTOFF_GAIN_DEN>;
+    using bank_500hz_c = sample_filter_rate_bank_c<CHANNELS, FIR_HAMMING_LPF_500HZ_FS_10HZ_CUTOFF_ORDER, fir_hamming_lpf_500hz_fs_10hz_cutoff,
+                                                   FIR_HAMMING_LPF_500HZ_FS_10HZ_CUTOFF_GAIN_NUM, FIR_HAMMING_LPF_500HZ_FS_10HZ_CUTOFF_GAIN_DEN>;
+
+    sample_rate_e rate = SAMPLE_RATE_MAX;
+    union
+    {
+      bank_50hz_c  bank_50hz;
+      bank_100hz_c bank_100hz;
+      bank_200hz_c bank_200hz;
+      bank_500hz_c bank_500hz;
+    };
+
+  public:
+    sample_filter_bank_c() {};
+    /* Constructs the bank of 'new_rate', once */
+    void init(sample_rate_e new_rate)
+    {
+      SEISMOMETER_ASSERT(SAMPLE_RATE_MAX == rate);
+      rate = new_rate;
+      switch(rate)
+      {
+        case SAMPLE_RATE_50HZ:
+        {
+          new (&bank_50hz) bank_50hz_c();
+          break;
+        }
+        case SAMPLE_RATE_100HZ:
+        {
+          new (&bank_100hz) bank_100hz_c();
+          break;
+        }
+        case SAMPLE_RATE_200HZ:
+        {
+          new (&bank_200hz) bank_200hz_c();
+          break;
+        }
+        case SAMPLE_RATE_500HZ:
+        {
+          new (&bank_500hz) bank_500hz_c();
+          break;
+        }
+        default:
+        {
+          SEISMOMETER_ASSERT(0);
+          break;
+        }
+      }
+    };
+    /* See fir_filter_bank_c::push_samples() */
+    inline void push_samples(const filter_sample_t (*sample)[CHANNELS], size_t count, filter_sample_t (*output)[CHANNELS])
+    {
+      switch(rate)
+      {
+        case SAMPLE_RATE_50HZ:
+        {
+          bank_50hz.push_samples(sample, count, output);
+          break;
+        }
+        case SAMPLE_RATE_100HZ:
+        {
+          bank_100hz.push_samples(sample, count, output);
+          break;
+        }
+        case SAMPLE_RATE_200HZ:
+        {
+          bank_200hz.push_samples(sample, count, output);
+          break;
+        }
+        case SAMPLE_RATE_500HZ:
+        {
+          bank_500hz.push_samples(sample, count, output);
+          break;
+        }
+        default:
+        {
+          SEISMOMETER_ASSERT(0);
+          break;
+        }
+      }
+    };
+};
+
+static_assert((0 == SEISMOMETER_FILTER_IIR_KEY_MASK) || (SEISMOMETER_FILTER_DC_BLOCKER_SHIFT > 0),
+              "IIR filtered channels remove the DC offset with the DC blocker");
+static const fir_filter_config_s sample_iir_filter_config
+{
+  .moving_average_order = 0,
+  .dc_blocker_shift     = SEISMOMETER_FILTER_DC_BLOCKER_SHIFT,
+  .gain_numerator   = 1,
+  .gain_denominator = 1,
+};
+
+/* Returns the 10Hz low pass biquad cascade of filtered channel 'key' if SEISMOMETER_FILTER_IIR_KEY_MASK selects it, or
+   nullptr for the FIR filter */
+static biquad_filter_c *sample_iir_filter_create(sample_log_key_e key, sample_rate_e rate)
+{
+  if(0 == (SEISMOMETER_FILTER_IIR_KEY_MASK & (1<<key)))
+  {
+    return nullptr;
+  }
+  if(SAMPLE_RATE_100HZ != rate)
+  {
+    SEISMOMETER_PRINTF(SEISMOMETER_LOG_WARNING, "No IIR filter at %luHz, key %u keeps the FIR filter.\n", sample_rate_hz(), key);
+    return nullptr;
+  }
+  return new biquad_filter_c(BIQUAD_BUTTERWORTH_LPF_100HZ_FS_10HZ_CUTOFF_SECTIONS, biquad_butterworth_lpf_100hz_fs_10hz_cutoff,
+                             &sample_iir_filter_config);
+}
+
+/* Low passes 'count' samples of 'channel' from 'sample' with 'iir', writing 'filtered' in place of the FIR output */
+template <size_t CHANNELS>
+static void sample_iir_filter(biquad_filter_c *iir, const filter_sample_t (*sample)[CHANNELS], filter_sample_t (*filtered)[CHANNELS],
+                              size_t count, size_t channel)
+{
+  filter_sample_t channel_sample[SEISMOMETER_SAMPLE_HANDLER_BATCH_SIZE];
+  SEISMOMETER_ASSERT(count <= SEISMOMETER_SAMPLE_HANDLER_BATCH_SIZE);
+  for(size_t i = 0; i < count; i++)
+  {
+    channel_sample[i] = sample[i][channel];
+  }
+  iir->push_samples(channel_sample, count, channel_sample);
+  for(size_t i = 0; i < count; i++)
+  {
+    filtered[i][channel] = channel_sample[i];
+  }
+}
+
+/* Replaces each of 'count' samples of 'channel' with the running median of 'median' */
+template <size_t CHANNELS>
+static void sample_median_filter(median_filter_c *median, filter_sample_t (*sample)[CHANNELS], size_t count, size_t channel)
+{
+  if(median->get_window_length() > 1)
+  {
+    /* Gather the channel so the median runs as one block */
+    filter_sample_t channel_sample[SEISMOMETER_SAMPLE_HANDLER_BATCH_SIZE];
+    SEISMOMETER_ASSERT(count <= SEISMOMETER_SAMPLE_HANDLER_BATCH_SIZE);
+    for(size_t i = 0; i < count; i++)
+    {
+      channel_sample[i] = sample[i][channel];
+    }
+    median->push_samples(channel_sample, count, channel_sample);
+    for(size_t i = 0; i < count; i++)
+    {
+      sample[i][channel] = channel_sample[i];
+    }
+  }
+}
+
+typedef enum
+{
+  ACCELERATION_FILTER_X,
+  ACCELERATION_FILTER_Y,
+  ACCELERATION_FILTER_Z,
+  ACCELERATION_FILTER_M,
+  ACCELERATION_FILTER_MAX,
+} acceleration_filter_e;
+static sample_filter_bank_c<ACCELERATION_FILTER_MAX> acceleration_filter;
+/* IIR filter per channel selected by SEISMOMETER_FILTER_IIR_KEY_MASK, the FIR bank only runs while a channel uses it.
+   Created at init */
+static biquad_filter_c *acceleration_iir[ACCELERATION_FILTER_MAX] = {nullptr};
+static bool             acceleration_fir_used                     = true;
+static median_filter_c acceleration_median[ACCELERATION_FILTER_MAX] = {SEISMOMETER_FILTER_MEDIAN_WINDOW, SEISMOMETER_FILTER_MEDIAN_WINDOW,
+                                                                       SEISMOMETER_FILTER_MEDIAN_WINDOW, SEISMOMETER_FILTER_MEDIAN_WINDOW};
+/* One second blocks at the sample rate, created at init */
+static goertzel_bank_c *acceleration_goertzel = nullptr;
+static const sample_log_key_e acceleration_goertzel_key[ACCELERATION_FILTER_MAX] =
+{
+  SAMPLE_LOG_ACCEL_X_FILTERED, /* ACCELERATION_FILTER_X */
+  SAMPLE_LOG_ACCEL_Y_FILTERED, /* ACCELERATION_FILTER_Y */
+  SAMPLE_LOG_ACCEL_Z_FILTERED, /* ACCELERATION_FILTER_Z */
+  SAMPLE_LOG_ACCEL_M_FILTERED, /* ACCELERATION_FILTER_M */
+};
+#define ACCELERATION_GOERTZEL_KEY_MASK ((1<<SAMPLE_LOG_ACCEL_X_FILTERED) | (1<<SAMPLE_LOG_ACCEL_Y_FILTERED) | \
+                                        (1<<SAMPLE_LOG_ACCEL_Z_FILTERED) | (1<<SAMPLE_LOG_ACCEL_M_FILTERED))
+
+/* Raw magnitude and filtered channels of the last block filtered by acceleration_samples_filter() */
+static filter_sample_t acceleration_block         [SEISMOMETER_SAMPLE_HANDLER_BATCH_SIZE][ACCELERATION_FILTER_MAX];
+static filter_sample_t acceleration_block_filtered[SEISMOMETER_SAMPLE_HANDLER_BATCH_SIZE][ACCELERATION_FILTER_MAX];
+
+/* Filters 'count' acceleration samples as one block, each is then logged by acceleration_sample_log() */
+static void acceleration_samples_filter(const seismometer_sample_s *const *samples, size_t count)
+{
+  SEISMOMETER_ASSERT(samples != nullptr);
+  SEISMOMETER_ASSERT(count <= SEISMOMETER_SAMPLE_HANDLER_BATCH_SIZE);
+
+  filter_sample_t despiked[SEISMOMETER_SAMPLE_HANDLER_BATCH_SIZE][ACCELERATION_FILTER_MAX];
+  for(size_t i = 0; i < count; i++)
+  {
+    const seismometer_sample_s *sample = samples[i];
+    SEISMOMETER_ASSERT(SEISMOMETER_SAMPLE_TYPE_ACCELERATION == sample->type);
+    acceleration_block[i][ACCELERATION_FILTER_X] = sample->acceleration.x;
+    acceleration_block[i][ACCELERATION_FILTER_Y] = sample->acceleration.y;
+    acceleration_block[i][ACCELERATION_FILTER_Z] = sample->acceleration.z;
+    acceleration_block[i][ACCELERATION_FILTER_M] = sqrt( (sample->acceleration.x*sample->acceleration.x) + 
+                                                         (sample->acceleration.y*sample->acceleration.y) + 
+                                                         (sample->acceleration.z*sample->acceleration.z) );
+  }
+  /* Magnitude is logged unfiltered, despike a copy */
+  memcpy(despiked, acceleration_block, (count*sizeof(acceleration_block[0])));
+  for(size_t channel = 0; channel < ACCELERATION_FILTER_MAX; channel++)
+  {
+    sample_median_filter(&acceleration_median[channel], despiked, count, channel);
+  }
+  if(acceleration_fir_used)
+  {
+    acceleration_filter.push_samples(despiked, count, acceleration_block_filtered);
+  }
+  for(size_t channel = 0; channel < ACCELERATION_FILTER_MAX; channel++)
+  {
+    if(acceleration_iir[channel] != nullptr)
+    {
+      sample_iir_filter(acceleration_iir[channel], despiked, acceleration_block_filtered, count, channel);
+    }
+  }
+}
+
+/* Logs 'sample', the 'i'th sample of the last block filtered by acceleration_samples_filter() */
+static void acceleration_sample_log(const seismometer_sample_s *sample, size_t i)
+{
+  static absolute_time_t last_sample_time = {0};
 
   uint64_t timestamp = rtc_ds3231_absolute_time_to_epoch_ms(sample->time);
+  sample_frame_begin(sample->index, timestamp);
   log_sample(SAMPLE_LOG_ACCEL_X,          sample->index, timestamp, sample->acceleration.x);
   log_sample(SAMPLE_LOG_ACCEL_Y,          sample->index, timestamp, sample->acceleration.y);
   log_sample(SAMPLE_LOG_ACCEL_Z,          sample->index, timestamp, sample->acceleration.z);
-  log_sample(SAMPLE_LOG_ACCEL_M,          sample->index, timestamp, acceleration_magnitude);
-  log_sample(SAMPLE_LOG_ACCEL_X_FILTERED, sample->index, timestamp, acceleration_filter_x.get_filtered_sample_dc_offset_removed());
-  log_sample(SAMPLE_LOG_ACCEL_Y_FILTERED, sample->index, timestamp, acceleration_filter_y.get_filtered_sample_dc_offset_removed());
-  log_sample(SAMPLE_LOG_ACCEL_Z_FILTERED, sample->index, timestamp, acceleration_filter_z.get_filtered_sample_dc_offset_removed());
-  log_sample(SAMPLE_LOG_ACCEL_M_FILTERED, sample->index, timestamp, acceleration_filter_m.get_filtered_sample_dc_offset_removed());
+  log_sample(SAMPLE_LOG_ACCEL_M,          sample->index, timestamp, acceleration_block[i][ACCELERATION_FILTER_M]);
+  log_sample(SAMPLE_LOG_ACCEL_X_FILTERED, sample->index, timestamp, acceleration_block_filtered[i][ACCELERATION_FILTER_X]);
+  log_sample(SAMPLE_LOG_ACCEL_Y_FILTERED, sample->index, timestamp, acceleration_block_filtered[i][ACCELERATION_FILTER_Y]);
+  log_sample(SAMPLE_LOG_ACCEL_Z_FILTERED, sample->index, timestamp, acceleration_block_filtered[i][ACCELERATION_FILTER_Z]);
+  log_sample(SAMPLE_LOG_ACCEL_M_FILTERED, sample->index, timestamp, acceleration_block_filtered[i][ACCELERATION_FILTER_M]);
+  sample_frame_end();
+
+  event_capture_acceleration(sample->index, timestamp, &sample->acceleration, acceleration_block_filtered[i][ACCELERATION_FILTER_M]);
+  spectrum_push(SPECTRUM_ACCEL_X, sample->acceleration.x, timestamp);
+  spectrum_push(SPECTRUM_ACCEL_Y, sample->acceleration.y, timestamp);
+  spectrum_push(SPECTRUM_ACCEL_Z, sample->acceleration.z, timestamp);
+
+  if(goertzel_enabled(ACCELERATION_GOERTZEL_KEY_MASK) && acceleration_goertzel->push_sample(acceleration_block_filtered[i]))
+  {
+    for(size_t channel = 0; channel < ACCELERATION_FILTER_MAX; channel++)
+    {
+      log_goertzel(acceleration_goertzel_key[channel], timestamp, acceleration_goertzel, channel);
+    }
+  }
 
 #ifdef SEISMOMETER_SAMPLE_DEBUG_PRINT
   SEISMOMETER_PRINTF(SEISMOMETER_LOG_DEBUG, "i: %6u hz: %7.3f mean hz: %7.3f - X: %7.3f Y: %7.3f Z: %7.3f %M: %7.3f\n", 
@@ -178,12 +988,22 @@ static void acceleration_sample_handler(const seismometer_sample_s *sample)
     ((double)sample->acceleration.x)/1000,
     ((double)sample->acceleration.y)/1000,
     ((double)sample->acceleration.z)/1000,
-    ((double)acceleration_magnitude)/1000);
+    ((double)acceleration_block[i][ACCELERATION_FILTER_M])/1000);
 #endif
 
   last_sample_time = sample->time;
 }
 
+/* Filters 'count' acceleration samples as one block then logs each */
+static void acceleration_samples_handler(const seismometer_sample_s *const *samples, size_t count)
+{
+  acceleration_samples_filter(samples, count);
+  for(size_t i = 0; i < count; i++)
+  {
+    acceleration_sample_log(samples[i], i);
+  }
+}
+
 static void accelerometer_temperature_sample_handler(const seismometer_sample_s *sample)
 {
   SEISMOMETER_ASSERT(sample != nullptr);
@@ -203,18 +1023,150 @@ static void accelerometer_temperature_sample_handler(const seismometer_sample_s
   last_sample_time = sample->time;
 }
 
-static const fir_filter_config_s pendulum_fir_filter_config
+typedef enum
 {
-  .moving_average_order = 512,
-  .gain_numerator   = FIR_HAMMING_LPF_100HZ_FS_10HZ_CUTOFF_GAIN_NUM,
-  .gain_denominator = FIR_HAMMING_LPF_100HZ_FS_10HZ_CUTOFF_GAIN_DEN,
-};
-static fir_filter_c pendulum_10x_filter (FIR_HAMMING_LPF_100HZ_FS_10HZ_CUTOFF_ORDER, fir_hamming_lpf_100hz_fs_10hz_cutoff, &pendulum_fir_filter_config);
-static fir_filter_c pendulum_100x_filter(FIR_HAMMING_LPF_100HZ_FS_10HZ_CUTOFF_ORDER, fir_hamming_lpf_100hz_fs_10hz_cutoff, &pendulum_fir_filter_config);
-static void pendulum_sample_handler(const seismometer_sample_s *sample)
+  PENDULUM_FILTER_10X,
+  PENDULUM_FILTER_100X,
+  PENDULUM_FILTER_MAX,
+} pendulum_filter_e;
+static sample_filter_bank_c<PENDULUM_FILTER_MAX> pendulum_filter;
+/* IIR filters of both pendulum channels when SEISMOMETER_FILTER_IIR_KEY_MASK selects the filtered pendulum key, in
+   place of the FIR bank.  Created at init */
+static biquad_filter_c *pendulum_iir[PENDULUM_FILTER_MAX] = {nullptr};
+static median_filter_c pendulum_median[PENDULUM_FILTER_MAX] = {SEISMOMETER_FILTER_MEDIAN_WINDOW, SEISMOMETER_FILTER_MEDIAN_WINDOW};
+/* Goertzel energy of the logged filtered pendulum channel, one second blocks created at init */
+static goertzel_bank_c *pendulum_goertzel = nullptr;
+
+/* Decimated 100x pendulum channels for long-term archives, 1Hz is decimated from the 10Hz output.  Each key counts its
+   own sample index so the channels stay contiguous for Steim1/miniSEED blocks.  The 20Hz and 10Hz filters are designed
+   at 100Hz, higher sample rates are first decimated to 100Hz and 50Hz is interpolated by 2.  Created at init */
+static fir_polyphase_c *pendulum_decimator_100hz = nullptr;
+static fir_polyphase_c *pendulum_decimator_20hz  = nullptr;
+static fir_polyphase_c *pendulum_decimator_10hz  = nullptr;
+static fir_polyphase_c *pendulum_decimator_1hz   = nullptr;
+static sample_index_t  pendulum_index_20hz = 0;
+static sample_index_t  pendulum_index_10hz = 0;
+static sample_index_t  pendulum_index_1hz  = 0;
+/* Group delay of each decimated channel, summed over its cascaded stages, subtracted from its timestamps */
+static uint32_t        pendulum_delay_20hz_ms = 0;
+static uint32_t        pendulum_delay_10hz_ms = 0;
+static uint32_t        pendulum_delay_1hz_ms  = 0;
+
+/* Group delay of a linear phase FIR stage of 'order' taps running at 'rate_hz', (order-1)/2 input periods */
+#define PENDULUM_DECIMATE_DELAY_US(order, rate_hz) ((((order)-1)*1000*1000)/(2*(rate_hz)))
+
+static void pendulum_decimate_init(sample_rate_e rate)
+{
+  filter_order_t interpolation = 1;
+  uint32_t       delay_100hz_us = 0;
+  switch(rate)
+  {
+    case SAMPLE_RATE_50HZ:
+    {
+      interpolation = 2;
+      break;
+    }
+    case SAMPLE_RATE_100HZ:
+    {
+      break;
+    }
+    case SAMPLE_RATE_200HZ:
+    {
+      pendulum_decimator_100hz = new fir_polyphase_c(FIR_HAMMING_LPF_DECIMATE_2_ORDER, fir_hamming_lpf_decimate_2, 1, 2,
+                                                     FIR_HAMMING_LPF_DECIMATE_2_GAIN_NUM, FIR_HAMMING_LPF_DECIMATE_2_GAIN_DEN);
+      delay_100hz_us = PENDULUM_DECIMATE_DELAY_US(FIR_HAMMING_LPF_DECIMATE_2_ORDER, 200);
+      break;
+    }
+    case SAMPLE_RATE_500HZ:
+    {
+      pendulum_decimator_100hz = new fir_polyphase_c(FIR_HAMMING_LPF_DECIMATE_5_ORDER, fir_hamming_lpf_decimate_5, 1, 5,
+                                                     FIR_HAMMING_LPF_DECIMATE_5_GAIN_NUM, FIR_HAMMING_LPF_DECIMATE_5_GAIN_DEN);
+      delay_100hz_us = PENDULUM_DECIMATE_DELAY_US(FIR_HAMMING_LPF_DECIMATE_5_ORDER, 500);
+      break;
+    }
+    default:
+    {
+      SEISMOMETER_ASSERT(0);
+      break;
+    }
+  }
+  /* Zero stuffing divides the DC gain by the interpolation */
+  pendulum_decimator_20hz = new fir_polyphase_c(FIR_HAMMING_LPF_DECIMATE_5_ORDER, fir_hamming_lpf_decimate_5, interpolation, 5,
+                                                (interpolation*FIR_HAMMING_LPF_DECIMATE_5_GAIN_NUM), FIR_HAMMING_LPF_DECIMATE_5_GAIN_DEN);
+  pendulum_decimator_10hz = new fir_polyphase_c(FIR_HAMMING_LPF_DECIMATE_10_ORDER, fir_hamming_lpf_decimate_10, interpolation, 10,
+                                                (interpolation*FIR_HAMMING_LPF_DECIMATE_10_GAIN_NUM), FIR_HAMMING_LPF_DECIMATE_10_GAIN_DEN);
+  pendulum_decimator_1hz  = new fir_polyphase_c(FIR_HAMMING_LPF_DECIMATE_10_ORDER, fir_hamming_lpf_decimate_10, 1, 10,
+                                                FIR_HAMMING_LPF_DECIMATE_10_GAIN_NUM, FIR_HAMMING_LPF_DECIMATE_10_GAIN_DEN);
+
+  /* The 20Hz and 10Hz filters run at 100Hz, interpolated or not */
+  const uint32_t delay_20hz_us = delay_100hz_us + PENDULUM_DECIMATE_DELAY_US(FIR_HAMMING_LPF_DECIMATE_5_ORDER,  100);
+  const uint32_t delay_10hz_us = delay_100hz_us + PENDULUM_DECIMATE_DELAY_US(FIR_HAMMING_LPF_DECIMATE_10_ORDER, 100);
+  const uint32_t delay_1hz_us  = delay_10hz_us  + PENDULUM_DECIMATE_DELAY_US(FIR_HAMMING_LPF_DECIMATE_10_ORDER, 10);
+  pendulum_delay_20hz_ms = ((delay_20hz_us+500)/1000);
+  pendulum_delay_10hz_ms = ((delay_10hz_us+500)/1000);
+  pendulum_delay_1hz_ms  = ((delay_1hz_us +500)/1000);
+}
+
+static void pendulum_decimate(filter_sample_t sample, uint64_t timestamp)
+{
+  filter_sample_t output_100hz = sample;
+  if((nullptr == pendulum_decimator_100hz) || (pendulum_decimator_100hz->push_sample(sample, &output_100hz) > 0))
+  {
+    filter_sample_t output_20hz;
+    if(pendulum_decimator_20hz->push_sample(output_100hz, &output_20hz) > 0)
+    {
+      log_sample(SAMPLE_LOG_PENDULUM_20HZ, pendulum_index_20hz++, (timestamp-pendulum_delay_20hz_ms), output_20hz);
+    }
+
+    filter_sample_t output_10hz;
+    if(pendulum_decimator_10hz->push_sample(output_100hz, &output_10hz) > 0)
+    {
+      log_sample(SAMPLE_LOG_PENDULUM_10HZ, pendulum_index_10hz++, (timestamp-pendulum_delay_10hz_ms), output_10hz);
+
+      filter_sample_t output_1hz;
+      if(pendulum_decimator_1hz->push_sample(output_10hz, &output_1hz) > 0)
+      {
+        log_sample(SAMPLE_LOG_PENDULUM_1HZ, pendulum_index_1hz++, (timestamp-pendulum_delay_1hz_ms), output_1hz);
+      }
+    }
+  }
+}
+/* Filtered channels of the last block filtered by pendulum_samples_filter() */
+static filter_sample_t pendulum_block_filtered[SEISMOMETER_SAMPLE_HANDLER_BATCH_SIZE][PENDULUM_FILTER_MAX];
+
+/* Filters 'count' pendulum samples as one block, each is then logged by pendulum_sample_log() */
+static void pendulum_samples_filter(const seismometer_sample_s *const *samples, size_t count)
+{
+  SEISMOMETER_ASSERT(samples != nullptr);
+  SEISMOMETER_ASSERT(count <= SEISMOMETER_SAMPLE_HANDLER_BATCH_SIZE);
+
+  filter_sample_t pendulum[SEISMOMETER_SAMPLE_HANDLER_BATCH_SIZE][PENDULUM_FILTER_MAX];
+  for(size_t i = 0; i < count; i++)
+  {
+    SEISMOMETER_ASSERT(SEISMOMETER_SAMPLE_TYPE_PENDULUM == samples[i]->type);
+    pendulum[i][PENDULUM_FILTER_10X]  = samples[i]->pendulum.x10;
+    pendulum[i][PENDULUM_FILTER_100X] = samples[i]->pendulum.x100;
+  }
+  for(size_t channel = 0; channel < PENDULUM_FILTER_MAX; channel++)
+  {
+    sample_median_filter(&pendulum_median[channel], pendulum, count, channel);
+  }
+  if(nullptr == pendulum_iir[PENDULUM_FILTER_10X])
+  {
+    pendulum_filter.push_samples(pendulum, count, pendulum_block_filtered);
+  }
+  else
+  {
+    for(size_t channel = 0; channel < PENDULUM_FILTER_MAX; channel++)
+    {
+      sample_iir_filter(pendulum_iir[channel], pendulum, pendulum_block_filtered, count, channel);
+    }
+  }
+}
+
+/* Logs 'sample', the 'i'th sample of the last block filtered by pendulum_samples_filter() */
+static void pendulum_sample_log(const seismometer_sample_s *sample, size_t i)
 {
-  SEISMOMETER_ASSERT(sample != nullptr);
-  SEISMOMETER_ASSERT(SEISMOMETER_SAMPLE_TYPE_PENDULUM == sample->type);
   static absolute_time_t last_sample_time = {0};
 
 #ifdef SEISMOMETER_SAMPLE_DEBUG_PRINT
@@ -227,26 +1179,43 @@ static void pendulum_sample_handler(const seismometer_sample_s *sample)
 #endif
 
   uint64_t timestamp = rtc_ds3231_absolute_time_to_epoch_ms(sample->time);
+  sample_frame_begin(sample->index, timestamp);
   log_sample(SAMPLE_LOG_PENDULUM_10X,  sample->index, timestamp, sample->pendulum.x10 );
   log_sample(SAMPLE_LOG_PENDULUM_100X, sample->index, timestamp, sample->pendulum.x100);
 
-  pendulum_10x_filter.push_sample (sample->pendulum.x10);
-  pendulum_100x_filter.push_sample(sample->pendulum.x100);
-
-  if( (pendulum_100x_filter.get_filtered_sample_dc_offset_removed() >  500) ||
-      (pendulum_100x_filter.get_filtered_sample_dc_offset_removed() < -500) )
+  filter_sample_t pendulum_filtered = pendulum_block_filtered[i][PENDULUM_FILTER_100X];
+  if( (pendulum_block_filtered[i][PENDULUM_FILTER_100X] >  500) ||
+      (pendulum_block_filtered[i][PENDULUM_FILTER_100X] < -500) )
   {
-    log_sample(SAMPLE_LOG_PENDULUM_FILTERED, sample->index, timestamp, pendulum_10x_filter.get_filtered_sample_dc_offset_removed()*10);
+    pendulum_filtered = pendulum_block_filtered[i][PENDULUM_FILTER_10X]*10;
   }
-  else
+  log_sample(SAMPLE_LOG_PENDULUM_FILTERED, sample->index, timestamp, pendulum_filtered);
+  sample_frame_end();
+
+  event_capture_pendulum(sample->index, timestamp, &sample->pendulum, pendulum_filtered);
+
+  /* Decimated channels have their own indices so are logged outside the frame */
+  pendulum_decimate(sample->pendulum.x100, timestamp);
+  spectrum_push(SPECTRUM_PENDULUM_100X, sample->pendulum.x100, timestamp);
+
+  if(goertzel_enabled(1<<SAMPLE_LOG_PENDULUM_FILTERED) && pendulum_goertzel->push_sample(&pendulum_filtered))
   {
-    log_sample(SAMPLE_LOG_PENDULUM_FILTERED, sample->index, timestamp, pendulum_100x_filter.get_filtered_sample_dc_offset_removed());
+    log_goertzel(SAMPLE_LOG_PENDULUM_FILTERED, timestamp, pendulum_goertzel, 0);
   }
 
-
   last_sample_time = sample->time;
 }
 
+/* Filters 'count' pendulum samples as one block then logs each */
+static void pendulum_samples_handler(const seismometer_sample_s *const *samples, size_t count)
+{
+  pendulum_samples_filter(samples, count);
+  for(size_t i = 0; i < count; i++)
+  {
+    pendulum_sample_log(samples[i], i);
+  }
+}
+
 static void handle_stdin_command(char * command)
 {
   SEISMOMETER_ASSERT(command != nullptr);
@@ -256,6 +1225,41 @@ static void handle_stdin_command(char * command)
 
   switch(command[0])
   {
+    case 'E':
+    {
+      if(strncmp(command, "EVENTCAPTURE", 12) == 0)
+      {
+        command_handled = true;
+        event_capture_set_enabled(0 != strtol(&command[12], nullptr, 10));
+        SEISMOMETER_PRINTF(SEISMOMETER_LOG_INFO, "%s event capture.\n", event_capture_get_enabled() ? "Enabling" : "Disabling");
+      }
+      break;
+    }
+    case 'G':
+    {
+      if(strncmp(command, "GOERTZELKEYMASKSD", 17) == 0)
+      {
+        command_handled = true;
+        goertzel_key_mask_sd = strtol(&command[17], nullptr, 16) & GOERTZEL_KEY_MASK;
+        SEISMOMETER_PRINTF(SEISMOMETER_LOG_INFO, "Setting SD card Goertzel key mask '0x%lX'.\n", goertzel_key_mask_sd);
+      }
+      if(strncmp(command, "GOERTZELKEYMASKSTDOUT", 21) == 0)
+      {
+        command_handled = true;
+        goertzel_key_mask_stdio = strtol(&command[21], nullptr, 16) & GOERTZEL_KEY_MASK;
+        SEISMOMETER_PRINTF(SEISMOMETER_LOG_INFO, "Setting STDOUT Goertzel key mask '0x%lX'.\n", goertzel_key_mask_stdio);
+      }
+      break;
+    }
+    case 'L':
+    {
+      if(strncmp(command, "LATENCY", 7) == 0)
+      {
+        command_handled = true;
+        pipeline_latency_log(true, false);
+      }
+      break;
+    }
     case 'R':
     {
       if(strncmp(command, "REBOOT", 6) == 0)
@@ -275,6 +1279,7 @@ static void handle_stdin_command(char * command)
       if(strncmp(command, "SAMPLEKEYMASKSD", 15) == 0)
       {
         command_handled = true;
+        steim1_flush_all();
         sample_key_mask_sd = strtol(&command[15], nullptr, 16) & ((1<<SAMPLE_LOG_MAX_KEY)-1);
         SEISMOMETER_PRINTF(SEISMOMETER_LOG_INFO, "Setting SD card sample key mask '0x%lX'.\n", sample_key_mask_sd);
       }
@@ -284,6 +1289,52 @@ static void handle_stdin_command(char * command)
         sample_key_mask_stdio = strtol(&command[19], nullptr, 16) & ((1<<SAMPLE_LOG_MAX_KEY)-1);
         SEISMOMETER_PRINTF(SEISMOMETER_LOG_INFO, "Setting STDOUT sample key mask '0x%lX'.\n", sample_key_mask_stdio);
       }
+      if(strncmp(command, "SAMPLEFRAMES", 12) == 0)
+      {
+        command_handled = true;
+        sample_frames_enabled = (0 != strtol(&command[12], nullptr, 10));
+        SEISMOMETER_PRINTF(SEISMOMETER_LOG_INFO, "%s sample frames.\n", sample_frames_enabled ? "Enabling" : "Disabling");
+      }
+      if(strncmp(command, "SAMPLERATE", 10) == 0)
+      {
+        command_handled = true;
+        /* Stored in the EEPROM and applied by a reboot, every stage at the sample rate starts afresh */
+        sample_rate_set(strtol(&command[10], nullptr, 10));
+      }
+      if(strncmp(command, "SPECTRUMKEYMASKSD", 17) == 0)
+      {
+        command_handled = true;
+        spectrum_key_mask_sd = strtol(&command[17], nullptr, 16) & SPECTRUM_KEY_MASK;
+        SEISMOMETER_PRINTF(SEISMOMETER_LOG_INFO, "Setting SD card spectrum key mask '0x%lX'.\n", spectrum_key_mask_sd);
+      }
+      if(strncmp(command, "SPECTRUMKEYMASKSTDOUT", 21) == 0)
+      {
+        command_handled = true;
+        spectrum_key_mask_stdio = strtol(&command[21], nullptr, 16) & SPECTRUM_KEY_MASK;
+        SEISMOMETER_PRINTF(SEISMOMETER_LOG_INFO, "Setting STDOUT spectrum key mask '0x%lX'.\n", spectrum_key_mask_stdio);
+      }
+      if(strncmp(command, "SPECTRUMBANDS", 13) == 0)
+      {
+        command_handled = true;
+        spectrum_bands_enabled = (0 != strtol(&command[13], nullptr, 10));
+        SEISMOMETER_PRINTF(SEISMOMETER_LOG_INFO, "Logging spectra as %s.\n", spectrum_bands_enabled ? "octave bands" : "every bin");
+      }
+      if(strncmp(command, "SAMPLEFORMATSD", 14) == 0)
+      {
+        command_handled = true;
+        sample_file_format_e new_format = (sample_file_format_e) strtol(&command[14], nullptr, 10);
+        if(new_format < SAMPLE_FILE_FORMAT_MAX)
+        {
+          SEISMOMETER_PRINTF(SEISMOMETER_LOG_INFO, "Setting SD card sample format '%u'.\n", new_format);
+          /* A changed format closes the current file, it is reopened in the new format at the next RTC tick */
+          steim1_flush_all();
+          sample_file_set_format(new_format);
+        }
+        else
+        {
+          SEISMOMETER_PRINTF(SEISMOMETER_LOG_ERROR, "Invalid SD card sample format '%u'.\n", new_format);
+        }
+      }
       break;
     }
     case 'T':
@@ -341,6 +1392,32 @@ static void read_stdin()
 }
 
 
+void sample_handler_init()
+{
+  const sample_rate_e rate = sample_rate_get();
+  SEISMOMETER_PRINTF(SEISMOMETER_LOG_INFO, "Initializing sample handler at %luHz.\n", sample_rate_hz());
+  miniseed_nslc_init();
+  for(unsigned int channel = 0; channel < SPECTRUM_MAX; channel++)
+  {
+    spectrum[channel] = new spectrum_c(&spectrum_fft, SEISMOMETER_SPECTRUM_SEGMENTS, sample_rate_hz());
+  }
+  acceleration_goertzel = new goertzel_bank_c(ACCELERATION_FILTER_MAX, GOERTZEL_BIN_COUNT, goertzel_frequency_hz, sample_rate_hz(), sample_rate_hz());
+  pendulum_goertzel     = new goertzel_bank_c(1, GOERTZEL_BIN_COUNT, goertzel_frequency_hz, sample_rate_hz(), sample_rate_hz());
+  acceleration_filter.init(rate);
+  pendulum_filter.init(rate);
+  acceleration_fir_used = false;
+  for(unsigned int channel = 0; channel < ACCELERATION_FILTER_MAX; channel++)
+  {
+    acceleration_iir[channel] = sample_iir_filter_create(acceleration_goertzel_key[channel], rate);
+    acceleration_fir_used     = (acceleration_fir_used || (nullptr == acceleration_iir[channel]));
+  }
+  for(unsigned int channel = 0; channel < PENDULUM_FILTER_MAX; channel++)
+  {
+    pendulum_iir[channel] = sample_iir_filter_create(SAMPLE_LOG_PENDULUM_FILTERED, rate);
+  }
+  pendulum_decimate_init(rate);
+}
+
 void sample_handler(const seismometer_sample_s *sample)
 {
   SEISMOMETER_ASSERT(sample != nullptr);
@@ -349,7 +1426,7 @@ void sample_handler(const seismometer_sample_s *sample)
   {
     case SEISMOMETER_SAMPLE_TYPE_ACCELERATION:
     {
-      acceleration_sample_handler(sample);
+      acceleration_samples_handler(&sample, 1);
       break;
     }
     case SEISMOMETER_SAMPLE_TYPE_ACCELEROMETER_TEMPERATURE:
@@ -359,7 +1436,7 @@ void sample_handler(const seismometer_sample_s *sample)
     }
     case SEISMOMETER_SAMPLE_TYPE_PENDULUM:
     {
-      pendulum_sample_handler(sample);
+      pendulum_samples_handler(&sample, 1);
       break;
     }
     case SEISMOMETER_SAMPLE_TYPE_RTC_TICK:
@@ -374,29 +1451,7 @@ void sample_handler(const seismometer_sample_s *sample)
       to_us_since_boot(reference_time)/1000000, 
       to_us_since_boot(reference_time)%1000000);
 
-      if(error_state_check(ERROR_STATE_SD_SPI_0_NOT_MOUNTED))
-      {
-        sd_card_spi_mount(0);
-      }
-      if(!error_state_check(ERROR_STATE_SD_SPI_0_NOT_MOUNTED))
-      {
-        if(error_state_check(ERROR_STATE_SD_SPI_0_SAMPLE_FILE_ERROR))
-        {
-          sample_file_open();
-          if(error_state_check(ERROR_STATE_SD_SPI_0_SAMPLE_FILE_ERROR))
-          {
-            sample_file_close();
-            sd_card_spi_unmount(0);
-          }
-        }
-        else
-        {
-          if(FR_OK != f_sync(&sample_data_file))
-          {
-            sample_file_close();
-          }
-        }
-      }
+      sample_file_tick();
 
       error_state_mask_t error_state_mask = error_state_get();
       if(error_state_mask != 0) 
@@ -410,14 +1465,45 @@ void sample_handler(const seismometer_sample_s *sample)
     case SEISMOMETER_SAMPLE_TYPE_RTC_ALARM:
     {
       SEISMOMETER_PRINTF(SEISMOMETER_LOG_DEBUG, "RTC Alarm %u!\n", sample->alarm_index);
+      if(1 == sample->alarm_index)
+      {
+        sample_file_stats_s stats;
+        sample_file_get_stats(&stats);
+        SEISMOMETER_PRINTF(SEISMOMETER_LOG_INFO, "Sample file pending %lu (max %lu) dropped %lu/%lu stall %luus (max %luus, %lu over threshold)\n",
+          stats.bytes_pending, stats.bytes_pending_max, stats.bytes_dropped, stats.requests_dropped, stats.stall_us_last, stats.stall_us_max, stats.stall_count);
+        sampler_stats_s sampler_stats;
+        sampler_get_stats(&sampler_stats);
+        SEISMOMETER_PRINTF(SEISMOMETER_LOG_INFO, "Sample ring dropped samples %lu ticks %lu\n",
+          sampler_stats.sample_drop_count, sampler_stats.tick_drop_count);
+        clock_discipline_stats_s clock_stats;
+        clock_discipline_get_stats(&clock_stats);
+        SEISMOMETER_PRINTF(SEISMOMETER_LOG_INFO, "Clock frequency offset %ldppb phase error %ldus steps %lu\n",
+          clock_stats.frequency_offset_ppb, clock_stats.phase_error_us, clock_stats.step_count);
+#if SEISMOMETER_MPU_6500_FIFO
+        mpu_6500_fifo_stats_s fifo_stats;
+        mpu_6500_get_fifo_stats(&fifo_stats);
+        SEISMOMETER_PRINTF(SEISMOMETER_LOG_INFO, "MPU-6500 FIFO bursts %lu frames %lu overflows %lu\n",
+          fifo_stats.burst_count, fifo_stats.frame_count, fifo_stats.overflow_count);
+#endif
+#if SEISMOMETER_ADC_DMA
+        adc_manager_stats_s adc_stats;
+        adc_manager_get_stats(&adc_stats);
+        SEISMOMETER_PRINTF(SEISMOMETER_LOG_INFO, "ADC windows %lu held %lu caught up %lu\n",
+          adc_stats.window_count, adc_stats.hold_count, adc_stats.catch_up_count);
+#endif
+        seismometer_i2c_stats_s i2c_stats;
+        seismometer_i2c_get_stats(&i2c0_handle, &i2c_stats);
+        SEISMOMETER_PRINTF(SEISMOMETER_LOG_INFO, "I2C transactions %lu errors %lu max wait sensor %lu timing %lu housekeeping %lu us\n",
+          i2c_stats.transaction_count, i2c_stats.error_count,
+          i2c_stats.max_wait_us[SEISMOMETER_I2C_PRIORITY_SENSOR], i2c_stats.max_wait_us[SEISMOMETER_I2C_PRIORITY_TIMING],
+          i2c_stats.max_wait_us[SEISMOMETER_I2C_PRIORITY_HOUSEKEEPING]);
+        pipeline_latency_log(false, true);
+      }
       if(2 == sample->alarm_index)
       {
-        /* Close current file and reopen with new date-stamp */
-        sample_file_close();
-        #ifdef ENABLE_ZLIB_DATA_FILE_COMPRESSION
-        sd_card_spi_compress_file(sample_file_filename);
-        #endif
-        sample_file_open();
+        /* Close current file and reopen with new date-stamp, done by the sample file writer */
+        steim1_flush_all();
+        sample_file_rollover();
       }
 //      SEISMOMETER_ASSERT(sample->alarm_index != 1);
       break;
@@ -435,4 +1521,123 @@ void sample_handler(const seismometer_sample_s *sample)
       break;
     }
   }
+}
+
+/* Handles the run of 'count' acceleration, pendulum and temperature samples from 'samples', the acceleration and
+   pendulum samples are filtered as blocks then every sample is logged in ring order so file records stay in
+   timestamp order */
+static void sample_handler_batch_flush(const seismometer_sample_s *samples, size_t count,
+                                       const seismometer_sample_s **acceleration, size_t *acceleration_count,
+                                       const seismometer_sample_s **pendulum,     size_t *pendulum_count)
+{
+  if(*acceleration_count > 0)
+  {
+    acceleration_samples_filter(acceleration, *acceleration_count);
+  }
+  if(*pendulum_count > 0)
+  {
+    pendulum_samples_filter(pendulum, *pendulum_count);
+  }
+
+  size_t acceleration_index = 0;
+  size_t pendulum_index     = 0;
+  for(size_t i = 0; i < count; i++)
+  {
+    switch(samples[i].type)
+    {
+      case SEISMOMETER_SAMPLE_TYPE_ACCELERATION:
+      {
+        acceleration_sample_log(&samples[i], acceleration_index++);
+        break;
+      }
+      case SEISMOMETER_SAMPLE_TYPE_PENDULUM:
+      {
+        pendulum_sample_log(&samples[i], pendulum_index++);
+        break;
+      }
+      case SEISMOMETER_SAMPLE_TYPE_ACCELEROMETER_TEMPERATURE:
+      {
+        accelerometer_temperature_sample_handler(&samples[i]);
+        break;
+      }
+      default:
+      {
+        SEISMOMETER_ASSERT(0);
+        break;
+      }
+    }
+  }
+  SEISMOMETER_ASSERT(acceleration_index == *acceleration_count);
+  SEISMOMETER_ASSERT(pendulum_index     == *pendulum_count);
+  *acceleration_count = 0;
+  *pendulum_count     = 0;
+}
+
+void sample_handler_batch(const seismometer_sample_s *samples, size_t count)
+{
+  SEISMOMETER_ASSERT(samples != nullptr);
+
+  /* Every sample timer tick commits one pendulum sample, its latency stands for the tick */
+  const uint32_t dequeue_us = time_us_32();
+  for(size_t i = 0; i < count; i++)
+  {
+    if(SEISMOMETER_SAMPLE_TYPE_PENDULUM == samples[i].type)
+    {
+      pipeline_latency_record(PIPELINE_LATENCY_DEQUEUE, (dequeue_us-pipeline_latency_fire_us(samples[i].index)));
+    }
+  }
+
+  const seismometer_sample_s *acceleration[SEISMOMETER_SAMPLE_HANDLER_BATCH_SIZE];
+  const seismometer_sample_s *pendulum    [SEISMOMETER_SAMPLE_HANDLER_BATCH_SIZE];
+  size_t acceleration_count = 0;
+  size_t pendulum_count     = 0;
+  size_t run_start          = 0;
+  for(size_t i = 0; i < count; i++)
+  {
+    switch(samples[i].type)
+    {
+      case SEISMOMETER_SAMPLE_TYPE_ACCELERATION:
+      {
+        acceleration[acceleration_count++] = &samples[i];
+        break;
+      }
+      case SEISMOMETER_SAMPLE_TYPE_PENDULUM:
+      {
+        pendulum[pendulum_count++] = &samples[i];
+        break;
+      }
+      case SEISMOMETER_SAMPLE_TYPE_ACCELEROMETER_TEMPERATURE:
+      {
+        /* Logged in order with the run */
+        break;
+      }
+      default:
+      {
+        /* Ticks and events apply to the samples before them */
+        sample_handler_batch_flush(&samples[run_start], (i-run_start), acceleration, &acceleration_count, pendulum, &pendulum_count);
+        sample_handler(&samples[i]);
+        run_start = (i+1);
+        break;
+      }
+    }
+
+    if((SEISMOMETER_SAMPLE_HANDLER_BATCH_SIZE == acceleration_count) || (SEISMOMETER_SAMPLE_HANDLER_BATCH_SIZE == pendulum_count))
+    {
+      sample_handler_batch_flush(&samples[run_start], ((i+1)-run_start), acceleration, &acceleration_count, pendulum, &pendulum_count);
+      run_start = (i+1);
+    }
+  }
+  sample_handler_batch_flush(&samples[run_start], (count-run_start), acceleration, &acceleration_count, pendulum, &pendulum_count);
+
+  /* Spectra are transformed between batches, outside the per sample filtering */
+  spectrum_process_all();
+
+  const uint32_t handled_us = time_us_32();
+  for(size_t i = 0; i < count; i++)
+  {
+    if(SEISMOMETER_SAMPLE_TYPE_PENDULUM == samples[i].type)
+    {
+      pipeline_latency_record(PIPELINE_LATENCY_HANDLED, (handled_us-pipeline_latency_fire_us(samples[i].index)));
+    }
+  }
 }
\ No newline at end of file
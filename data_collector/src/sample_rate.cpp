@@ -0,0 +1,91 @@
+#include <cassert>
+
+#include "sample_rate.hpp"
+#include "seismometer_config.hpp"
+#include "seismometer_debug.hpp"
+#include "seismometer_eeprom.hpp"
+#include "seismometer_utils.hpp"
+
+static const uint16_t sample_rate_table_hz[SAMPLE_RATE_MAX] =
+{
+  50,  /* SAMPLE_RATE_50HZ  */
+  100, /* SAMPLE_RATE_100HZ */
+  200, /* SAMPLE_RATE_200HZ */
+  500, /* SAMPLE_RATE_500HZ */
+};
+
+static sample_rate_e sample_rate        = SAMPLE_RATE_MAX;
+static uint32_t      sample_rate_period = 0;
+
+/* Returns the rate of 'hz', SAMPLE_RATE_MAX if it is not supported */
+static sample_rate_e sample_rate_from_hz(uint32_t hz)
+{
+  sample_rate_e ret_val = SAMPLE_RATE_MAX;
+  for(unsigned int rate = 0; rate < SAMPLE_RATE_MAX; rate++)
+  {
+    if(hz == sample_rate_table_hz[rate])
+    {
+      ret_val = (sample_rate_e) rate;
+      break;
+    }
+  }
+  return ret_val;
+}
+
+void sample_rate_init()
+{
+  const uint32_t stored_hz = eeprom_get_sampler_config()->sample_rate_hz;
+  sample_rate = sample_rate_from_hz(stored_hz);
+  if(SAMPLE_RATE_MAX == sample_rate)
+  {
+    SEISMOMETER_PRINTF(SEISMOMETER_LOG_ERROR, "Unsupported sample rate %luHz in EEPROM, using %uHz.\n", stored_hz, SEISMOMETER_SAMPLE_RATE_DEFAULT);
+    sample_rate = sample_rate_from_hz(SEISMOMETER_SAMPLE_RATE_DEFAULT);
+    SEISMOMETER_ASSERT(sample_rate < SAMPLE_RATE_MAX);
+  }
+  sample_rate_period = ((1000*1000)/sample_rate_table_hz[sample_rate]);
+  SEISMOMETER_PRINTF(SEISMOMETER_LOG_INFO, "Sample rate %uHz, %luus period.\n", sample_rate_table_hz[sample_rate], sample_rate_period);
+}
+
+bool sample_rate_set(uint32_t hz)
+{
+  bool ret_val = true;
+  const sample_rate_e new_rate = sample_rate_from_hz(hz);
+  if(SAMPLE_RATE_MAX == new_rate)
+  {
+    SEISMOMETER_PRINTF(SEISMOMETER_LOG_ERROR, "Unsupported sample rate %luHz.\n", hz);
+    ret_val = false;
+  }
+  else if(new_rate == sample_rate)
+  {
+    SEISMOMETER_PRINTF(SEISMOMETER_LOG_INFO, "Already sampling at %luHz.\n", hz);
+  }
+  else
+  {
+    SEISMOMETER_PRINTF(SEISMOMETER_LOG_INFO, "Setting sample rate %luHz, applied at reboot.\n", hz);
+    const seismometer_eeprom_sampler_config_s new_config =
+    {
+      .sample_rate_hz = sample_rate_table_hz[new_rate],
+    };
+    ret_val = eeprom_set_sampler_config(&new_config);
+    if(ret_val)
+    {
+      seismometer_force_reboot();
+    }
+  }
+  return ret_val;
+}
+
+sample_rate_e sample_rate_get()
+{
+  return sample_rate;
+}
+
+uint32_t __time_critical_func(sample_rate_hz)()
+{
+  return sample_rate_table_hz[sample_rate];
+}
+
+uint32_t __time_critical_func(sample_rate_period_us)()
+{
+  return sample_rate_period;
+}
\ No newline at end of file
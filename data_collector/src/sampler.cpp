@@ -9,30 +9,21 @@
 #include "adc_manager.hpp"
 #include "rtc_ds3231.hpp"
 #include "mpu-6500.hpp"
+#include "pipeline_latency.hpp"
+#include "sample_file.hpp"
+#include "sample_rate.hpp"
 #include "sampler.hpp"
+#include "seismometer_config.hpp"
 #include "seismometer_debug.hpp"
+#include "seismometer_i2c.hpp"
 #include "seismometer_utils.hpp"
 
 static sample_thread_args_s *args_ptr     = nullptr;
 static __scratch_y("sampler_thread_data") repeating_timer_t sample_timer = {0};
-#define SAMPLE_TRIGGER_QUEUE_SIZE 2
-typedef enum
-{
-  SAMPLE_TRIGGER_INVALID,
-  SAMPLE_TRIGGER_SAMPLE_PERIOD,
-  SAMPLE_TRIGGER_RTC_TICK,
-  SAMPLE_TRIGGER_MAX
-} sample_trigger_e;
-typedef struct 
-{
-  sample_trigger_e trigger;
-
-  union 
-  {
-    absolute_time_t timestamp;
-  };
-} sample_trigger_s;
-static queue_t __scratch_y("sampler_thread_data") sample_trigger_queue = {0};
+/* Sampling runs from interrupts on core 1 so the core 1 thread is free to run the sample file writer */
+static alarm_pool_t *sample_alarm_pool = nullptr;
+static sample_index_t __scratch_y("sampler_thread_data") sample_index = 0;
+static sampler_stats_s sampler_stats = {0};
 
 void sampler_thread_pass_args(sample_thread_args_s *args)
 {
@@ -40,56 +31,71 @@ void sampler_thread_pass_args(sample_thread_args_s *args)
   args_ptr = args;
 }
 
-static bool __isr __time_critical_func(sample_timer_callback)(repeating_timer_t *rt)
-{
-  smps_control_force_pwm(SMPS_CONTROL_CLIENT_SAMPLER);
-  sample_trigger_s sample_trigger = {.trigger=SAMPLE_TRIGGER_SAMPLE_PERIOD};
-
-  if(!queue_try_add((queue_t*) rt->user_data, &sample_trigger))
-  {
-    SEISMOMETER_PRINTF(SEISMOMETER_LOG_WARNING, "PERIODIC SAMPLE DROP!\n");
-  }
-
-  return true; /*true to continue repeating, false to stop.*/
-}
-
-static void __time_critical_func(sample_mpu_6500)(sample_index_t index, const absolute_time_t *time)
+static void __time_critical_func(sample_mpu_6500)(sample_index_t index, const absolute_time_t *time,
+                                                  seismometer_sample_s *temperature_sample, seismometer_sample_s *acceleration_sample)
 {
   /* Sample sensor temperature */
-  seismometer_sample_s temperature_sample; 
-  memset(&temperature_sample, 0, sizeof(seismometer_sample_s));
-  temperature_sample.type  = SEISMOMETER_SAMPLE_TYPE_ACCELEROMETER_TEMPERATURE;
-  temperature_sample.index = index;
-  temperature_sample.time  = *time;
-  temperature_sample.temperature = mpu_6500_temperature_to_m_celsius(mpu_6500_temperature());
-  SEISMOMETER_ASSERT_CALL(queue_try_add(args_ptr->sample_queue, &temperature_sample));
+  memset(temperature_sample, 0, sizeof(seismometer_sample_s));
+  temperature_sample->type  = SEISMOMETER_SAMPLE_TYPE_ACCELEROMETER_TEMPERATURE;
+  temperature_sample->index = index;
+  temperature_sample->time  = *time;
+  temperature_sample->temperature = mpu_6500_temperature_to_m_celsius(mpu_6500_temperature());
 
   /* Sample acceleration */
   mpu_6500_accelerometer_data_s accelerometer_data;
   mpu_6500_accelerometer_data(&accelerometer_data);
-  seismometer_sample_s acceleration_sample; 
-  memset(&acceleration_sample, 0, sizeof(seismometer_sample_s));
-  acceleration_sample.type  = SEISMOMETER_SAMPLE_TYPE_ACCELERATION;
-  acceleration_sample.index = index;
-  acceleration_sample.time  = *time;
-  acceleration_sample.acceleration.x = mpu_6500_acceleration_to_mm_ps2(accelerometer_data.x);
-  acceleration_sample.acceleration.y = mpu_6500_acceleration_to_mm_ps2(accelerometer_data.y);
-  acceleration_sample.acceleration.z = mpu_6500_acceleration_to_mm_ps2(accelerometer_data.z);
-  SEISMOMETER_ASSERT_CALL(queue_try_add(args_ptr->sample_queue, &acceleration_sample));
+  memset(acceleration_sample, 0, sizeof(seismometer_sample_s));
+  acceleration_sample->type  = SEISMOMETER_SAMPLE_TYPE_ACCELERATION;
+  acceleration_sample->index = index;
+  acceleration_sample->time  = *time;
+  acceleration_sample->acceleration.x = mpu_6500_acceleration_to_mm_ps2(accelerometer_data.x);
+  acceleration_sample->acceleration.y = mpu_6500_acceleration_to_mm_ps2(accelerometer_data.y);
+  acceleration_sample->acceleration.z = mpu_6500_acceleration_to_mm_ps2(accelerometer_data.z);
 }
 
-static void __time_critical_func(sample_pendulum)(sample_index_t index, const absolute_time_t *time)
+static void __time_critical_func(sample_pendulum)(sample_index_t index, const absolute_time_t *time, seismometer_sample_s *sample)
 {
   /* Sample Pendulum Voltage */
-  seismometer_sample_s sample; 
-  memset(&sample, 0, sizeof(seismometer_sample_s));
-  sample.type  = SEISMOMETER_SAMPLE_TYPE_PENDULUM;
-  sample.index = index;
-  sample.time  = *time;
+  memset(sample, 0, sizeof(seismometer_sample_s));
+  sample->type  = SEISMOMETER_SAMPLE_TYPE_PENDULUM;
+  sample->index = index;
+  sample->time  = *time;
 
-  sample.pendulum.x10  = adc_manager_get_sample_mv(ADC_CH_PENDULUM_10X);
-  sample.pendulum.x100 = adc_manager_get_sample_mv(ADC_CH_PENDULUM_100X);
-  SEISMOMETER_ASSERT_CALL(queue_try_add(args_ptr->sample_queue, &sample));
+  sample->pendulum.x10  = adc_manager_get_sample_mv(ADC_CH_PENDULUM_10X);
+  sample->pendulum.x100 = adc_manager_get_sample_mv(ADC_CH_PENDULUM_100X);
+}
+
+static bool __isr __time_critical_func(sample_timer_callback)(repeating_timer_t *rt)
+{
+  const uint32_t fire_us = pipeline_latency_timer_fire(sample_index);
+  smps_control_force_pwm(SMPS_CONTROL_CLIENT_SAMPLER);
+
+  /* Read from sensors */
+  const uint32_t  adc_manager_start_us  = time_us_32();
+  absolute_time_t adc_manager_read_time = adc_manager_read();
+  const uint32_t  mpu_6500_start_us     = time_us_32();
+  absolute_time_t mpu_6500_read_time    = mpu_6500_read();
+  const uint32_t  mpu_6500_end_us       = time_us_32();
+  smps_control_power_save(SMPS_CONTROL_CLIENT_SAMPLER);
+  pipeline_latency_record(PIPELINE_LATENCY_ADC_READ, (mpu_6500_start_us-adc_manager_start_us));
+  pipeline_latency_record(PIPELINE_LATENCY_MPU_READ, (mpu_6500_end_us-mpu_6500_start_us));
+
+  /* Build samples in place and commit them together, the tick is dropped if core 0 has fallen behind */
+  if(args_ptr->sample_ring->reserve(3))
+  {
+    sample_mpu_6500(sample_index, &mpu_6500_read_time, args_ptr->sample_ring->get_reserved(0), args_ptr->sample_ring->get_reserved(1));
+    sample_pendulum(sample_index, &adc_manager_read_time, args_ptr->sample_ring->get_reserved(2));
+    args_ptr->sample_ring->commit(3);
+    pipeline_latency_record(PIPELINE_LATENCY_ENQUEUE, (time_us_32()-fire_us));
+  }
+  else
+  {
+    sampler_stats.sample_drop_count++;
+  }
+
+  sample_index++;
+
+  return true; /*true to continue repeating, false to stop.*/
 }
 
 static void __time_critical_func(rtc_alarm_cb)(void* user_data_ptr)
@@ -98,10 +104,32 @@ static void __time_critical_func(rtc_alarm_cb)(void* user_data_ptr)
   memset(&sample, 0, sizeof(seismometer_sample_s));
   sample.type        = SEISMOMETER_SAMPLE_TYPE_RTC_ALARM;
   sample.alarm_index = ((unsigned int) user_data_ptr);
-  SEISMOMETER_ASSERT_CALL(queue_try_add(args_ptr->sample_queue, &sample));
+  /* Called in the ring producer context, the index records the ring position so the main loop handles the alarm
+     after the samples committed before it, e.g. the file rollover on alarm 2 */
+  sample.index       = args_ptr->sample_ring->get_committed();
+  SEISMOMETER_ASSERT_CALL(queue_try_add(args_ptr->event_queue, &sample));
+}
+
+static void __time_critical_func(rtc_tick_cb)(absolute_time_t reference, void* user_data_ptr)
+{
+  /* Called once the RTC read completes in the I2C interrupt, same priority as the sample timer so the ring keeps a
+     single producer */
+  if(args_ptr->sample_ring->reserve(1))
+  {
+    seismometer_sample_s *sample = args_ptr->sample_ring->get_reserved(0);
+    memset(sample, 0, sizeof(seismometer_sample_s));
+    sample->type = SEISMOMETER_SAMPLE_TYPE_RTC_TICK;
+    sample->time = reference;
+    args_ptr->sample_ring->commit(1);
+  }
+  else
+  {
+    sampler_stats.tick_drop_count++;
+  }
 }
 
-#define RTC_INTERRUPT_PIN 22
+#define RTC_INTERRUPT_PIN      22
+#define MPU_6500_INTERRUPT_PIN 21
 static void __isr __time_critical_func(gpio_irq_callback)(uint gpio, uint32_t event_mask)
 {
   switch(gpio)
@@ -109,17 +137,19 @@ static void __isr __time_critical_func(gpio_irq_callback)(uint gpio, uint32_t ev
     case RTC_INTERRUPT_PIN:
     {
       SEISMOMETER_ASSERT(event_mask == GPIO_IRQ_EDGE_RISE);
-      sample_trigger_s sample_trigger = 
-      {
-        .trigger  =SAMPLE_TRIGGER_RTC_TICK,
-        .timestamp=get_absolute_time(),
-      };
-      if(!queue_try_add(&sample_trigger_queue, &sample_trigger))
-      {
-        SEISMOMETER_PRINTF(SEISMOMETER_LOG_WARNING, "RTC TICK SAMPLE DROP!\n");
-      }
+      /* Timestamp the tick now, the RTC_TICK sample is pushed by rtc_tick_cb() once the read completes */
+      rtc_ds3231_read(get_absolute_time());
       break;
     }
+#if SEISMOMETER_MPU_6500_FIFO
+    case MPU_6500_INTERRUPT_PIN:
+    {
+      SEISMOMETER_ASSERT(event_mask == GPIO_IRQ_EDGE_RISE);
+      /* Same interrupt priority as the sample timer so the latest decimated sample is never read part written */
+      mpu_6500_fifo_interrupt(get_absolute_time());
+      break;
+    }
+#endif
     default:
     {
       SEISMOMETER_PRINTF(SEISMOMETER_LOG_ERROR, "Unexpected interrupt for GPIO %u with event mask 0x%x", gpio, event_mask);
@@ -130,15 +160,20 @@ static void __isr __time_critical_func(gpio_irq_callback)(uint gpio, uint32_t ev
 
 void __time_critical_func(sampler_thread_main)()
 {
-  SEISMOMETER_PRINTF(SEISMOMETER_LOG_INFO, "Initializing sample trigger queue.\n");
-  queue_init(&sample_trigger_queue, sizeof(sample_trigger_s), SAMPLE_TRIGGER_QUEUE_SIZE);
+  /* Alarm pool on core 1 so the sample timer interrupt is serviced on this core */
+  SEISMOMETER_PRINTF(SEISMOMETER_LOG_INFO, "Initializing sample alarm pool.\n");
+  sample_alarm_pool = alarm_pool_create(SEISMOMETER_SAMPLE_ALARM_NUM, 1);
+  /* I2C completions on core 1 alongside the sample timer and GPIO interrupts */
+  SEISMOMETER_PRINTF(SEISMOMETER_LOG_INFO, "Enabling I2C interrupts.\n");
+  seismometer_i2c_enable_irq(&i2c0_handle);
 
   /* Initialize the built in RTC */
   rtc_init();
 //  rtc_ds3231_set(1678047615);
-  rtc_ds3231_read(get_absolute_time());
+  rtc_ds3231_read_blocking(get_absolute_time());
   rtc_ds3231_set_alarm1_cb(rtc_alarm_cb, (void*)1);
   rtc_ds3231_set_alarm2_cb(rtc_alarm_cb, (void*)2);
+  rtc_ds3231_set_tick_cb(rtc_tick_cb, nullptr);
 
   /* Initialize GPIO interrupts */
   gpio_set_irq_callback(gpio_irq_callback);
@@ -147,56 +182,42 @@ void __time_critical_func(sampler_thread_main)()
   gpio_set_dir(RTC_INTERRUPT_PIN, false);
   gpio_pull_up(RTC_INTERRUPT_PIN);
   gpio_set_irq_enabled(RTC_INTERRUPT_PIN, GPIO_IRQ_EDGE_RISE, true);
+#if SEISMOMETER_MPU_6500_FIFO
+  /* MPU-6500 Interrupt, data ready at the FIFO sample rate */
+  gpio_init(MPU_6500_INTERRUPT_PIN);
+  gpio_set_dir(MPU_6500_INTERRUPT_PIN, false);
+  gpio_pull_down(MPU_6500_INTERRUPT_PIN);
+  gpio_set_irq_enabled(MPU_6500_INTERRUPT_PIN, GPIO_IRQ_EDGE_RISE, true);
+#endif
 
   /* Sampler task initial setup complete, allow logging task to finish setup */
   sem_release(args_ptr->boot_semaphore);
   /* Do not start sampling until unblocked by logging task */
   sem_acquire_blocking(args_ptr->boot_semaphore);
-  SEISMOMETER_PRINTF(SEISMOMETER_LOG_INFO, "Starting sample timer.\n");
-  SEISMOMETER_ASSERT_CALL(add_repeating_timer_us(-SEISMOMETER_SAMPLE_PERIOD_US, sample_timer_callback, &sample_trigger_queue, &sample_timer));
+#if SEISMOMETER_ADC_DMA
+  SEISMOMETER_PRINTF(SEISMOMETER_LOG_INFO, "Starting ADC conversions.\n");
+  adc_manager_start();
+  /* First tick once the CIC filter has filled, and half a sample period after each window completes so interrupt
+     latency never leaves a tick without one */
+  busy_wait_us((SEISMOMETER_ADC_CIC_ORDER*sample_rate_period_us())-(sample_rate_period_us()/2));
+#endif
+  SEISMOMETER_PRINTF(SEISMOMETER_LOG_INFO, "Starting sample timer at %luHz.\n", sample_rate_hz());
+  /* A negative delay schedules every fire a fixed period after the previous scheduled fire */
+  pipeline_latency_timer_start(delayed_by_us(get_absolute_time(), sample_rate_period_us()), sample_index, sample_rate_period_us());
+  SEISMOMETER_ASSERT_CALL(alarm_pool_add_repeating_timer_us(sample_alarm_pool, -((int64_t)sample_rate_period_us()), sample_timer_callback, nullptr, &sample_timer));
+#if SEISMOMETER_MPU_6500_FIFO
+  SEISMOMETER_PRINTF(SEISMOMETER_LOG_INFO, "Starting MPU-6500 FIFO.\n");
+  mpu_6500_fifo_start();
+#endif
   SEISMOMETER_PRINTF(SEISMOMETER_LOG_INFO, "Enabling sampler GPIO interrupts.\n");
   irq_set_enabled(IO_IRQ_BANK0, true);
- 
-  sample_index_t sample_index = 0;
-  while (1)
-  {
-    /* Wait for sample trigger */
-    sample_trigger_s sample_trigger;
-    queue_remove_blocking(&sample_trigger_queue, &sample_trigger);
 
-    switch(sample_trigger.trigger)
-    {
-      case SAMPLE_TRIGGER_SAMPLE_PERIOD:
-      {
-        /* Read from sensors */
-        absolute_time_t adc_manager_read_time = get_absolute_time();
-        adc_manager_read();
-        absolute_time_t mpu_6500_read_time    = get_absolute_time();
-        mpu_6500_read();
-        smps_control_power_save(SMPS_CONTROL_CLIENT_SAMPLER);
-
-        /* Commit samples */
-        sample_mpu_6500(sample_index, &mpu_6500_read_time);
-        sample_pendulum(sample_index, &adc_manager_read_time);
-
-        sample_index++;
-        break;
-      }
-      case SAMPLE_TRIGGER_RTC_TICK:
-      {
-        rtc_ds3231_read(sample_trigger.timestamp);
-        seismometer_sample_s sample; 
-        memset(&sample, 0, sizeof(seismometer_sample_s));
-        sample.type = SEISMOMETER_SAMPLE_TYPE_RTC_TICK;
-        sample.time = sample_trigger.timestamp;
-        SEISMOMETER_ASSERT_CALL(queue_try_add(args_ptr->sample_queue, &sample));
-        break;
-      }
-      default:
-      {
-        SEISMOMETER_PRINTF(SEISMOMETER_LOG_ERROR, "Unexpected sample trigger %u\n", sample_trigger.trigger);
-        SEISMOMETER_ASSERT(0);
-      }
-    }
-  }
+  /* Samples are taken in interrupt context, this thread writes the sample data file */
+  sample_file_writer_main();
+}
+
+void sampler_get_stats(sampler_stats_s *stats)
+{
+  SEISMOMETER_ASSERT(stats != nullptr);
+  *stats = sampler_stats;
 }
\ No newline at end of file
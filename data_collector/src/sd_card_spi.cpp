@@ -129,7 +129,6 @@ bool sd_card_spi_unmount(const unsigned int sd_index)
 
 #ifdef ENABLE_ZLIB_DATA_FILE_COMPRESSION
 #define SEISMOMETER_ZLIB_CHUNK_SIZE        8192
-#define SEISMOMETER_ZLIB_COMPRESSION_LEVEL 2
 /* deflate memory usage (bytes) = (1 << (windowBits+2)) + (1 << (memLevel+9)) + 6 KB */
 /* From zlib manual:
     The windowBits parameter is the base two logarithm of the window size (the size of the history buffer). It should be in the range 8..15 for this version of the library. Larger values of this parameter result in better compression at the expense of memory usage. The default value is 15 if deflateInit is used instead.
@@ -150,7 +149,7 @@ bool compress_file_zlib(FIL *source_file, FIL *compressed_file)
   strm.zalloc = Z_NULL;
   strm.zfree = Z_NULL;
   strm.opaque = Z_NULL;
-  int ret = deflateInit2(&strm, SEISMOMETER_ZLIB_COMPRESSION_LEVEL, Z_DEFLATED, 9, 2, Z_DEFAULT_STRATEGY);
+  int ret = deflateInit2(&strm, SEISMOMETER_ZLIB_COMPRESSION_LEVEL, Z_DEFLATED, SEISMOMETER_ZLIB_DEFLATE_WINDOW_BITS, SEISMOMETER_ZLIB_DEFLATE_MEM_LEVEL, Z_DEFAULT_STRATEGY);
   if(Z_OK != ret)
   {
     SEISMOMETER_PRINTF(SEISMOMETER_LOG_ERROR, "Error (%d) initializing deflate stream.\n", ret);
@@ -215,8 +214,6 @@ bool compress_file_zlib(FIL *source_file, FIL *compressed_file)
 }
 
 #define COMPRESSED_FILE_FILENAME_MAX_LENGTH       256
-#define COMPRESSED_FILE_FILENAME_EXTENSION_LENGTH 3 /* includes '.' seperator */
-#define COMPRESSED_FILE_FILENAME_FORMAT           "%s.gz"
 bool sd_card_spi_compress_file(const char* source_filename)
 {
   bool ret_val = true;
@@ -12,8 +12,11 @@
 
 #include "mpu-6500.hpp"
 #include "adc_manager.hpp"
+#include "event_capture.hpp"
 #include "rtc_ds3231.hpp"
+#include "sample_file.hpp"
 #include "sample_handler.hpp"
+#include "sample_rate.hpp"
 #include "sampler.hpp"
 #include "sd_card_spi.hpp"
 #include "seismometer_config.hpp"
@@ -126,29 +129,17 @@ void static i2c_init(seismometer_i2c_handle_s *i2c_handle, i2c_inst_t * i2c, uin
   SEISMOMETER_ASSERT(i2c        != nullptr);
   SEISMOMETER_ASSERT(i2c_handle != nullptr);
 
-  i2c_handle->i2c_inst = i2c;
-  mutex_init(&i2c_handle->mutex);
-
   i2c_init(i2c, baud);
   gpio_set_function(sda_pin, GPIO_FUNC_I2C);
   gpio_set_function(scl_pin, GPIO_FUNC_I2C);
   gpio_pull_up(sda_pin);
   gpio_pull_up(scl_pin);
-}
-bool __time_critical_func(seismometer_i2c_lock)(seismometer_i2c_handle_s* i2c_handle) 
-{  
-  SEISMOMETER_ASSERT(i2c_handle != nullptr);
-  mutex_enter_blocking(&i2c_handle->mutex); 
-  return true;
-};
-bool __time_critical_func(seismometer_i2c_unlock)(seismometer_i2c_handle_s* i2c_handle)
-{
-  SEISMOMETER_ASSERT(i2c_handle != nullptr);
-  mutex_exit(&i2c_handle->mutex);
-  return true;
+  seismometer_i2c_init(i2c_handle, i2c);
 }
 
-static queue_t sample_queue = {0};
+static sample_ring_c sample_ring;
+/* Slow path for events from other producers */
+static queue_t event_queue = {0};
 semaphore_t stdio_char_available_ack;
 static void __isr stdio_char_available_cb(void* user_data)
 {
@@ -159,7 +150,7 @@ static void __isr stdio_char_available_cb(void* user_data)
       .type      = SEISMOMETER_SAMPLE_TYPE_STDIO_CHAR_AVAILABLE,
       .semaphore = &stdio_char_available_ack,
     };
-    queue_add_blocking(&sample_queue, &sample);
+    queue_add_blocking(&event_queue, &sample);
   }
 }
 
@@ -199,6 +190,8 @@ void boot()
   watchdog_update();
   eeprom_init(&i2c0_handle);
   watchdog_update();
+  sample_rate_init();
+  watchdog_update();
   error_state_init();
   watchdog_update();
   smps_control_init();
@@ -215,14 +208,21 @@ void boot()
   watchdog_update();
   adc_manager_init(ADC_CH_TO_MASK(ADC_CH_PENDULUM_10X) | ADC_CH_TO_MASK(ADC_CH_PENDULUM_100X));
   watchdog_update();
-  SEISMOMETER_PRINTF(SEISMOMETER_LOG_INFO, "Initializing sample queue\n");
-  queue_init(&sample_queue, sizeof(seismometer_sample_s), SEISMOMETER_SAMPLE_QUEUE_SIZE);
+  sample_file_init();
+  watchdog_update();
+  event_capture_init();
+  watchdog_update();
+  sample_handler_init();
+  watchdog_update();
+  SEISMOMETER_PRINTF(SEISMOMETER_LOG_INFO, "Initializing event queue\n");
+  queue_init(&event_queue, sizeof(seismometer_sample_s), SEISMOMETER_EVENT_QUEUE_SIZE);
   watchdog_update();
   SEISMOMETER_PRINTF(SEISMOMETER_LOG_INFO, "Starting sampler thread.\n");
   semaphore_t boot_semaphore = {0};
   sem_init(&boot_semaphore, 0, 1);
   sampler_thead_args.boot_semaphore = &boot_semaphore;
-  sampler_thead_args.sample_queue   = &sample_queue;
+  sampler_thead_args.sample_ring    = &sample_ring;
+  sampler_thead_args.event_queue    = &event_queue;
   sampler_thread_pass_args(&sampler_thead_args);
   multicore_launch_core1(sampler_thread_main);
   /* Block until inital sampler task setup is complete */
@@ -258,17 +258,40 @@ int main()
     /* Handle Error State */
     error_state_mask_t error_state = error_state_get();
     status_led_update(error_state==0);
-    /* Pop from Sample Queue*/
-    seismometer_sample_s sample;
-    unsigned int queue_length = queue_get_level(&sample_queue);
+    /* Handle samples in place in the sample ring */
+    unsigned int queue_length = sample_ring.get_level();
     if(queue_length >= (3*SEISMOMETER_SAMPLE_QUEUE_SIZE/4))
     {
       SEISMOMETER_PRINTF(SEISMOMETER_LOG_INFO, "%u - Queue length %u\n", to_ms_since_boot(get_absolute_time()), queue_length);
     }
-    queue_remove_blocking(&sample_queue, &sample);
+    seismometer_sample_s event;
+    bool event_available = queue_try_peek(&event_queue, &event);
+    const seismometer_sample_s *samples;
+    uint32_t sample_count = sample_ring.peek(&samples);
+    if(event_available && (SEISMOMETER_SAMPLE_TYPE_RTC_ALARM == event.type))
+    {
+      /* Alarms carry the ring position they were raised at, only handle the samples before it.  The position may
+         already be released where the ring was drained before the alarm was queued */
+      int32_t  event_distance       = (int32_t)(event.index - sample_ring.get_released());
+      uint32_t samples_before_event = ((event_distance > 0) ? (uint32_t)event_distance : 0);
+      sample_count    = SEISMOMETER_MIN(sample_count, samples_before_event);
+      event_available = (sample_count == samples_before_event);
+    }
+    sample_handler_batch(samples, sample_count);
+    sample_ring.release(sample_count);
+
+    /* Handle one event, once the ring samples ordered before it are handled */
+    if(event_available)
+    {
+      SEISMOMETER_ASSERT_CALL(queue_try_remove(&event_queue, &event));
+      sample_handler(&event);
+    }
 
-    /* Handle Sample */
-    sample_handler(&sample);
+    /* Sleep until the sampler commits or an event is queued, both signal an event */
+    if((0 == sample_count) && !event_available)
+    {
+      __wfe();
+    }
   }
 
   return 0;
@@ -3,6 +3,7 @@
 #include <hardware/watchdog.h>
 
 #include "at24c_eeprom.hpp"
+#include "seismometer_config.hpp"
 #include "seismometer_debug.hpp"
 #include "seismometer_eeprom.hpp"
 #include "seismometer_utils.hpp"
@@ -14,7 +15,7 @@ static const seismometer_eeprom_data_s default_eeprom_data =
   .header = 
   {
     .identifier      = EEPROM_IDENTIFIER,
-    .version         = SEISMOMETER_EEPROM_VERSION_1,
+    .version         = SEISMOMETER_EEPROM_VERSION_2,
     .reset_requested = false,
   },
   .sample_log_config = 
@@ -22,11 +23,16 @@ static const seismometer_eeprom_data_s default_eeprom_data =
     .key_mask_stdio = 0x00,
     .key_mask_sd    = ((1<<SAMPLE_LOG_MAX_KEY)-1),
   },
+  .sampler_config = 
+  {
+    .sample_rate_hz = SEISMOMETER_SAMPLE_RATE_DEFAULT,
+  },
 };
 
 static seismometer_eeprom_data_s eeprom_data = {0};
 #define EEPROM_ADDRESS_HEADER            0x0000
 #define EEPROM_ADDRESS_SAMPLE_LOG_CONFIG 0x0040
+#define EEPROM_ADDRESS_SAMPLER_CONFIG    0x0080
 
 static bool eeprom_write_header(const seismometer_eeprom_header_s *header)
 {
@@ -44,6 +50,14 @@ static bool eeprom_write_sample_log_config(const seismometer_eeprom_sample_log_c
                   eeprom->write_data(EEPROM_ADDRESS_SAMPLE_LOG_CONFIG, (uint8_t*) config, sizeof(seismometer_eeprom_sample_log_config_s)));
   return ret_val;
 }
+static bool eeprom_write_sampler_config(const seismometer_eeprom_sampler_config_s * config)
+{
+  SEISMOMETER_ASSERT(config != nullptr);
+  SEISMOMETER_PRINTF(SEISMOMETER_LOG_INFO, "Writing new sampler config to EEPROM.\n");
+  bool ret_val = (sizeof(seismometer_eeprom_sampler_config_s) == 
+                  eeprom->write_data(EEPROM_ADDRESS_SAMPLER_CONFIG, (uint8_t*) config, sizeof(seismometer_eeprom_sampler_config_s)));
+  return ret_val;
+}
 static bool eeprom_write_data(const seismometer_eeprom_data_s *new_eeprom_data)
 {
   SEISMOMETER_ASSERT(new_eeprom_data != nullptr);
@@ -63,6 +77,11 @@ static bool eeprom_write_data(const seismometer_eeprom_data_s *new_eeprom_data)
       ret_val = false;
       break;
     }
+    if(!eeprom_write_sampler_config(&new_eeprom_data->sampler_config))
+    {
+      ret_val = false;
+      break;
+    }
   } while(0);
 
   return ret_val;
@@ -103,8 +122,22 @@ void eeprom_init(seismometer_i2c_handle_s *i2c_handle)
     seismometer_force_reboot();
   }
 
+  /* Older versions keep their config, the sections added since are programmed with the defaults */
+  if(eeprom_data.header.version < SEISMOMETER_EEPROM_VERSION_2)
+  {
+    SEISMOMETER_PRINTF(SEISMOMETER_LOG_INFO, "Upgrading EEPROM from version %u.\n", eeprom_data.header.version);
+    SEISMOMETER_ASSERT_CALL(eeprom_write_sampler_config(&default_eeprom_data.sampler_config));
+    seismometer_eeprom_header_s new_header = eeprom_data.header;
+    new_header.version = SEISMOMETER_EEPROM_VERSION_2;
+    SEISMOMETER_ASSERT_CALL(eeprom_write_header(&new_header));
+    eeprom_data.header = new_header;
+    watchdog_update();
+  }
+
   SEISMOMETER_ASSERT_CALL(sizeof(eeprom_data.sample_log_config) == 
     eeprom->read_data(EEPROM_ADDRESS_SAMPLE_LOG_CONFIG, (uint8_t*) &eeprom_data.sample_log_config, sizeof(eeprom_data.sample_log_config)));
+  SEISMOMETER_ASSERT_CALL(sizeof(eeprom_data.sampler_config) == 
+    eeprom->read_data(EEPROM_ADDRESS_SAMPLER_CONFIG, (uint8_t*) &eeprom_data.sampler_config, sizeof(eeprom_data.sampler_config)));
 }
 
 bool eeprom_request_reset()
@@ -131,4 +164,23 @@ bool eeprom_request_reset()
 const seismometer_eeprom_sample_log_config_s *eeprom_get_sample_log_config()
 {
   return &eeprom_data.sample_log_config;
+}
+const seismometer_eeprom_sampler_config_s *eeprom_get_sampler_config()
+{
+  return &eeprom_data.sampler_config;
+}
+
+bool eeprom_set_sampler_config(const seismometer_eeprom_sampler_config_s *config)
+{
+  SEISMOMETER_ASSERT(config != nullptr);
+  bool ret_val = eeprom_write_sampler_config(config);
+  if(ret_val)
+  {
+    eeprom_data.sampler_config = *config;
+  }
+  else
+  {
+    SEISMOMETER_PRINTF(SEISMOMETER_LOG_ERROR, "Failed to write sampler config to EEPROM.\n");
+  }
+  return ret_val;
 }
\ No newline at end of file
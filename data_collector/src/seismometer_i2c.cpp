@@ -0,0 +1,304 @@
+#include <cassert>
+#include <cstdio>
+
+#include <hardware/irq.h>
+#include <pico/time.h>
+
+#include "seismometer_debug.hpp"
+#include "seismometer_i2c.hpp"
+
+#define SEISMOMETER_I2C_FIFO_DEPTH 16
+/* TX_EMPTY once the command FIFO is down to TX_THRESHOLD entries, RX_FULL once RX_THRESHOLD+1 bytes are received.  Any
+   bytes left below the RX threshold are drained at STOP_DET */
+#define SEISMOMETER_I2C_TX_THRESHOLD 4
+#define SEISMOMETER_I2C_RX_THRESHOLD 11
+#define SEISMOMETER_I2C_INTR_MASK    (I2C_IC_INTR_MASK_M_RX_FULL_BITS | I2C_IC_INTR_MASK_M_TX_ABRT_BITS | I2C_IC_INTR_MASK_M_STOP_DET_BITS)
+
+/* Handles serviced by the I2C interrupt, by instance index */
+static seismometer_i2c_handle_s *seismometer_i2c_irq_handles[2] = {nullptr, nullptr};
+
+/* Issues as many commands of the active transaction as the FIFOs allow, with the critical section held */
+static void __time_critical_func(seismometer_i2c_feed_locked)(seismometer_i2c_handle_s *i2c_handle)
+{
+  seismometer_i2c_transaction_s *transaction = i2c_handle->active;
+  i2c_hw_t                      *hw          = i2c_get_hw(i2c_handle->i2c_inst);
+
+  bool rx_blocked = false;
+  while(hw->txflr < SEISMOMETER_I2C_FIFO_DEPTH)
+  {
+    if(i2c_handle->write_index < transaction->write_length)
+    {
+      uint32_t command = transaction->write_buffer[i2c_handle->write_index];
+      i2c_handle->write_index++;
+      if((i2c_handle->write_index == transaction->write_length) && (0 == transaction->read_length))
+      {
+        command |= I2C_IC_DATA_CMD_STOP_BITS;
+      }
+      hw->data_cmd = command;
+    }
+    else if(i2c_handle->read_command_index < transaction->read_length)
+    {
+      /* Never request more bytes than the RX FIFO holds */
+      if((i2c_handle->read_command_index - i2c_handle->read_index) >= SEISMOMETER_I2C_FIFO_DEPTH)
+      {
+        rx_blocked = true;
+        break;
+      }
+      uint32_t command = I2C_IC_DATA_CMD_CMD_BITS;
+      if((0 == i2c_handle->read_command_index) && (transaction->write_length > 0))
+      {
+        command |= I2C_IC_DATA_CMD_RESTART_BITS;
+      }
+      i2c_handle->read_command_index++;
+      if(i2c_handle->read_command_index == transaction->read_length)
+      {
+        command |= I2C_IC_DATA_CMD_STOP_BITS;
+      }
+      hw->data_cmd = command;
+    }
+    else
+    {
+      break;
+    }
+  }
+
+  /* TX_EMPTY only while there is more to issue and room for it, otherwise RX_FULL or STOP_DET continue */
+  const bool commands_left = ((i2c_handle->write_index < transaction->write_length) || (i2c_handle->read_command_index < transaction->read_length));
+  hw->intr_mask = SEISMOMETER_I2C_INTR_MASK | ((commands_left && !rx_blocked) ? I2C_IC_INTR_MASK_M_TX_EMPTY_BITS : 0);
+}
+
+/* Starts the highest priority queued transaction if the bus is free, with the critical section held */
+static void __time_critical_func(seismometer_i2c_start_locked)(seismometer_i2c_handle_s *i2c_handle)
+{
+  if(nullptr == i2c_handle->active)
+  {
+    for(unsigned int priority = 0; priority < SEISMOMETER_I2C_PRIORITY_MAX; priority++)
+    {
+      seismometer_i2c_transaction_s *transaction = i2c_handle->queue_head[priority];
+      if(transaction != nullptr)
+      {
+        i2c_handle->queue_head[priority] = transaction->next;
+        if(nullptr == transaction->next)
+        {
+          i2c_handle->queue_tail[priority] = nullptr;
+        }
+        transaction->next = nullptr;
+
+        const uint32_t wait_us = (time_us_32() - transaction->submit_us);
+        if(wait_us > i2c_handle->stats.max_wait_us[priority])
+        {
+          i2c_handle->stats.max_wait_us[priority] = wait_us;
+        }
+
+        i2c_handle->active             = transaction;
+        i2c_handle->write_index        = 0;
+        i2c_handle->read_command_index = 0;
+        i2c_handle->read_index         = 0;
+        i2c_handle->abort              = false;
+        i2c_handle->address_nack       = false;
+        transaction->status            = SEISMOMETER_I2C_STATUS_ACTIVE;
+
+        i2c_hw_t *hw = i2c_get_hw(i2c_handle->i2c_inst);
+        hw->enable = 0;
+        hw->tar    = transaction->address;
+        hw->enable = 1;
+        seismometer_i2c_feed_locked(i2c_handle);
+        break;
+      }
+    }
+  }
+}
+
+/* Advances the active transaction, with the critical section held.  Returns the transaction it completed, if any */
+static seismometer_i2c_transaction_s *__time_critical_func(seismometer_i2c_service_locked)(seismometer_i2c_handle_s *i2c_handle)
+{
+  seismometer_i2c_transaction_s *ret_val     = nullptr;
+  seismometer_i2c_transaction_s *transaction = i2c_handle->active;
+
+  if(transaction != nullptr)
+  {
+    i2c_hw_t      *hw       = i2c_get_hw(i2c_handle->i2c_inst);
+    const uint32_t raw_stat = hw->raw_intr_stat;
+
+    while((hw->rxflr > 0) && (i2c_handle->read_index < transaction->read_length))
+    {
+      transaction->read_buffer[i2c_handle->read_index] = (uint8_t)hw->data_cmd;
+      i2c_handle->read_index++;
+    }
+
+    /* An abort flushes the command FIFO and the controller still ends with a STOP */
+    if(raw_stat & I2C_IC_RAW_INTR_STAT_TX_ABRT_BITS)
+    {
+      /* Clearing the abort clears its source */
+      i2c_handle->address_nack = (0 != (hw->tx_abrt_source & I2C_IC_TX_ABRT_SOURCE_ABRT_7B_ADDR_NOACK_BITS));
+      (void)hw->clr_tx_abrt;
+      hw->intr_mask = SEISMOMETER_I2C_INTR_MASK;
+      i2c_handle->abort = true;
+    }
+
+    if(raw_stat & I2C_IC_RAW_INTR_STAT_STOP_DET_BITS)
+    {
+      (void)hw->clr_stop_det;
+      hw->intr_mask = 0;
+      const bool error = (i2c_handle->abort || (i2c_handle->read_index < transaction->read_length));
+      transaction->status = (error ? SEISMOMETER_I2C_STATUS_ERROR : SEISMOMETER_I2C_STATUS_DONE);
+      i2c_handle->stats.transaction_count++;
+      if(error && !(transaction->nack_expected && i2c_handle->address_nack))
+      {
+        i2c_handle->stats.error_count++;
+      }
+      i2c_handle->active = nullptr;
+      ret_val = transaction;
+      seismometer_i2c_start_locked(i2c_handle);
+    }
+    else if(!i2c_handle->abort)
+    {
+      seismometer_i2c_feed_locked(i2c_handle);
+    }
+  }
+
+  return ret_val;
+}
+
+/* Services the engine once and runs the callback of a completed transaction outside the critical section, so it may
+   submit the next transaction */
+static void __time_critical_func(seismometer_i2c_service)(seismometer_i2c_handle_s *i2c_handle)
+{
+  critical_section_enter_blocking(&i2c_handle->critical_section);
+  seismometer_i2c_transaction_s *completed = seismometer_i2c_service_locked(i2c_handle);
+  critical_section_exit(&i2c_handle->critical_section);
+
+  if((completed != nullptr) && (completed->callback != nullptr))
+  {
+    completed->callback(completed);
+  }
+}
+
+static void __isr __time_critical_func(seismometer_i2c_irq_handler)()
+{
+  for(unsigned int index = 0; index < 2; index++)
+  {
+    if(seismometer_i2c_irq_handles[index] != nullptr)
+    {
+      seismometer_i2c_service(seismometer_i2c_irq_handles[index]);
+    }
+  }
+}
+
+void seismometer_i2c_init(seismometer_i2c_handle_s *i2c_handle, i2c_inst_t *i2c_inst)
+{
+  SEISMOMETER_ASSERT(i2c_handle != nullptr);
+  SEISMOMETER_ASSERT(i2c_inst   != nullptr);
+
+  *i2c_handle = {0};
+  i2c_handle->i2c_inst = i2c_inst;
+  critical_section_init(&i2c_handle->critical_section);
+
+  i2c_hw_t *hw = i2c_get_hw(i2c_inst);
+  hw->intr_mask = 0;
+  hw->tx_tl     = SEISMOMETER_I2C_TX_THRESHOLD;
+  hw->rx_tl     = SEISMOMETER_I2C_RX_THRESHOLD;
+}
+
+void seismometer_i2c_enable_irq(seismometer_i2c_handle_s *i2c_handle)
+{
+  SEISMOMETER_ASSERT(i2c_handle != nullptr);
+  const uint index = i2c_hw_index(i2c_handle->i2c_inst);
+  const uint irq   = (I2C0_IRQ + index);
+  SEISMOMETER_PRINTF(SEISMOMETER_LOG_INFO, "Enabling I2C%u transaction interrupt.\n", index);
+
+  seismometer_i2c_irq_handles[index] = i2c_handle;
+  irq_set_exclusive_handler(irq, seismometer_i2c_irq_handler);
+  i2c_handle->irq_enabled = true;
+  irq_set_enabled(irq, true);
+}
+
+void __time_critical_func(seismometer_i2c_submit)(seismometer_i2c_handle_s *i2c_handle, seismometer_i2c_transaction_s *transaction)
+{
+  SEISMOMETER_ASSERT(i2c_handle  != nullptr);
+  SEISMOMETER_ASSERT(transaction != nullptr);
+  SEISMOMETER_ASSERT(transaction->priority < SEISMOMETER_I2C_PRIORITY_MAX);
+  SEISMOMETER_ASSERT((transaction->write_length + transaction->read_length) > 0);
+  SEISMOMETER_ASSERT((transaction->write_length == 0) || (transaction->write_buffer != nullptr));
+  SEISMOMETER_ASSERT((transaction->read_length  == 0) || (transaction->read_buffer  != nullptr));
+
+  critical_section_enter_blocking(&i2c_handle->critical_section);
+  SEISMOMETER_ASSERT((SEISMOMETER_I2C_STATUS_QUEUED != transaction->status) && (SEISMOMETER_I2C_STATUS_ACTIVE != transaction->status));
+  transaction->status    = SEISMOMETER_I2C_STATUS_QUEUED;
+  transaction->submit_us = time_us_32();
+  transaction->next      = nullptr;
+  if(nullptr == i2c_handle->queue_tail[transaction->priority])
+  {
+    i2c_handle->queue_head[transaction->priority] = transaction;
+  }
+  else
+  {
+    i2c_handle->queue_tail[transaction->priority]->next = transaction;
+  }
+  i2c_handle->queue_tail[transaction->priority] = transaction;
+  seismometer_i2c_start_locked(i2c_handle);
+  critical_section_exit(&i2c_handle->critical_section);
+}
+
+bool seismometer_i2c_wait(seismometer_i2c_handle_s *i2c_handle, seismometer_i2c_transaction_s *transaction)
+{
+  SEISMOMETER_ASSERT(i2c_handle  != nullptr);
+  SEISMOMETER_ASSERT(transaction != nullptr);
+
+  while((SEISMOMETER_I2C_STATUS_QUEUED == transaction->status) || (SEISMOMETER_I2C_STATUS_ACTIVE == transaction->status))
+  {
+    if(!i2c_handle->irq_enabled)
+    {
+      seismometer_i2c_service(i2c_handle);
+    }
+    tight_loop_contents();
+  }
+
+  return (SEISMOMETER_I2C_STATUS_DONE == transaction->status);
+}
+
+static bool seismometer_i2c_blocking(seismometer_i2c_handle_s *i2c_handle, uint8_t address, const uint8_t *write_buffer,
+                                     size_t write_length, uint8_t *read_buffer, size_t read_length, bool nack_expected)
+{
+  seismometer_i2c_transaction_s transaction =
+  {
+    .address       = address,
+    .write_buffer  = write_buffer,
+    .write_length  = write_length,
+    .read_buffer   = read_buffer,
+    .read_length   = read_length,
+    .priority      = SEISMOMETER_I2C_PRIORITY_HOUSEKEEPING,
+    .callback      = nullptr,
+    .user_data     = nullptr,
+    .nack_expected = nack_expected,
+    .status        = SEISMOMETER_I2C_STATUS_IDLE,
+    .submit_us     = 0,
+    .next          = nullptr,
+  };
+  seismometer_i2c_submit(i2c_handle, &transaction);
+  return seismometer_i2c_wait(i2c_handle, &transaction);
+}
+
+bool seismometer_i2c_transfer_blocking(seismometer_i2c_handle_s *i2c_handle, uint8_t address,
+                                       const uint8_t *write_buffer, size_t write_length, uint8_t *read_buffer, size_t read_length)
+{
+  return seismometer_i2c_blocking(i2c_handle, address, write_buffer, write_length, read_buffer, read_length, false);
+}
+
+bool seismometer_i2c_poll_blocking(seismometer_i2c_handle_s *i2c_handle, uint8_t address, const uint8_t *write_buffer, size_t write_length)
+{
+  return seismometer_i2c_blocking(i2c_handle, address, write_buffer, write_length, nullptr, 0, true);
+}
+
+void seismometer_i2c_get_stats(seismometer_i2c_handle_s *i2c_handle, seismometer_i2c_stats_s *stats)
+{
+  SEISMOMETER_ASSERT(i2c_handle != nullptr);
+  SEISMOMETER_ASSERT(stats      != nullptr);
+  critical_section_enter_blocking(&i2c_handle->critical_section);
+  *stats = i2c_handle->stats;
+  for(unsigned int priority = 0; priority < SEISMOMETER_I2C_PRIORITY_MAX; priority++)
+  {
+    i2c_handle->stats.max_wait_us[priority] = 0;
+  }
+  critical_section_exit(&i2c_handle->critical_section);
+}
\ No newline at end of file
@@ -0,0 +1,144 @@
+#include <cassert>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+#include "seismometer_debug.hpp"
+#include "spectrum.hpp"
+
+/* Segments are scaled to just below the FFT headroom, larger values are shifted by the FFT anyway */
+#define SPECTRUM_INPUT_MAX (1<<13)
+
+spectrum_c::spectrum_c(const fft_q15_c *fft_init, unsigned int segments_init, unsigned int sample_rate)
+  : fft(fft_init), length(fft_init->get_length()), segments(segments_init)
+{
+  SEISMOMETER_ASSERT(fft != nullptr);
+  SEISMOMETER_ASSERT(segments > 0);
+  SEISMOMETER_ASSERT(sample_rate > 0);
+  segment    = (int32_t*) calloc(sizeof(int32_t), length);
+  fft_buffer = (q15_t*)   calloc(sizeof(q15_t),   length);
+  psd_sum    = (float*)   calloc(sizeof(float),   get_bin_count());
+  psd        = (float*)   calloc(sizeof(float),   get_bin_count());
+  SEISMOMETER_ASSERT(segment    != nullptr);
+  SEISMOMETER_ASSERT(fft_buffer != nullptr);
+  SEISMOMETER_ASSERT(psd_sum    != nullptr);
+  SEISMOMETER_ASSERT(psd        != nullptr);
+
+  /* PSD = |X|^2/(fs*sum(w^2)) */
+  float window_power = 0;
+  for(size_t n = 0; n < length; n++)
+  {
+    const float w = ((float)fft->window_hann(n))/Q15_ONE;
+    window_power += (w*w);
+  }
+  psd_scale = 1.0f/(((float)sample_rate)*window_power);
+}
+spectrum_c::~spectrum_c()
+{
+  free(segment);
+  free(fft_buffer);
+  free(psd_sum);
+  free(psd);
+}
+
+void spectrum_c::process_segment()
+{
+  SEISMOMETER_ASSERT(length == segment_fill);
+
+  /* Remove the mean then scale into Q15 as (segment-mean)*2^-input_exponent */
+  int64_t sum = 0;
+  for(size_t n = 0; n < length; n++)
+  {
+    sum += segment[n];
+  }
+  const int32_t mean = (int32_t)(sum/(int64_t)length);
+  uint32_t max = 0;
+  for(size_t n = 0; n < length; n++)
+  {
+    const int32_t value     = (segment[n] - mean);
+    const uint32_t magnitude = (uint32_t)((value < 0) ? -value : value);
+    if(magnitude > max)
+    {
+      max = magnitude;
+    }
+  }
+  int input_exponent = 0;
+  if(max > 0)
+  {
+    while((max >> input_exponent) >= SPECTRUM_INPUT_MAX)
+    {
+      input_exponent++;
+    }
+    while((input_exponent <= 0) && ((max << (1-input_exponent)) < SPECTRUM_INPUT_MAX))
+    {
+      input_exponent--;
+    }
+  }
+  for(size_t n = 0; n < length; n++)
+  {
+    const int32_t value  = (segment[n] - mean);
+    const int32_t scaled = ((input_exponent >= 0) ? (value >> input_exponent) : (value << -input_exponent));
+    fft_buffer[n] = (q15_t)(((scaled*(int32_t)fft->window_hann(n)) + (1<<14)) >> 15);
+  }
+
+  /* |X|^2 of the unscaled segment is |output|^2*2^(2*(input_exponent+fft_exponent)) */
+  const int   exponent = (input_exponent + fft->forward_real(fft_buffer));
+  const float scale    = ldexpf(psd_scale, 2*exponent);
+  const size_t nyquist = (length/2);
+  psd_sum[0]       += scale*(float)(((int32_t)fft_buffer[0])*fft_buffer[0]);
+  psd_sum[nyquist] += scale*(float)(((int32_t)fft_buffer[1])*fft_buffer[1]);
+  for(size_t k = 1; k < nyquist; k++)
+  {
+    const int32_t re = fft_buffer[2*k];
+    const int32_t im = fft_buffer[2*k+1];
+    psd_sum[k] += 2*scale*(float)((re*re) + (im*im));
+  }
+
+  /* 50% overlap */
+  memmove(segment, &segment[length/2], (length/2)*sizeof(int32_t));
+  segment_fill = (length/2);
+
+  segment_count++;
+  if(segment_count >= segments)
+  {
+    for(size_t k = 0; k < get_bin_count(); k++)
+    {
+      psd[k]     = (psd_sum[k]/segment_count);
+      psd_sum[k] = 0;
+    }
+    segment_count = 0;
+    psd_ready     = true;
+  }
+}
+
+void spectrum_c::push_sample(int32_t sample)
+{
+  if(length == segment_fill)
+  {
+    process_segment();
+  }
+  segment[segment_fill++] = sample;
+}
+
+bool spectrum_c::process()
+{
+  if(length == segment_fill)
+  {
+    process_segment();
+  }
+  bool ret_val = psd_ready;
+  psd_ready = false;
+  return ret_val;
+}
+
+float spectrum_c::get_band_psd(size_t first_bin, size_t end_bin) const
+{
+  SEISMOMETER_ASSERT(first_bin < end_bin);
+  SEISMOMETER_ASSERT(end_bin <= get_bin_count());
+  float sum = 0;
+  for(size_t k = first_bin; k < end_bin; k++)
+  {
+    sum += psd[k];
+  }
+  return (sum/(end_bin-first_bin));
+}
\ No newline at end of file
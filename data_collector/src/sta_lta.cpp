@@ -0,0 +1,67 @@
+#include <cassert>
+#include <cstdlib>
+
+#include "circular_buffer.hpp"
+#include "seismometer_debug.hpp"
+#include "sta_lta.hpp"
+
+sta_lta_c::sta_lta_c(size_t sta_length_init, size_t lta_length_init, uint32_t trigger_ratio_x10_init, uint32_t detrigger_ratio_x10_init)
+  : sta_length(sta_length_init), lta_length(lta_length_init),
+    trigger_ratio_x10(trigger_ratio_x10_init), detrigger_ratio_x10(detrigger_ratio_x10_init)
+{
+  SEISMOMETER_ASSERT(sta_length > 0);
+  SEISMOMETER_ASSERT(sta_length < lta_length);
+  /* Sums of 16 bit values must fit 32 bits */
+  SEISMOMETER_ASSERT(lta_length <= (UINT32_MAX/UINT16_MAX));
+  SEISMOMETER_ASSERT(detrigger_ratio_x10 <= trigger_ratio_x10);
+  history = (uint16_t*) calloc(sizeof(uint16_t), lta_length);
+  SEISMOMETER_ASSERT(history != nullptr);
+}
+sta_lta_c::~sta_lta_c()
+{
+  free(history);
+}
+
+bool sta_lta_c::push_sample(filter_sample_t sample)
+{
+  const uint32_t magnitude = (uint32_t)((sample < 0) ? -sample : sample);
+  const uint16_t value     = (uint16_t)((magnitude > UINT16_MAX) ? UINT16_MAX : magnitude);
+
+  /* Oldest value leaves the LTA window, the value sta_length before the newest leaves the STA window */
+  lta_sum -= history[next_write];
+  sta_sum -= history[CIRCULAR_BUFFER_OFFSET_NEG(next_write, lta_length, sta_length)];
+  history[next_write] = value;
+  lta_sum += value;
+  sta_sum += value;
+  next_write = INCREMENT_CIRCULAR_BUFFER_ITERATOR(next_write, lta_length);
+  if(history_fill < lta_length)
+  {
+    history_fill++;
+  }
+
+  if(history_fill == lta_length)
+  {
+    /* STA/LTA >= ratio/10 as sta_sum*lta_length*10 >= ratio*lta_sum*sta_length */
+    const uint64_t sta_scaled = ((uint64_t)sta_sum)*lta_length*10;
+    const uint64_t lta_scaled = ((uint64_t)lta_sum)*sta_length;
+    if(!triggered && (sta_scaled >= (trigger_ratio_x10*lta_scaled)) && (lta_sum > 0))
+    {
+      triggered = true;
+    }
+    else if(triggered && (sta_scaled < (detrigger_ratio_x10*lta_scaled)))
+    {
+      triggered = false;
+    }
+  }
+  return triggered;
+}
+
+uint32_t sta_lta_c::get_ratio_x10() const
+{
+  uint32_t ret_val = 0;
+  if((history_fill == lta_length) && (lta_sum > 0))
+  {
+    ret_val = (uint32_t)((((uint64_t)sta_sum)*lta_length*10)/(((uint64_t)lta_sum)*sta_length));
+  }
+  return ret_val;
+}
\ No newline at end of file
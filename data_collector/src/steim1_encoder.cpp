@@ -0,0 +1,219 @@
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+
+#include "steim1_encoder.hpp"
+#include "seismometer_debug.hpp"
+
+#define STEIM1_CODE_NONE   0x0
+#define STEIM1_CODE_4X8    0x1
+#define STEIM1_CODE_2X16   0x2
+#define STEIM1_CODE_1X32   0x3
+
+/* Words 0 (codes), 1 (X0) and 2 (Xn) of the first frame do not hold differences */
+#define STEIM1_FIRST_DATA_WORD 3
+
+#define STEIM1_FITS_8(difference)  (((difference) >= INT8_MIN)  && ((difference) <= INT8_MAX))
+#define STEIM1_FITS_16(difference) (((difference) >= INT16_MIN) && ((difference) <= INT16_MAX))
+
+steim1_encoder_c::steim1_encoder_c(size_t frame_count_init)
+  : frame_count(frame_count_init)
+{
+  SEISMOMETER_ASSERT(frame_count > 0);
+  /* 4 differences per word, block sample count must fit in a uint16_t */
+  SEISMOMETER_ASSERT((frame_count*STEIM1_FRAME_WORDS*4) <= UINT16_MAX);
+  block = (uint32_t*) calloc(sizeof(uint32_t), frame_count*STEIM1_FRAME_WORDS);
+  SEISMOMETER_ASSERT(block != nullptr);
+  start_block();
+}
+steim1_encoder_c::~steim1_encoder_c()
+{
+  free(block);
+}
+
+void steim1_encoder_c::start_block()
+{
+  memset(block, 0, frame_count*STEIM1_FRAME_SIZE);
+  next_word          = STEIM1_FIRST_DATA_WORD;
+  block_frame_count  = 0;
+  block_sample_count = 0;
+  block_complete     = false;
+}
+
+void steim1_encoder_c::finish_block()
+{
+  SEISMOMETER_ASSERT(block_sample_count > 0);
+  block[1] = (uint32_t)block_first_sample;
+  block[2] = (uint32_t)block_last_sample;
+
+  /* Codes were accumulated in word 0 of each frame in host order, convert the whole block to big-endian */
+  for(size_t i = 0; i < (frame_count*STEIM1_FRAME_WORDS); i++)
+  {
+    block[i] = __builtin_bswap32(block[i]);
+  }
+  block_complete = true;
+}
+
+/* Packs the first 'count' pending differences into the next word with 'code'.  Returns true if the block is full */
+bool steim1_encoder_c::pack_word(size_t count, uint32_t code)
+{
+  SEISMOMETER_ASSERT((count > 0) && (count <= pending_count));
+  SEISMOMETER_ASSERT(next_word < (frame_count*STEIM1_FRAME_WORDS));
+
+  uint32_t word = 0;
+  switch(code)
+  {
+    case STEIM1_CODE_4X8:
+    {
+      for(size_t i = 0; i < 4; i++)
+      {
+        word = (word<<8) | ((uint32_t)pending[i].difference & 0xFF);
+      }
+      break;
+    }
+    case STEIM1_CODE_2X16:
+    {
+      word = (((uint32_t)pending[0].difference & 0xFFFF)<<16) | ((uint32_t)pending[1].difference & 0xFFFF);
+      break;
+    }
+    case STEIM1_CODE_1X32:
+    {
+      word = (uint32_t)pending[0].difference;
+      break;
+    }
+    default:
+    {
+      SEISMOMETER_ASSERT(0);
+      break;
+    }
+  }
+
+  if(0 == block_sample_count)
+  {
+    block_first_sample = pending[0].sample;
+    block_time         = pending[0].time;
+  }
+  block_last_sample   = pending[count-1].sample;
+  block_sample_count += count;
+
+  size_t frame_start = (next_word - (next_word % STEIM1_FRAME_WORDS));
+  block[next_word]    = word;
+  block[frame_start] |= (code << (2*(STEIM1_FRAME_WORDS-1-(next_word % STEIM1_FRAME_WORDS))));
+  block_frame_count   = ((frame_start/STEIM1_FRAME_WORDS)+1);
+  next_word++;
+  /* Word 0 of each following frame holds codes */
+  if(0 == (next_word % STEIM1_FRAME_WORDS))
+  {
+    next_word++;
+  }
+
+  pending_count -= count;
+  memmove(&pending[0], &pending[count], pending_count*sizeof(pending_sample_s));
+
+  return (next_word >= (frame_count*STEIM1_FRAME_WORDS));
+}
+
+/* Packs pending differences into words while the best packing is known, all differences are packed if 'final'.
+   Returns true if the block is full */
+bool steim1_encoder_c::pack_pending(bool final)
+{
+  bool block_full = false;
+
+  while((pending_count > 0) && !block_full)
+  {
+    if(!STEIM1_FITS_16(pending[0].difference))
+    {
+      block_full = pack_word(1, STEIM1_CODE_1X32);
+    }
+    else if((pending_count >= 4) && STEIM1_FITS_8(pending[0].difference) && STEIM1_FITS_8(pending[1].difference) &&
+                                    STEIM1_FITS_8(pending[2].difference) && STEIM1_FITS_8(pending[3].difference))
+    {
+      block_full = pack_word(4, STEIM1_CODE_4X8);
+    }
+    else
+    {
+      /* Four 8 bit differences are still possible while every pending difference fits in 8 bits */
+      bool fits_4x8 = true;
+      for(size_t i = 0; i < pending_count; i++)
+      {
+        fits_4x8 = fits_4x8 && STEIM1_FITS_8(pending[i].difference);
+      }
+
+      if(fits_4x8 && !final)
+      {
+        break;
+      }
+      else if(pending_count >= 2)
+      {
+        if(STEIM1_FITS_16(pending[1].difference))
+        {
+          block_full = pack_word(2, STEIM1_CODE_2X16);
+        }
+        else
+        {
+          block_full = pack_word(1, STEIM1_CODE_1X32);
+        }
+      }
+      else if(final)
+      {
+        block_full = pack_word(1, STEIM1_CODE_1X32);
+      }
+      else
+      {
+        break;
+      }
+    }
+  }
+
+  return block_full;
+}
+
+bool steim1_encoder_c::push_sample(int32_t sample, steim1_time_t time)
+{
+  if(block_complete)
+  {
+    start_block();
+    /* At most four pending differences which can not fill a new block */
+    SEISMOMETER_ASSERT_CALL(!pack_pending(false));
+  }
+  SEISMOMETER_ASSERT(pending_count < 4);
+
+  /* Difference wraps the same as the decoder's sum */
+  pending[pending_count].sample     = sample;
+  pending[pending_count].difference = history_valid ? (int32_t)((uint32_t)sample - (uint32_t)last_sample) : 0;
+  pending[pending_count].time       = time;
+  pending_count++;
+  last_sample   = sample;
+  history_valid = true;
+
+  bool ret_val = pack_pending(false);
+  if(ret_val)
+  {
+    finish_block();
+  }
+  return ret_val;
+}
+
+bool steim1_encoder_c::flush()
+{
+  if(block_complete)
+  {
+    start_block();
+  }
+
+  /* Block may fill before every pending difference is packed, the rest go in the next block */
+  pack_pending(true);
+  bool ret_val = (block_sample_count > 0);
+  if(ret_val)
+  {
+    finish_block();
+  }
+  return ret_val;
+}
+
+void steim1_encoder_c::reset()
+{
+  start_block();
+  pending_count = 0;
+  history_valid = false;
+}
\ No newline at end of file
@@ -15,4 +15,19 @@ def parse_seismometer_line(database, line):
       'timestamp': int(line_split[3],16),
       'data'     : twos_complement(line_split[4],64),
     }
-    database.push_sample(sample)
\ No newline at end of file
+    database.push_sample(sample)
+  elif((4 <= len(line_split)) and ('F' == line_split[0])):
+    # Sample frame, 'F|<key mask>|<index>|<timestamp>|<data>...' with one data field per key set in the mask
+    key_mask  = int(line_split[1],16)
+    index     = int(line_split[2],16)
+    timestamp = int(line_split[3],16)
+    keys      = [key for key in range(key_mask.bit_length()) if ((key_mask >> key) & 1)]
+    if(len(keys) == (len(line_split)-4)):
+      for (key, data) in zip(keys, line_split[4:]):
+        sample = {
+          'key'      : key,
+          'index'    : index,
+          'timestamp': timestamp,
+          'data'     : twos_complement(data,32),
+        }
+        database.push_sample(sample)
\ No newline at end of file
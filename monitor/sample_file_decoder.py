@@ -0,0 +1,240 @@
+#!/bin/python3
+from datetime import datetime, timezone
+import struct
+import sys
+
+# Binary sample file format, see data_collector/inc/sample_record.hpp
+SAMPLE_RECORD_MAGIC           = b'SLSR'
+SAMPLE_RECORD_VERSION_1       = 1
+SAMPLE_RECORD_VERSION_2       = 2
+
+SAMPLE_RECORD_TYPE_FILE_HEADER = 1
+SAMPLE_RECORD_TYPE_SAMPLE      = 2
+SAMPLE_RECORD_TYPE_STEIM1_BLOCK = 3
+SAMPLE_RECORD_TYPE_FRAME       = 4
+SAMPLE_RECORD_TYPE_SPECTRUM    = 5
+SAMPLE_RECORD_TYPE_GOERTZEL    = 6
+
+STEIM1_FRAME_SIZE = 64
+
+file_header_struct  = struct.Struct('<B4sBBBHQ')
+sample_struct       = struct.Struct('<BBIQi')
+steim1_block_v1_struct = struct.Struct('<BBBHIQ')
+steim1_block_struct = struct.Struct('<BBBHHIQ')
+steim1_frame_struct = struct.Struct('>16I')
+frame_struct        = struct.Struct('<BHIQ')
+spectrum_struct      = struct.Struct('<BBHHHQ')
+spectrum_band_struct = struct.Struct('<Hh')
+goertzel_struct      = struct.Struct('<BBBHQ')
+goertzel_bin_struct  = struct.Struct('<Ih')
+
+class sample_file_decode_error(Exception):
+  pass
+
+def parse_file_header(data, offset):
+  (record_type, magic, version, header_size, sample_record_size, sample_rate, open_time) = file_header_struct.unpack_from(data, offset)
+  if(magic != SAMPLE_RECORD_MAGIC):
+    raise sample_file_decode_error("Bad file header magic at offset " + str(offset))
+  if(version not in (SAMPLE_RECORD_VERSION_1, SAMPLE_RECORD_VERSION_2)):
+    raise sample_file_decode_error("Unsupported file version " + str(version) + " at offset " + str(offset))
+  header = {
+    'version'           : version,
+    'sample_record_size': sample_record_size,
+    'sample_rate'       : sample_rate,
+    'open_time'         : open_time,
+  }
+  return (header, offset+header_size)
+
+def parse_sample(data, offset):
+  (record_type, key, index, timestamp, value) = sample_struct.unpack_from(data, offset)
+  sample = {
+    'key'      : key,
+    'index'    : index,
+    'timestamp': timestamp,
+    'data'     : value,
+  }
+  return (sample, offset+sample_struct.size)
+
+def sign_extend(value, bits):
+  sign = 1 << (bits-1)
+  return (value & (sign-1)) - (value & sign)
+
+# Decodes big-endian Steim1 frames, see data_collector/inc/steim1_encoder.hpp
+def decode_steim1_frames(data, sample_count):
+  differences = []
+  x0 = xn = 0
+  for frame_offset in range(0, len(data), STEIM1_FRAME_SIZE):
+    words = steim1_frame_struct.unpack_from(data, frame_offset)
+    for i in range(1, 16):
+      code = (words[0] >> (2*(15-i))) & 0x3
+      if(0 == frame_offset) and (1 == i):
+        x0 = sign_extend(words[i], 32)
+      elif(0 == frame_offset) and (2 == i):
+        xn = sign_extend(words[i], 32)
+      elif(1 == code):
+        differences += [sign_extend(words[i] >> shift, 8) for shift in (24, 16, 8, 0)]
+      elif(2 == code):
+        differences += [sign_extend(words[i] >> shift, 16) for shift in (16, 0)]
+      elif(3 == code):
+        differences.append(sign_extend(words[i], 32))
+  if(len(differences) < sample_count):
+    raise sample_file_decode_error("Steim1 block holds " + str(len(differences)) + " of " + str(sample_count) + " samples")
+
+  # First difference is relative to the previous block, X0 makes each block self-contained
+  samples = [x0]
+  for difference in differences[1:sample_count]:
+    samples.append(sign_extend(samples[-1] + difference, 32))
+  if(samples[-1] != xn):
+    raise sample_file_decode_error("Steim1 block last sample " + str(samples[-1]) + " does not match Xn " + str(xn))
+  return samples
+
+# Version 1 blocks have no sample rate, their samples are at the file header sample rate
+def parse_steim1_block(data, offset, version=SAMPLE_RECORD_VERSION_2):
+  if(SAMPLE_RECORD_VERSION_1 == version):
+    (record_type, key, frame_count, sample_count, index, timestamp) = steim1_block_v1_struct.unpack_from(data, offset)
+    sample_rate   = None
+    frames_offset = offset+steim1_block_v1_struct.size
+  else:
+    (record_type, key, frame_count, sample_rate, sample_count, index, timestamp) = steim1_block_struct.unpack_from(data, offset)
+    frames_offset = offset+steim1_block_struct.size
+  frames_end    = frames_offset+(frame_count*STEIM1_FRAME_SIZE)
+  if(frames_end > len(data)):
+    raise struct.error("Truncated Steim1 block")
+  block = {
+    'key'        : key,
+    'sample_rate': sample_rate,
+    'index'      : index,
+    'timestamp'  : timestamp,
+    'samples'    : decode_steim1_frames(data[frames_offset:frames_end], sample_count),
+  }
+  return (block, frames_end)
+
+def parse_frame(data, offset):
+  (record_type, key_mask, index, timestamp) = frame_struct.unpack_from(data, offset)
+  keys = [key for key in range(16) if ((key_mask >> key) & 1)]
+  values = struct.unpack_from('<' + str(len(keys)) + 'i', data, offset+frame_struct.size)
+  frame = {
+    'index'    : index,
+    'timestamp': timestamp,
+    'data'     : dict(zip(keys, values)),
+  }
+  return (frame, offset+frame_struct.size+(4*len(keys)))
+
+def parse_spectrum(data, offset):
+  (record_type, key, band_count, segment_count, fft_length, timestamp) = spectrum_struct.unpack_from(data, offset)
+  bands = [spectrum_band_struct.unpack_from(data, offset+spectrum_struct.size+(i*spectrum_band_struct.size)) for i in range(band_count)]
+  spectrum = {
+    'key'          : key,
+    'timestamp'    : timestamp,
+    'segment_count': segment_count,
+    'fft_length'   : fft_length,
+    'bands'        : bands,
+  }
+  return (spectrum, offset+spectrum_struct.size+(band_count*spectrum_band_struct.size))
+
+def parse_goertzel(data, offset):
+  (record_type, key, bin_count, block_length, timestamp) = goertzel_struct.unpack_from(data, offset)
+  bins = [goertzel_bin_struct.unpack_from(data, offset+goertzel_struct.size+(i*goertzel_bin_struct.size)) for i in range(bin_count)]
+  goertzel = {
+    'key'         : key,
+    'timestamp'   : timestamp,
+    'block_length': block_length,
+    'bins'        : bins,
+  }
+  return (goertzel, offset+goertzel_struct.size+(bin_count*goertzel_bin_struct.size))
+
+record_parsers = {
+  SAMPLE_RECORD_TYPE_FILE_HEADER : parse_file_header,
+  SAMPLE_RECORD_TYPE_SAMPLE      : parse_sample,
+  SAMPLE_RECORD_TYPE_STEIM1_BLOCK: parse_steim1_block,
+  SAMPLE_RECORD_TYPE_FRAME       : parse_frame,
+  SAMPLE_RECORD_TYPE_SPECTRUM    : parse_spectrum,
+  SAMPLE_RECORD_TYPE_GOERTZEL    : parse_goertzel,
+}
+
+# Yields (record type, record dictionary) for every complete record in 'data'.
+# A truncated final record (e.g. after power loss) is silently dropped.
+def decode_sample_file(data):
+  offset  = 0
+  version = SAMPLE_RECORD_VERSION_2
+  while(offset < len(data)):
+    record_type = data[offset]
+    if(record_type not in record_parsers):
+      raise sample_file_decode_error("Unknown record type " + str(record_type) + " at offset " + str(offset))
+    try:
+      if(SAMPLE_RECORD_TYPE_STEIM1_BLOCK == record_type):
+        (record, offset) = parse_steim1_block(data, offset, version)
+      else:
+        (record, offset) = record_parsers[record_type](data, offset)
+    except struct.error:
+      break
+    if(SAMPLE_RECORD_TYPE_FILE_HEADER == record_type):
+      version = record['version']
+    yield (record_type, record)
+
+# Yields (record type, record dictionary) as decode_sample_file but with Steim1 blocks and frames expanded to sample records.
+# Block sample timestamps are interpolated from the first sample using the block sample rate, or the file header sample
+# rate for version 1 files.
+def decode_sample_file_samples(data):
+  sample_rate = None
+  for (record_type, record) in decode_sample_file(data):
+    if(SAMPLE_RECORD_TYPE_FILE_HEADER == record_type):
+      sample_rate = record['sample_rate']
+      yield (record_type, record)
+    elif(SAMPLE_RECORD_TYPE_STEIM1_BLOCK == record_type):
+      block_sample_rate = record['sample_rate'] if (record['sample_rate'] is not None) else sample_rate
+      if(block_sample_rate is None):
+        raise sample_file_decode_error("Steim1 block before file header")
+      for (i, value) in enumerate(record['samples']):
+        sample = {
+          'key'      : record['key'],
+          'index'    : (record['index']+i) & 0xFFFFFFFF,
+          'timestamp': record['timestamp'] + ((i*1000)//block_sample_rate),
+          'data'     : value,
+        }
+        yield (SAMPLE_RECORD_TYPE_SAMPLE, sample)
+    elif(SAMPLE_RECORD_TYPE_FRAME == record_type):
+      for (key, value) in record['data'].items():
+        sample = {
+          'key'      : key,
+          'index'    : record['index'],
+          'timestamp': record['timestamp'],
+          'data'     : value,
+        }
+        yield (SAMPLE_RECORD_TYPE_SAMPLE, sample)
+    else:
+      yield (record_type, record)
+
+# Pushes all samples from a binary sample file into a sample_database
+def load_sample_file(database, path):
+  with open(path, 'rb') as f:
+    for (record_type, record) in decode_sample_file_samples(f.read()):
+      if(SAMPLE_RECORD_TYPE_SAMPLE == record_type):
+        database.push_sample(record)
+
+# Prints records in the same format as the ASCII sample file
+def print_sample_file(path):
+  with open(path, 'rb') as f:
+    for (record_type, record) in decode_sample_file_samples(f.read()):
+      if(SAMPLE_RECORD_TYPE_FILE_HEADER == record_type):
+        open_time = datetime.fromtimestamp(record['open_time']/1000, tz=timezone.utc)
+        print("I|Opened at " + open_time.strftime("%Y-%m-%dT%H:%M:%S") + ".")
+      elif(SAMPLE_RECORD_TYPE_SAMPLE == record_type):
+        print("S|%02X|%08X|%016X|%016X" % (record['key'], record['index'], record['timestamp'], record['data'] & 0xFFFFFFFFFFFFFFFF))
+      elif(SAMPLE_RECORD_TYPE_SPECTRUM == record_type):
+        print("P|%02X|%016X|%04X|%04X" % (record['key'], record['timestamp'], record['segment_count'], record['fft_length']) +
+              "".join(["|%X:%d" % band for band in record['bands']]))
+      elif(SAMPLE_RECORD_TYPE_GOERTZEL == record_type):
+        print("G|%02X|%016X|%04X" % (record['key'], record['timestamp'], record['block_length']) +
+              "".join(["|%X:%d" % frequency_bin for frequency_bin in record['bins']]))
+
+def main(argv) -> int:
+  if(len(argv) < 1):
+    print("Usage: sample_file_decoder.py <sample file> [<sample file> ...]")
+    return 22
+  for path in argv:
+    print_sample_file(path)
+  return 0
+
+if __name__ == "__main__":
+  sys.exit(main(sys.argv[1:]))
\ No newline at end of file